@@ -6,6 +6,18 @@
 #property version   "3.22"
 #property strict
 
+#include "IncrementalIndicators.mqh"
+#include "IndicatorCache.mqh"
+#include "TicketIndex.mqh"
+#include "PositionState.mqh"
+#include "TradeBook.mqh"
+#include "PnLLedger.mqh"
+#include "PositionProfit.mqh"
+#include "StateJournal.mqh"
+#include "VirtualPositions.mqh"
+#include "VirtualStops.mqh"
+#include "OrderExecutor.mqh"
+
 //==================== ENUMS =========================================//
 enum ENUM_EXECUTION_MODE {
    MODE_INSTANT,           // Market Execution (Standard)
@@ -20,6 +32,11 @@ input ENUM_EXECUTION_MODE ExecutionMode = MODE_INSTANT;
 input int      MaxPositions = 3;
 input int      MaxTotalPositions = 20;
 input bool     AllowMultipleSignals = true;
+// NetOrderMode books one deal, rounded to the cent once, where separate
+// orders book one each: the balance drifts by cents from the other mode,
+// enough for dynamic lots to round differently later on
+input bool     NetOrderMode = false;          // One market order per signal, MaxPositions virtual sub-positions
+input bool     UseVirtualStops = false;       // BE/trailing stops kept in the EA, entry SL stays on the server
 
 input group "=== Pending Order Settings ===";
 input double   PendingDistanceATR = 3.0;
@@ -51,6 +68,9 @@ input int      MinSignalScore = 4;            // Reduced from 5 to increase freq
 input group "=== Risk Management ===";
 input int      MagicNumber = 234000;
 input int      Slippage = 20;
+input int      EntryMaxAttempts = 4;          // Sends per market order on requotes/busy server
+input int      EntryRetryBudgetMs = 1500;     // Time allowed for the retries of an order (ms)
+input int      EntryMaxDriftPoints = 0;       // Max re-price drift from the first quote (0 = Slippage)
 input double   BreakevenOffset = 0.0001;      // Distance profit to lock in (approx 1 pip)
 input bool     UseBreakeven = true;
 input double   BE_Trigger_PctTP = 30.0;       // NEW: Move to BE at 30% of TP distance
@@ -65,6 +85,7 @@ input group "=== Advanced Settings ===";
 input int      MinBarsBetweenSignals = 3;
 input bool     ShowDebugInfo = true;
 input bool     SendNotifications = false;
+input bool     UseStateJournal = true;        // Journal BE/trailing steps, resume them after a restart
 
 input group "=== Risk / Safety Limits ===";
 input bool     EnableDailyLossStop = true;
@@ -89,9 +110,14 @@ input int      TrendEMA2 = 200;
 input bool     RequireHigherTFTrend = false;
 
 //==================== GLOBALS ======================================//
-int emaFastHandle = INVALID_HANDLE, emaSlowHandle = INVALID_HANDLE;
-int rsiHandle = INVALID_HANDLE, bbHandle = INVALID_HANDLE, macdHandle = INVALID_HANDLE;
-double emaFast[], emaSlow[], rsi[], bbUpper[], bbLower[], bbMid[], macdMain[], macdSignal[];
+// M1 indicators, updated incrementally from the bars (no CopyBuffer per tick)
+CIncBarFeed m1Feed;
+CIncEMA emaFast, emaSlow;
+CIncRSI rsi;
+CIncBands bb;
+CIncMACD macd;
+// ATR/EMA helpers read from live handles kept for the whole run
+CIndicatorCache indicatorCache;
 datetime lastBarTime = 0;
 datetime lastSignalTime = 0;
 string lastSignal = "NONE";
@@ -99,23 +125,22 @@ int lastSignalScore = 0;
 
 struct PositionInfo {
    ulong ticket;
-   string side;
-   double entryPrice;
    double lotSize;
-   double sl;
-   double tp;
    int level;
    string strength;
-   bool beMovedTo;
-   bool trailingActive;
-   double highest;
-   double lowest;
-   double trailingStart;
-   double trailingStep;
    datetime openTime;
 };
 
 PositionInfo positions[];
+CTicketIndex positionIndex;   // ticket -> positions slot
+CPositionState posState;      // prices/flags read every tick, same slots as positions[]
+CTradeBook tradeBook;         // open positions/pending orders, fed by OnTradeTransaction
+CPnLLedger pnlLedger;         // realized P/L of the account (day/week/lifetime), booked per deal
+CPositionProfit positionProfit; // net profit per position id, booked per deal
+CStateJournal journal;        // BE/trailing steps per position (aux1/aux2 = trailing start/step)
+CVirtualPositions virtualPositions; // NetOrderMode: sub-positions of the net orders, keyed in positions[]
+CVirtualStops virtualStops;   // UseVirtualStops: moved stops of the real positions
+COrderExecutor orderExecutor; // market orders: cached filling mode, requote/busy retries
 
 struct StrategySettings {
    double trailingStart;
@@ -131,54 +156,48 @@ struct Stats {
    int consecutiveLosses;
 } stats;
 
-//==================== UTIL: Array Remove ============================//
-template<typename T>
-void ArrayRemove(T &arr[], int index, int count = 1) {
-   int size = ArraySize(arr);
-   if(index < 0 || index >= size || count <= 0) return;
-   int removeCount = MathMin(count, size - index);
-   for(int i = index; i < size - removeCount; i++) arr[i] = arr[i + removeCount];
-   ArrayResize(arr, size - removeCount);
-}
-
 //==================== ON INIT ======================================//
 int OnInit() {
    if(MaxPositions < 1 || MaxPositions > 10) return(INIT_PARAMETERS_INCORRECT);
 
-   emaFastHandle = iMA(_Symbol, PERIOD_M1, EMA_Fast, 0, MODE_EMA, PRICE_CLOSE);
-   emaSlowHandle = iMA(_Symbol, PERIOD_M1, EMA_Slow, 0, MODE_EMA, PRICE_CLOSE);
-   rsiHandle = iRSI(_Symbol, PERIOD_M1, RSI_Period, PRICE_CLOSE);
-   bbHandle = iBands(_Symbol, PERIOD_M1, BB_Period, 0, BB_Deviation, PRICE_CLOSE);
-   macdHandle = iMACD(_Symbol, PERIOD_M1, MACD_Fast, MACD_Slow, MACD_Signal, PRICE_CLOSE);
-
-   if(emaFastHandle == INVALID_HANDLE || emaSlowHandle == INVALID_HANDLE ||
-      rsiHandle == INVALID_HANDLE || bbHandle == INVALID_HANDLE || macdHandle == INVALID_HANDLE) {
-      Print("ERROR: Failed to create indicators!");
-      return(INIT_FAILED);
-   }
-
-   ArrayResize(emaFast, 3); ArrayResize(emaSlow, 3);
-   ArrayResize(rsi, 3); ArrayResize(bbUpper, 3); ArrayResize(bbLower, 3); ArrayResize(bbMid, 3);
-   ArrayResize(macdMain, 3); ArrayResize(macdSignal, 3);
-
-   ArraySetAsSeries(emaFast, true); ArraySetAsSeries(emaSlow, true);
-   ArraySetAsSeries(rsi, true); ArraySetAsSeries(bbUpper, true); ArraySetAsSeries(bbLower, true);
-   ArraySetAsSeries(bbMid, true); ArraySetAsSeries(macdMain, true); ArraySetAsSeries(macdSignal, true);
+   m1Feed.Init(_Symbol, PERIOD_M1);
+   emaFast.Init(EMA_Fast); emaSlow.Init(EMA_Slow);
+   rsi.Init(RSI_Period);
+   bb.Init(BB_Period, BB_Deviation);
+   macd.Init(MACD_Fast, MACD_Slow, MACD_Signal);
+   positionIndex.Reserve(MaxTotalPositions);
+   posState.Reserve(MaxTotalPositions);
+   tradeBook.Init(_Symbol, MagicNumber, MaxTotalPositions);
+   pnlLedger.Init("SSB_" + IntegerToString(MagicNumber) + "_pnl_");
+   positionProfit.Init(MagicNumber, MaxTotalPositions);
+   virtualPositions.Init(_Symbol, MagicNumber, Slippage, MaxTotalPositions);
+   virtualStops.Init(_Symbol, MagicNumber, Slippage, MaxTotalPositions);
+   orderExecutor.Init(_Symbol, EntryMaxAttempts, EntryRetryBudgetMs, EntryMaxDriftPoints);
+   indicatorCache.Handle(_Symbol, PERIOD_M1, CACHED_ATR, ATR_Period);
+   indicatorCache.Handle(_Symbol, TrendTF1, CACHED_EMA, TrendEMA1);
+   indicatorCache.Handle(_Symbol, TrendTF2, CACHED_EMA, TrendEMA2);
 
    stats.totalSignals = 0; stats.totalTrades = 0; stats.winningTrades = 0; stats.losingTrades = 0; stats.totalProfit = 0; stats.consecutiveLosses = 0;
 
+   if(UseStateJournal) journal.Open("SSB_" + IntegerToString(MagicNumber) + "_" + _Symbol + "_journal.bin", MagicNumber, MaxTotalPositions);
    SyncPositions();
    return(INIT_SUCCEEDED);
 }
 
 //==================== ON DEINIT ====================================//
 void OnDeinit(const int reason) {
-   IndicatorRelease(emaFastHandle); IndicatorRelease(emaSlowHandle);
-   IndicatorRelease(rsiHandle); IndicatorRelease(bbHandle); IndicatorRelease(macdHandle);
+   pnlLedger.Save();
+   journal.Close();
+   if(NetOrderMode) Print("Net orders: ", virtualPositions.Opened(), " sub-positions, ", virtualPositions.Closes(), " virtual stops, ", virtualPositions.OrdersSaved(), " orders saved");
+   if(UseVirtualStops) Print("Virtual stops: ", virtualStops.Moves(), " stop moves kept off the server, ", virtualStops.Closes(), " closes, ", virtualStops.Failed(), " failed");
+   Print("Entries: ", orderExecutor.Orders(), " sent, ", orderExecutor.Filled(), " filled (", orderExecutor.Retried(), " after a retry), ", orderExecutor.Failed(), " missed, ", DoubleToString(orderExecutor.AvgAttempts(), 2), " attempts and ", DoubleToString(orderExecutor.AvgMs(), 0), " ms avg, ", orderExecutor.MaxMs(), " ms max, ", orderExecutor.Requotes(), " requotes, ", orderExecutor.Busy(), " busy, ", orderExecutor.Drifted(), " drifted away");
+   Print("Indicator cache: ", indicatorCache.Created(), " handles created, ", indicatorCache.Reused(), " creations avoided");
+   indicatorCache.Release();
 }
 
 //==================== ON TICK ======================================//
 void OnTick() {
+   journal.Tick();
    datetime currentBarTime = iTime(_Symbol, PERIOD_M1, 0);
    bool isNewBar = (currentBarTime != lastBarTime);
    if(!isNewBar) {
@@ -189,7 +208,7 @@ void OnTick() {
 
    if(!UpdateIndicators()) return;
 
-   SyncPositions();
+   if(tradeBook.ReconcileDue()) SyncPositions();
 
    if(!IsTradingSession()) { UpdateDisplay(); return; }
 
@@ -229,69 +248,126 @@ void OnTick() {
 
 //==================== UPDATE INDICATORS ============================//
 bool UpdateIndicators() {
-   if(CopyBuffer(emaFastHandle, 0, 0, 3, emaFast) <= 0) return false;
-   if(CopyBuffer(emaSlowHandle, 0, 0, 3, emaSlow) <= 0) return false;
-   if(CopyBuffer(rsiHandle, 0, 0, 3, rsi) <= 0) return false;
-   if(CopyBuffer(bbHandle, 1, 0, 3, bbUpper) <= 0) return false;
-   if(CopyBuffer(bbHandle, 2, 0, 3, bbLower) <= 0) return false;
-   if(CopyBuffer(bbHandle, 0, 0, 3, bbMid) <= 0) return false;
-   if(CopyBuffer(macdHandle, 0, 0, 3, macdMain) <= 0) return false;
-   if(CopyBuffer(macdHandle, 1, 0, 3, macdSignal) <= 0) return false;
+   int added = m1Feed.Sync();
+   if(added < 0) return false;
+   if(m1Feed.Restarted()) { emaFast.Reset(); emaSlow.Reset(); rsi.Reset(); bb.Reset(); macd.Reset(); }
+   for(int i = 0; i < added; i++) {
+      MqlRates bar = m1Feed.Bar(i);
+      emaFast.Push(bar); emaSlow.Push(bar); rsi.Push(bar); bb.Push(bar); macd.Push(bar);
+   }
+   MqlRates forming = m1Feed.Forming();
+   emaFast.Forming(forming); emaSlow.Forming(forming); rsi.Forming(forming); bb.Forming(forming); macd.Forming(forming);
    return true;
 }
 
+//==================== TRADE EVENTS =================================//
+// Positions are added and booked here as the deals arrive; SyncPositions
+// is only the periodic safety net
+void OnTradeTransaction(const MqlTradeTransaction &trans, const MqlTradeRequest &request, const MqlTradeResult &result) {
+   if(trans.type == TRADE_TRANSACTION_DEAL_ADD) { pnlLedger.Book(trans.deal); pnlLedger.Save(); positionProfit.OnDeal(trans.deal); }
+   ulong closed = tradeBook.OnTransaction(trans);
+   if(closed > 0) {
+      int slot = positionIndex.Find(closed);
+      if(slot >= 0) BookClosedPosition(slot);
+      else if(virtualPositions.Has(closed)) BookClosedNetPosition(closed);
+   }
+   else if(trans.type == TRADE_TRANSACTION_DEAL_ADD) {
+      // Filled pending orders and trades not opened by OpenSmartPositions
+      if(tradeBook.HasPosition(trans.position) && positionIndex.Find(trans.position) < 0 && !virtualPositions.Has(trans.position) &&
+         PositionSelectByTicket(trans.position))
+         TrackPosition(trans.position);
+   }
+   else if(trans.type == TRADE_TRANSACTION_POSITION) {
+      int slot = positionIndex.Find(trans.position);
+      if(slot >= 0) { posState.sl[slot] = virtualStops.Stop(trans.position, trans.price_sl); posState.tp[slot] = trans.price_tp; }
+   }
+}
+
+void BookClosedPosition(int slot) {
+   BookResult(slot, positionProfit.Take(positions[slot].ticket));
+}
+
+// The net position behind sub-positions is gone: its result beyond the
+// subs' partial closes is shared by the subs still open
+void BookClosedNetPosition(ulong ticket) {
+   int subs;
+   double rest = virtualPositions.Settle(ticket, positionProfit.Take(ticket), subs);
+   if(subs == 0) { stats.totalProfit += rest; return; }
+   for(int i = ArraySize(positions)-1; i >= 0; i--) {
+      if(virtualPositions.Position(positions[i].ticket) == ticket) BookResult(i, rest / subs);
+   }
+}
+
+void BookResult(int slot, double profit) {
+   stats.totalProfit += profit;
+   if(profit > 0) { stats.winningTrades++; stats.consecutiveLosses = 0; }
+   else if(profit < 0) { stats.losingTrades++; stats.consecutiveLosses++; }
+   journal.Remove(positions[slot].ticket);
+   virtualStops.Remove(positions[slot].ticket);
+   positionIndex.RemoveAt(positions, slot);
+   posState.RemoveAt(slot);
+}
+
+// Track the selected position with default settings
+void TrackPosition(ulong ticket) {
+   int size = positionIndex.Add(positions, ticket);
+   positions[size].lotSize = PositionGetDouble(POSITION_VOLUME);
+   positions[size].level = 1;
+   positions[size].strength = "UNKNOWN";
+   positions[size].openTime = (datetime)PositionGetInteger(POSITION_TIME);
+   posState.Add((PositionGetInteger(POSITION_TYPE) == POSITION_TYPE_BUY) ? POSITION_SIDE_BUY : POSITION_SIDE_SELL,
+                PositionGetDouble(POSITION_PRICE_OPEN), PositionGetDouble(POSITION_SL), PositionGetDouble(POSITION_TP));
+   posState.trailingStart[size] = 0.0005; // Default fallback
+   posState.trailingStep[size] = 0.0002;
+   // Resume the BE/trailing state journaled by an earlier run
+   StateJournalRecord record;
+   if(journal.Find(ticket, record)) {
+      posState.flags[size] = record.flags;
+      posState.trailingStart[size] = record.aux1;
+      posState.trailingStep[size] = record.aux2;
+      // the journal has the stop last moved in memory
+      if(UseVirtualStops && (record.flags & POSITION_STATE_BE) != 0) {
+         posState.sl[size] = record.sl;
+         virtualStops.Set(ticket, posState.side[size] == POSITION_SIDE_BUY, record.sl);
+      }
+   }
+   else JournalStep(size, JOURNAL_OPEN);
+}
+
+// Journal one step of the position in "slot" (absolute state after it);
+// sub-positions are not journaled, a restart resumes their net position
+void JournalStep(int slot, int event) {
+   if(virtualPositions.IsVirtual(positions[slot].ticket)) return;
+   journal.Append(positions[slot].ticket, event, posState.flags[slot], positions[slot].lotSize,
+                  posState.sl[slot], posState.tp[slot], posState.trailingStart[slot], posState.trailingStep[slot]);
+}
+
 //==================== SYNC POSITIONS ================================//
 void SyncPositions() {
    for(int i = ArraySize(positions)-1; i >= 0; i--) {
-      if(!PositionSelectByTicket(positions[i].ticket)) {
-         double profit = 0;
-         if(HistorySelectByPosition(positions[i].ticket)) {
-            for(int j = HistoryDealsTotal() - 1; j >= 0; j--) {
-               ulong dealTicket = HistoryDealGetTicket(j);
-               if(HistoryDealGetInteger(dealTicket, DEAL_POSITION_ID) == positions[i].ticket)
-                  profit += HistoryDealGetDouble(dealTicket, DEAL_PROFIT);
-            }
-         }
-         stats.totalProfit += profit;
-         if(profit > 0) { stats.winningTrades++; stats.consecutiveLosses = 0; }
-         else if(profit < 0) { stats.losingTrades++; stats.consecutiveLosses++; }
-         ArrayRemove(positions, i, 1);
-      }
+      if(i >= ArraySize(positions) || PositionSelectByTicket(PositionTicket(i))) continue;
+      if(virtualPositions.IsVirtual(positions[i].ticket)) BookClosedNetPosition(PositionTicket(i));
+      else BookClosedPosition(i);
    }
 
    for(int i = PositionsTotal()-1; i >= 0; i--) {
       ulong ticket = PositionGetTicket(i);
       if(ticket > 0 && PositionGetString(POSITION_SYMBOL) == _Symbol && PositionGetInteger(POSITION_MAGIC) == MagicNumber) {
-         bool found = false;
-         for(int j = 0; j < ArraySize(positions); j++) {
-            if(positions[j].ticket == ticket) {
-               found = true;
-               positions[j].sl = PositionGetDouble(POSITION_SL);
-               positions[j].tp = PositionGetDouble(POSITION_TP);
-               break;
-            }
-         }
-         if(!found) {
-            int size = ArraySize(positions);
-            ArrayResize(positions, size + 1);
-            positions[size].ticket = ticket;
-            positions[size].side = (PositionGetInteger(POSITION_TYPE) == POSITION_TYPE_BUY) ? "BUY" : "SELL";
-            positions[size].entryPrice = PositionGetDouble(POSITION_PRICE_OPEN);
-            positions[size].lotSize = PositionGetDouble(POSITION_VOLUME);
-            positions[size].sl = PositionGetDouble(POSITION_SL);
-            positions[size].tp = PositionGetDouble(POSITION_TP);
-            positions[size].level = 1;
-            positions[size].strength = "UNKNOWN";
-            positions[size].beMovedTo = false;
-            positions[size].trailingActive = false;
-            positions[size].highest = positions[size].entryPrice;
-            positions[size].lowest = positions[size].entryPrice;
-            positions[size].trailingStart = 0.0005; // Default fallback
-            positions[size].trailingStep = 0.0002;
-            positions[size].openTime = (datetime)PositionGetInteger(POSITION_TIME);
+         if(virtualPositions.Has(ticket)) continue; // its subs' stops are virtual
+         int j = positionIndex.Find(ticket);
+         if(j >= 0) {
+            posState.sl[j] = virtualStops.Stop(ticket, PositionGetDouble(POSITION_SL));
+            posState.tp[j] = PositionGetDouble(POSITION_TP);
          }
+         else TrackPosition(ticket);
       }
    }
+   tradeBook.Reconcile();
+}
+
+// Real ticket of the position in "slot" (the net position of a sub-position)
+ulong PositionTicket(int slot) {
+   return virtualPositions.Position(positions[slot].ticket);
 }
 
 //==================== SESSION CHECK ================================//
@@ -319,14 +395,14 @@ void AnalyzeSignal(string &signal, string &strength, int &score) {
    if(rsi[0] < RSI_Oversold) buyScore += 2; else if(rsi[0] > RSI_Overbought) sellScore += 2;
 
    // 4. BB
-   double bbW = bbUpper[0] - bbLower[0];
+   double bbW = bb.Upper(0) - bb.Lower(0);
    if(bbW > 0) {
-      if((iClose(_Symbol,PERIOD_M1,0)-bbLower[0])/bbW < 0.3) buyScore += 2;
-      else if((bbUpper[0]-iClose(_Symbol,PERIOD_M1,0))/bbW < 0.3) sellScore += 2;
+      if((iClose(_Symbol,PERIOD_M1,0)-bb.Lower(0))/bbW < 0.3) buyScore += 2;
+      else if((bb.Upper(0)-iClose(_Symbol,PERIOD_M1,0))/bbW < 0.3) sellScore += 2;
    }
 
    // 5. MACD
-   if(macdMain[0] > macdSignal[0]) buyScore += 1; else sellScore += 1;
+   if(macd.Main(0) > macd.Signal(0)) buyScore += 1; else sellScore += 1;
 
    // ATR & HTF Filter
    double atr = GetATR(PERIOD_M1, ATR_Period);
@@ -378,7 +454,10 @@ void OpenSmartPositions(string signal, string strength, int score) {
 
    int positionsToOpen = (ExecutionMode == MODE_HYBRID_LIMIT) ? 1 : MaxPositions;
 
-   if(ExecutionMode == MODE_INSTANT || ExecutionMode == MODE_HYBRID_LIMIT) {
+   if(NetOrderMode && positionsToOpen > 1 && ExecutionMode == MODE_INSTANT) {
+      OpenNetPosition(signal, strength, score, lotToTrade, slDist, tpDist, positionsToOpen, strat);
+   }
+   else if(ExecutionMode == MODE_INSTANT || ExecutionMode == MODE_HYBRID_LIMIT) {
       for(int i=0; i<positionsToOpen; i++) {
          double price = (signal=="BUY")?SymbolInfoDouble(_Symbol,SYMBOL_ASK):SymbolInfoDouble(_Symbol,SYMBOL_BID);
          double sl = (signal=="BUY") ? price - slDist : price + slDist;
@@ -425,23 +504,35 @@ void OpenSmartPositions(string signal, string strength, int score) {
    }
 }
 
+// NetOrderMode: one order for all levels, each level a sub-position of it
+void OpenNetPosition(string signal, string strength, int score, double lot, double slDist, double tpDist, int levels, StrategySettings &strat) {
+   double price = (signal=="BUY")?SymbolInfoDouble(_Symbol,SYMBOL_ASK):SymbolInfoDouble(_Symbol,SYMBOL_BID);
+   double sl = (signal=="BUY") ? price - slDist : price + slDist;
+   double tp = (signal=="BUY") ? price + tpDist : price - tpDist;
+   if(!ValidateStops(price, sl, tp, signal)) return;
+
+   int subs = levels;
+   double volume = virtualPositions.NetVolume(lot, subs);
+   string comment = StringFormat("%s%d-%s-Net%d", StringSubstr(strength,0,1), score, signal, subs);
+   ulong ticket = OpenOrder(signal, volume, sl, tp, comment);
+   if(ticket == 0) return;
+
+   for(int i=0; i<subs; i++)
+      AddToPositionStruct(virtualPositions.Key(ticket, i+1), signal, price, lot, sl, tp, strength, i+1, strat);
+   virtualPositions.Open(ticket, subs);
+   Print("✓ Net Trade Opened #", ticket, " ", DoubleToString(volume, 2), " lots = ", subs, " x ", DoubleToString(lot, 2));
+}
+
 void AddToPositionStruct(ulong ticket, string side, double price, double lot, double sl, double tp, string strength, int level, StrategySettings &strat) {
-   int size = ArraySize(positions);
-   ArrayResize(positions, size + 1);
-   positions[size].ticket = ticket;
-   positions[size].side = side;
-   positions[size].entryPrice = price;
+   int size = positionIndex.Add(positions, ticket);
    positions[size].lotSize = lot;
-   positions[size].sl = sl;
-   positions[size].tp = tp;
    positions[size].level = level;
    positions[size].strength = strength;
-   positions[size].beMovedTo = false;
-   positions[size].highest = price;
-   positions[size].lowest = price;
-   positions[size].trailingStart = strat.trailingStart;
-   positions[size].trailingStep = strat.trailingStep;
    positions[size].openTime = TimeCurrent();
+   posState.Add(side == "BUY" ? POSITION_SIDE_BUY : POSITION_SIDE_SELL, price, sl, tp);
+   posState.trailingStart[size] = strat.trailingStart;
+   posState.trailingStep[size] = strat.trailingStep;
+   JournalStep(size, JOURNAL_OPEN);
 }
 
 //==================== OPEN MARKET ORDER ============================//
@@ -455,7 +546,7 @@ ulong OpenOrder(string side, double lot, double sl, double tp, string comment) {
    request.price = (side == "BUY") ? SymbolInfoDouble(_Symbol,SYMBOL_ASK) : SymbolInfoDouble(_Symbol,SYMBOL_BID);
    request.sl = sl; request.tp = tp; request.deviation = Slippage; request.magic = MagicNumber; request.comment = comment;
 
-   if(!OrderSend(request, result)) return 0;
+   if(!orderExecutor.Send(request, result)) return 0;
    return result.order;
 }
 
@@ -548,63 +639,87 @@ bool ValidateStops(double entryPrice, double &sl, double &tp, string side) {
 
 //==================== MANAGE POSITIONS (UPDATED) ====================//
 void ManagePositions() {
-   for(int i = ArraySize(positions)-1; i >= 0; i--) {
-      if(!PositionSelectByTicket(positions[i].ticket)) continue;
-
-      double currentPrice = (positions[i].side == "BUY") ? SymbolInfoDouble(_Symbol,SYMBOL_BID) : SymbolInfoDouble(_Symbol,SYMBOL_ASK);
-
-      // Track High/Low
-      if(positions[i].side == "BUY") { if(currentPrice > positions[i].highest) positions[i].highest = currentPrice; }
-      else { if(currentPrice < positions[i].lowest) positions[i].lowest = currentPrice; }
-
-      double profitPct = 0;
-      double currentProfitDist = 0;
-      double totalTPDist = MathAbs(positions[i].tp - positions[i].entryPrice);
-
-      if(positions[i].side == "BUY") {
-         profitPct = (currentPrice - positions[i].entryPrice) / positions[i].entryPrice;
-         currentProfitDist = currentPrice - positions[i].entryPrice;
-      }
-      else {
-         profitPct = (positions[i].entryPrice - currentPrice) / positions[i].entryPrice;
-         currentProfitDist = positions[i].entryPrice - currentPrice;
-      }
+   // One pass over the per-tick state; only positions due a breakeven or
+   // trailing move are selected and modified below.
+   posState.Update(SymbolInfoDouble(_Symbol,SYMBOL_BID), SymbolInfoDouble(_Symbol,SYMBOL_ASK));
+   if(virtualPositions.Subs() > 0) CheckVirtualStops();
+   if(virtualStops.Count() > 0) virtualStops.Check(SymbolInfoDouble(_Symbol,SYMBOL_BID), SymbolInfoDouble(_Symbol,SYMBOL_ASK));
+   double beFraction = BE_Trigger_PctTP / 100.0;
+
+   for(int i = posState.Count()-1; i >= 0; i--) {
+      double entry = posState.entry[i];
+      double currentProfitDist = posState.move[i];
+      double profitPct = currentProfitDist / entry;
+      double totalTPDist = MathAbs(posState.tp[i] - entry);
+      bool beDue = UseBreakeven && !posState.Has(i, POSITION_STATE_BE) && totalTPDist > 0 &&
+                   currentProfitDist >= (totalTPDist * beFraction);
+      bool trailDue = UseTrailing && (beDue || posState.Has(i, POSITION_STATE_BE)) && profitPct >= posState.trailingStart[i];
+      if(!beDue && !trailDue) continue;
+      if(!PositionSelectByTicket(PositionTicket(i))) continue;
+
+      bool buy = (posState.side[i] == POSITION_SIDE_BUY);
 
       // --- NEW BREAKEVEN LOGIC (30% of TP) ---
       // We check if current profit distance > (Total TP Distance * Percentage)
-      if(UseBreakeven && !positions[i].beMovedTo && totalTPDist > 0) {
-         if(currentProfitDist >= (totalTPDist * (BE_Trigger_PctTP / 100.0))) {
-            double newSL = (positions[i].side == "BUY") ? positions[i].entryPrice + BreakevenOffset : positions[i].entryPrice - BreakevenOffset;
-            newSL = NormalizeDouble(newSL, _Digits);
-
-            if(ModifyPosition(positions[i].ticket, newSL, positions[i].tp)) {
-               positions[i].sl = newSL;
-               positions[i].beMovedTo = true;
-               Print("Locked BE for Ticket ", positions[i].ticket, " at 30% TP progress.");
-            }
+      if(beDue) {
+         double newSL = buy ? entry + BreakevenOffset : entry - BreakevenOffset;
+         newSL = NormalizeDouble(newSL, _Digits);
+
+         if(MoveStop(i, newSL)) {
+            posState.sl[i] = newSL;
+            posState.flags[i] |= POSITION_STATE_BE;
+            JournalStep(i, JOURNAL_BREAKEVEN);
+            Print("Locked BE for Ticket ", PositionTicket(i), " at 30% TP progress.");
          }
       }
 
       // Trailing
-      if(UseTrailing && positions[i].beMovedTo && profitPct >= positions[i].trailingStart) {
+      if(UseTrailing && posState.Has(i, POSITION_STATE_BE) && profitPct >= posState.trailingStart[i]) {
          double trailingSL;
-         if(positions[i].side == "BUY") {
-            trailingSL = positions[i].highest * (1 - positions[i].trailingStep);
+         if(buy) {
+            trailingSL = posState.highest[i] * (1 - posState.trailingStep[i]);
             trailingSL = NormalizeDouble(trailingSL, _Digits);
-            if(trailingSL > positions[i].sl + (_Point*5)) {
-               if(ModifyPosition(positions[i].ticket, trailingSL, positions[i].tp)) positions[i].sl = trailingSL;
+            if(trailingSL > posState.sl[i] + (_Point*5)) {
+               if(MoveStop(i, trailingSL)) { posState.sl[i] = trailingSL; JournalStep(i, JOURNAL_TRAILING); }
             }
          } else {
-            trailingSL = positions[i].lowest * (1 + positions[i].trailingStep);
+            trailingSL = posState.lowest[i] * (1 + posState.trailingStep[i]);
             trailingSL = NormalizeDouble(trailingSL, _Digits);
-            if(trailingSL < positions[i].sl - (_Point*5)) {
-               if(ModifyPosition(positions[i].ticket, trailingSL, positions[i].tp)) positions[i].sl = trailingSL;
+            if(trailingSL < posState.sl[i] - (_Point*5)) {
+               if(MoveStop(i, trailingSL)) { posState.sl[i] = trailingSL; JournalStep(i, JOURNAL_TRAILING); }
             }
          }
       }
    }
 }
 
+// Sub-positions whose virtual stop or target was reached are closed off
+// their net position
+void CheckVirtualStops() {
+   double bid = SymbolInfoDouble(_Symbol,SYMBOL_BID), ask = SymbolInfoDouble(_Symbol,SYMBOL_ASK);
+   for(int i = posState.Count()-1; i >= 0; i--) {
+      if(virtualPositions.IsVirtual(positions[i].ticket) &&
+         virtualPositions.Hit(posState.side[i], bid, ask, posState.sl[i], posState.tp[i]))
+         virtualPositions.MarkHit(i, positions[i].ticket, positions[i].lotSize);
+   }
+   int slots[];
+   double profits[];
+   int closed = virtualPositions.CloseHits(slots, profits);
+   for(int h = 0; h < closed; h++) {
+      Print("Virtual stop L", positions[slots[h]].level, " of #", PositionTicket(slots[h]), " closed, P/L ", DoubleToString(profits[h], 2));
+      BookResult(slots[h], profits[h]);
+   }
+}
+
+// Move the stop of "slot": on the server, or in memory for a sub-position
+// and, with UseVirtualStops, for every position
+bool MoveStop(int slot, double sl) {
+   if(virtualPositions.IsVirtual(positions[slot].ticket))
+      return virtualPositions.StopAllowed(posState.side[slot], sl, posState.tp[slot], posState.sl[slot]);
+   if(UseVirtualStops) { virtualStops.Set(positions[slot].ticket, posState.side[slot] == POSITION_SIDE_BUY, sl); return true; }
+   return ModifyPosition(positions[slot].ticket, sl, posState.tp[slot]);
+}
+
 bool ModifyPosition(ulong ticket, double sl, double tp) {
    if(!PositionSelectByTicket(ticket)) return false;
    MqlTradeRequest request; MqlTradeResult result; ZeroMemory(request); ZeroMemory(result);
@@ -616,14 +731,8 @@ bool ModifyPosition(ulong ticket, double sl, double tp) {
 
 //==================== COUNT ========================================//
 int CountTotalExposure() {
-   int count = 0;
-   for(int i=PositionsTotal()-1;i>=0;i--) {
-      if(PositionGetTicket(i)>0 && PositionGetString(POSITION_SYMBOL)==_Symbol && PositionGetInteger(POSITION_MAGIC)==MagicNumber) count++;
-   }
-   for(int i=OrdersTotal()-1;i>=0;i--) {
-      if(OrderGetTicket(i)>0 && OrderGetString(ORDER_SYMBOL)==_Symbol && OrderGetInteger(ORDER_MAGIC)==MagicNumber) count++;
-   }
-   return count;
+   // a net position counts as its sub-positions
+   return tradeBook.Exposure() - virtualPositions.Count() + virtualPositions.Subs();
 }
 
 //==================== DISPLAY INFO ================================//
@@ -633,7 +742,9 @@ void UpdateDisplay() {
    int openPos = CountTotalExposure();
    double currentProfit=0;
    for(int i=0;i<ArraySize(positions);i++) {
-      if(PositionSelectByTicket(positions[i].ticket)) currentProfit += PositionGetDouble(POSITION_PROFIT);
+      if(!PositionSelectByTicket(PositionTicket(i))) continue;
+      double share = virtualPositions.IsVirtual(positions[i].ticket) ? positions[i].lotSize / PositionGetDouble(POSITION_VOLUME) : 1.0;
+      currentProfit += PositionGetDouble(POSITION_PROFIT) * share;
    }
 
    double balance = AccountInfoDouble(ACCOUNT_BALANCE);
@@ -641,38 +752,23 @@ void UpdateDisplay() {
    if(balance < BalanceThreshold) currentLimit = FixedLossBelowThreshold;
    else currentLimit = balance * (PctLossAboveThreshold/100.0);
 
-   double dailyProfit = 0;
-   datetime start = (datetime)(TimeCurrent() - (TimeCurrent() % 86400));
-   if(HistorySelect(start, TimeCurrent())) {
-      for(int i=0; i<HistoryDealsTotal(); i++) {
-         ulong ticket = HistoryDealGetTicket(i);
-         dailyProfit += HistoryDealGetDouble(ticket, DEAL_PROFIT);
-         dailyProfit += HistoryDealGetDouble(ticket, DEAL_SWAP);
-         dailyProfit += HistoryDealGetDouble(ticket, DEAL_COMMISSION);
-      }
-   }
+   double dailyProfit = pnlLedger.Daily();
 
    string info = StringFormat(
-      "SMART SCALPING BOT v3.22 (Dynamic BE)\nMode: %s\nTime: %02d:%02d UTC+7\nPrice: %.5f\nPositions: %d / %d\nLast Signal: %s\nCurrent Open P/L: $%.2f\nTotal History P/L: $%.2f\n\nDaily P/L: $%.2f\nDaily Limit: -$%.2f\nBE Trigger: %.0f%% of TP",
+      "SMART SCALPING BOT v3.22 (Dynamic BE)\nMode: %s\nTime: %02d:%02d UTC+7\nPrice: %.5f\nPositions: %d / %d\nLast Signal: %s\nCurrent Open P/L: $%.2f\nTotal History P/L: $%.2f\n\nDaily P/L: $%.2f\nWeekly P/L: $%.2f\nDaily Limit: -$%.2f\nBE Trigger: %.0f%% of TP",
       EnumToString(ExecutionMode), dt.hour, dt.min, price, openPos, MaxTotalPositions,
-      lastSignal, currentProfit, stats.totalProfit, dailyProfit, currentLimit, BE_Trigger_PctTP
+      lastSignal, currentProfit, stats.totalProfit, dailyProfit, pnlLedger.Weekly(), currentLimit, BE_Trigger_PctTP
    );
    Comment(info);
 }
 
 //==================== UTILS ========================================//
 double GetATR(ENUM_TIMEFRAMES tf, int period) {
-   int handle = iATR(_Symbol, tf, period);
-   double buffer[]; ArrayResize(buffer,1);
-   if(CopyBuffer(handle,0,0,1,buffer) <= 0) { IndicatorRelease(handle); return 0.0; }
-   IndicatorRelease(handle); return buffer[0];
+   return indicatorCache.Value(_Symbol, tf, CACHED_ATR, period);
 }
 
 double GetEMA(ENUM_TIMEFRAMES tf, int period) {
-   int h = iMA(_Symbol, tf, period, 0, MODE_EMA, PRICE_CLOSE);
-   double buf[]; ArrayResize(buf,1);
-   if(CopyBuffer(h,0,0,1,buf) <= 0) { IndicatorRelease(h); return 0.0; }
-   IndicatorRelease(h); return buf[0];
+   return indicatorCache.Value(_Symbol, tf, CACHED_EMA, period);
 }
 
 int GetHigherTFTrend() {
@@ -715,16 +811,7 @@ bool CheckEquityStop() {
 }
 
 bool CheckDailyLossStop() {
-   double profit = 0;
-   datetime start = (datetime)(TimeCurrent() - (TimeCurrent() % 86400));
-   if(HistorySelect(start, TimeCurrent())) {
-      for(int i=0; i<HistoryDealsTotal(); i++) {
-         ulong ticket = HistoryDealGetTicket(i);
-         profit += HistoryDealGetDouble(ticket, DEAL_PROFIT);
-         profit += HistoryDealGetDouble(ticket, DEAL_SWAP);
-         profit += HistoryDealGetDouble(ticket, DEAL_COMMISSION);
-      }
-   }
+   double profit = pnlLedger.Daily();
    double balance = AccountInfoDouble(ACCOUNT_BALANCE);
    double currentLimit = 0.0;
    if(balance < BalanceThreshold) {
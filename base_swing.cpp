@@ -7,6 +7,10 @@
 #property version   "1.00"
 #property strict
 
+#include "TicketIndex.mqh"
+#include "StopScheduler.mqh"
+#include "OrderExecutor.mqh"
+
 //==================== INPUT PARAMETERS ==============================//
 input group "=== AGGRESSIVE RISK SETTINGS ===";
 input double   RiskPercentPerSignal = 50.0;    // Risk % Per Signal (50% = EXTREME RISK!)
@@ -39,6 +43,12 @@ input bool     UseTrailingStop = true;         // Enable Trailing Stop
 input double   TrailingStopATR = 1.5;          // Trailing Stop ATR Multiplier
 input bool     UseBreakeven = true;            // Move to Breakeven
 input double   BreakevenTriggerATR = 1.0;      // Breakeven Trigger (ATR x)
+input double   TrailingMinStepATR = 0.1;       // Min Trailing Stop Move (ATR x)
+input int      TrailingMinStepPoints = 0;      // Min Trailing Stop Move (points)
+input int      MaxStopModsPerSecond = 1;       // Max SL/TP Changes per Position per Second (0 = no limit)
+input int      EntryMaxAttempts = 4;           // Sends per Entry on Requotes/Busy Server
+input int      EntryRetryBudgetMs = 1500;      // Time Allowed for the Retries of an Entry (ms)
+input int      EntryMaxDriftPoints = 0;        // Max Re-price Drift from the First Quote (0 = slippage)
 input int      MagicNumber = 888999;           // Magic Number
 input bool     OneSignalAtATime = true;        // Only 1 signal active at a time
 
@@ -65,6 +75,9 @@ struct PositionData {
    double lowestPrice;
 };
 PositionData activePositions[];
+CTicketIndex positionIndex;   // ticket -> activePositions slot
+CStopScheduler stopScheduler; // SL/TP modifications: minimum step, per-ticket rate limit
+COrderExecutor orderExecutor; // entries: cached filling mode, requote/busy retries
 
 //==================== ON INIT ======================================//
 int OnInit() {
@@ -99,6 +112,8 @@ int OnInit() {
    ArraySetAsSeries(emaTrend, true); ArraySetAsSeries(rsi, true);
    ArraySetAsSeries(adxMain, true);
 
+   stopScheduler.Init(_Symbol, MagicNumber, MaxStopModsPerSecond, MaxPositionsPerSignal);
+   orderExecutor.Init(_Symbol, EntryMaxAttempts, EntryRetryBudgetMs, EntryMaxDriftPoints);
    SyncPositions();
 
    botStatus = "READY - Scanning for signals...";
@@ -110,6 +125,13 @@ int OnInit() {
 //==================== ON DEINIT ====================================//
 void OnDeinit(const int reason) {
    Print("🛑 DEINIT: Bot stopping. Reason code: ", reason);
+   Print("📊 STOP MODIFICATIONS: ", stopScheduler.Requested(), " requested, ", stopScheduler.Sent(), " sent, ",
+         stopScheduler.Suppressed(), " suppressed (", stopScheduler.BelowStep(), " below min step, ",
+         stopScheduler.Coalesced(), " coalesced), ", stopScheduler.Failed(), " failed");
+   Print("📊 ENTRIES: ", orderExecutor.Orders(), " sent, ", orderExecutor.Filled(), " filled (", orderExecutor.Retried(),
+         " after a retry), ", orderExecutor.Failed(), " missed | ", DoubleToString(orderExecutor.AvgAttempts(), 2),
+         " attempts and ", DoubleToString(orderExecutor.AvgMs(), 0), " ms avg, ", orderExecutor.MaxMs(), " ms max | ",
+         orderExecutor.Requotes(), " requotes, ", orderExecutor.Busy(), " busy, ", orderExecutor.Drifted(), " drifted away");
    IndicatorRelease(emaFastHandle);
    IndicatorRelease(emaSlowHandle);
    IndicatorRelease(emaTrendHandle);
@@ -422,9 +444,8 @@ ulong OpenMarketOrder(string side, double lot, double sl, double tp, string comm
    request.deviation = 50;
    request.magic = MagicNumber;
    request.comment = comment;
-   request.type_filling = ORDER_FILLING_IOC;
 
-   if(!OrderSend(request, result)) {
+   if(!orderExecutor.Send(request, result)) {
       Print("❌ OrderSend Failed: ", result.retcode, " - ", result.comment);
       return 0;
    }
@@ -438,7 +459,8 @@ void SyncPositions() {
    for(int i = ArraySize(activePositions) - 1; i >= 0; i--) {
       if(!PositionSelectByTicket(activePositions[i].ticket)) {
          Print("ℹ️ SYNC: Position #", activePositions[i].ticket, " is no longer active. Removing from list.");
-         ArrayRemove(activePositions, i);
+         stopScheduler.Forget(activePositions[i].ticket);
+         positionIndex.RemoveAt(activePositions, i);
          if(ArraySize(activePositions) == 0) {
             currentSignal = "NONE";
             botStatus = "POSITION CLOSED - Scanning for new signals...";
@@ -454,19 +476,9 @@ void SyncPositions() {
       if(ticket > 0 && PositionGetString(POSITION_SYMBOL) == _Symbol &&
          PositionGetInteger(POSITION_MAGIC) == MagicNumber) {
 
-         bool found = false;
-         for(int j = 0; j < ArraySize(activePositions); j++) {
-            if(activePositions[j].ticket == ticket) {
-               found = true;
-               break;
-            }
-         }
-
-         if(!found) {
+         if(positionIndex.Find(ticket) < 0) {
             Print("ℹ️ SYNC: Found new existing position #", ticket);
-            int size = ArraySize(activePositions);
-            ArrayResize(activePositions, size + 1);
-            activePositions[size].ticket = ticket;
+            int size = positionIndex.Add(activePositions, ticket);
             activePositions[size].type = (PositionGetInteger(POSITION_TYPE) == POSITION_TYPE_BUY) ? "BUY" : "SELL";
             activePositions[size].entryPrice = PositionGetDouble(POSITION_PRICE_OPEN);
             activePositions[size].sl = PositionGetDouble(POSITION_SL);
@@ -486,8 +498,14 @@ void ManageOpenPositions() {
 
    double atr = atrBuffer[0];
 
+   // Trailing stops held back by the rate limit go out once allowed
+   stopScheduler.SetMinStep(MathMax(TrailingMinStepPoints * _Point, atr * TrailingMinStepATR));
+   stopScheduler.Flush();
+
    for(int i = 0; i < ArraySize(activePositions); i++) {
       if(!PositionSelectByTicket(activePositions[i].ticket)) continue;
+      // The stop on the server, which a held modification may have moved since
+      activePositions[i].sl = PositionGetDouble(POSITION_SL);
 
       double currentPrice = (activePositions[i].type == "BUY") ?
          SymbolInfoDouble(_Symbol, SYMBOL_BID) :
@@ -529,7 +547,7 @@ void ManageOpenPositions() {
 
          if(shouldMoveBE) {
             double newSL = activePositions[i].entryPrice;
-            if(ModifyPosition(activePositions[i].ticket, newSL, activePositions[i].tp)) {
+            if(stopScheduler.Modify(activePositions[i].ticket, newSL, activePositions[i].tp, true)) {
                activePositions[i].sl = newSL;
                activePositions[i].beActive = true;
                Print("═══════════════════════════════════════");
@@ -550,7 +568,7 @@ void ManageOpenPositions() {
          if(activePositions[i].type == "BUY") {
             newSL = activePositions[i].highestPrice - trailDistance;
             if(newSL > activePositions[i].sl) {
-               if(ModifyPosition(activePositions[i].ticket, newSL, activePositions[i].tp)) {
+               if(stopScheduler.Modify(activePositions[i].ticket, newSL, activePositions[i].tp)) {
                   Print("📊 Trailing Stop Updated for #", activePositions[i].ticket, ": ", activePositions[i].sl, " → ", newSL);
                   activePositions[i].sl = newSL;
                   botStatus = "📊 TRAILING STOP ACTIVE";
@@ -559,7 +577,7 @@ void ManageOpenPositions() {
          } else {
             newSL = activePositions[i].lowestPrice + trailDistance;
             if(newSL < activePositions[i].sl) {
-               if(ModifyPosition(activePositions[i].ticket, newSL, activePositions[i].tp)) {
+               if(stopScheduler.Modify(activePositions[i].ticket, newSL, activePositions[i].tp)) {
                   Print("📊 Trailing Stop Updated for #", activePositions[i].ticket, ": ", activePositions[i].sl, " → ", newSL);
                   activePositions[i].sl = newSL;
                   botStatus = "📊 TRAILING STOP ACTIVE";
@@ -570,27 +588,6 @@ void ManageOpenPositions() {
    }
 }
 
-//==================== MODIFY POSITION ==============================//
-bool ModifyPosition(ulong ticket, double sl, double tp) {
-   MqlTradeRequest request;
-   MqlTradeResult result;
-   ZeroMemory(request);
-   ZeroMemory(result);
-
-   request.action = TRADE_ACTION_SLTP;
-   request.symbol = _Symbol;
-   request.position = ticket;
-   request.sl = NormalizeDouble(sl, _Digits);
-   request.tp = NormalizeDouble(tp, _Digits);
-   request.magic = MagicNumber;
-
-   if(!OrderSend(request, result)) {
-      Print("❌ MODIFY FAILED: #", ticket, " Error: ", result.retcode);
-      return false;
-   }
-   return true;
-}
-
 //==================== UPDATE DISPLAY ===============================//
 void UpdateDisplay() {
    MqlDateTime dt;
@@ -685,15 +682,4 @@ void UpdateDisplay() {
    Comment(info);
 }
 
-//==================== UTILITY: ARRAY REMOVE ========================//
-template<typename T>
-void ArrayRemove(T &arr[], int index) {
-   int size = ArraySize(arr);
-   if(index < 0 || index >= size) return;
-   
-   for(int i = index; i < size - 1; i++) {
-      arr[i] = arr[i + 1];
-   }
-   ArrayResize(arr, size - 1);
-}
 //+------------------------------------------------------------------+
\ No newline at end of file
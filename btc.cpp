@@ -1,4 +1,4 @@
-/+------------------------------------------------------------------+
+//+------------------------------------------------------------------+
 //|                    HighProfitEA_v4_BTC_ULTIMATE.mq5              |
 //|                  Ultimate Bitcoin Trading System                  |
 //|           Professional Grade - Maximum Performance Edition        |
@@ -10,6 +10,17 @@
 #property description "Advanced Multi-Strategy Bitcoin EA"
 #property description "Optimized for BTC volatility with institutional-grade risk management"
 
+#include "IncrementalIndicators.mqh"
+#include "TicketIndex.mqh"
+#include "PositionState.mqh"
+#include "TradeBook.mqh"
+#include "PositionProfit.mqh"
+#include "StateJournal.mqh"
+#include "StopScheduler.mqh"
+#include "VirtualStops.mqh"
+#include "PriceTriggers.mqh"
+#include "OrderExecutor.mqh"
+
 //+------------------------------------------------------------------+
 //| WHAT'S NEW IN v4.03 - CRITICAL FIXES                             |
 //| 🔧 FIXED: Volatility filter with tolerance                       |
@@ -34,6 +45,8 @@ const double VOLATILITY_EXTREME = 2.0;
 const double VOLATILITY_VERY_HIGH = 1.7;
 const double VOLATILITY_HIGH = 1.4;
 const int STRUCTURE_LOOKBACK = 30;
+const int BREAKOUT_BARS = 20;             // breakout range: closed bars 1..20
+const int SWING_BARS = 10;                // structure swings: bar 1 vs bars 2..10
 const double VOLATILITY_TOLERANCE = 0.05; // 0.05% tolerance for float comparison
 
 //--- Risk Management Inputs
@@ -96,6 +109,10 @@ input double      BreakevenBuffer = 10;           // BE buffer (points)
 input bool        UseTrailing = true;             // Trailing stop
 input double      TrailingStart_RR = 2.0;         // Start trailing at 2R
 input double      TrailingDistance_ATR = 1.5;     // Trailing distance (ATR)
+input double      TrailingMinStep_ATR = 0.1;      // Min trailing stop move (ATR)
+input int         TrailingMinStepPoints = 0;      // Min trailing stop move (points)
+input int         MaxStopModsPerSecond = 1;       // Max SL/TP changes per position per second (0=no limit)
+input bool        UseVirtualStops = false;        // BE/trailing stops kept in the EA, entry SL stays on the server
 
 //--- Session & Time Management
 input group "═══ ⏰ TRADING SESSIONS ═══"
@@ -123,8 +140,12 @@ input group "═══ 💵 MONEY MANAGEMENT ═══"
 input double      FixedLot = 0.0;                 // Fixed lot (0=auto)
 input double      MaxLotSize = 10.0;              // Maximum lot size
 input int         Slippage = 100;                 // Max slippage (points)
+input int         EntryMaxAttempts = 4;           // Sends per entry on requotes/busy server
+input int         EntryRetryBudgetMs = 1500;      // Time allowed for the retries of an entry (ms)
+input int         EntryMaxDriftPoints = 0;        // Max re-price drift from the first quote (0=Slippage)
 input int         MagicNumber = 440001;           // Magic number
 input string      TradeComment = "HPEA_BTC_v4";   // Trade comment
+input bool        PersistState = true;            // Resume position state after a restart
 
 //--- Display & Notifications
 input group "═══ 📱 DISPLAY & ALERTS ═══"
@@ -135,13 +156,20 @@ input bool        EnableDebugLogs = true;         // Print detailed diagnostics
 input bool        ShowStrategyStats = true;       // ⭐ NEW: Show 24H strategy stats
 
 //--- Global Variables
-int handleEMA_Fast, handleEMA_Medium, handleEMA_Slow, handleEMA_Trend, handleEMA_LongTerm;
-int handleRSI, handleATR, handleADX, handleBB;
-int handleEMA_Fast_HTF, handleEMA_Slow_HTF, handleRSI_HTF;
-
-double ema_fast[], ema_medium[], ema_slow[], ema_trend[], ema_longterm[];
-double rsi[], atr[], adx[], bb_upper[], bb_middle[], bb_lower[];
-double ema_fast_htf[], ema_slow_htf[], rsi_htf[];
+// Indicators are updated incrementally from the bars (no CopyBuffer per tick)
+CIncBarFeed primaryFeed, confirmFeed;
+CIncEMA ema_fast, ema_medium, ema_slow, ema_trend, ema_longterm;
+CIncRSI rsi;
+CIncATR atr;
+CIncADX adx;
+CIncBands bb;
+CIncEMA ema_fast_htf, ema_slow_htf;
+CIncRSI rsi_htf;
+bool primaryBarsReady = false;
+
+// Rolling highs/lows of closed primary bars, updated once per bar
+CIncExtreme breakoutHigh, breakoutLow;
+CIncExtreme swingHighMax, swingHighMin, swingLowMax, swingLowMin;
 
 datetime lastBarTime = 0;
 datetime lastTradeTime = 0;
@@ -160,6 +188,7 @@ int consecutiveWins = 0;
 double peakEquity = 0;
 double peakBalance = 0;
 bool emergencyStop = false;
+bool drawDashboard = false;     // ShowDashboard, off in non-visual tests
 datetime lastSpreadWarning = 0;
 double maxDrawdownReached = 0;
 
@@ -179,29 +208,71 @@ int momentumSignalCount = 0;
 int structureSignalCount = 0;
 int barCountFor24H = 0;
 
+//--- Per-bar signal frame: strategy predicates and scores, evaluated once
+//--- per bar and shared by the entry logic, the statistics and the logs
+#define SIGNAL_TREND_LONG        0x01
+#define SIGNAL_TREND_SHORT       0x02
+#define SIGNAL_BREAKOUT_LONG     0x04
+#define SIGNAL_BREAKOUT_SHORT    0x08
+#define SIGNAL_MOMENTUM_LONG     0x10
+#define SIGNAL_MOMENTUM_SHORT    0x20
+#define SIGNAL_STRUCTURE_LONG    0x40
+#define SIGNAL_STRUCTURE_SHORT   0x80
+
+struct SignalFrame
+{
+   datetime barTime;          // bar the frame belongs to, 0 = none
+   uint     mask;             // SIGNAL_* of the enabled strategies that fire
+   int      longSignals;
+   int      shortSignals;
+   string   longReasons;
+   string   shortReasons;
+   double   trendStrength;    // CalculateTrendStrength()
+   double   momentum;         // CalculateMomentum()
+   double   volatility;       // GetVolatilityRegime()
+};
+
+SignalFrame signalFrame;
+int signalFrameBuilds = 0;
+int signalFrameHits = 0;      // evaluations served by an existing frame
+
 //--- Position Tracking Enhanced
+//--- side, prices, extremes, favourable excursion and the TP/BE/trailing
+//--- flags live in positionState (same slot), which is read every tick
+#define TP_LEVELS 4
+
 struct PositionInfo
 {
    ulong ticket;
-   bool tp1_hit;
-   bool tp2_hit;
-   bool tp3_hit;
-   bool tp4_hit;
-   bool be_moved;
-   bool trailing_active;
    double original_volume;
    double current_volume;
-   double entry_price;
-   double highest_price;
-   double lowest_price;
+   double close_volume[TP_LEVELS];    // TP1..TP4 closes in whole volume steps, see BuildCloseSchedule
    datetime entry_time;
    string entry_reason;
    double entry_atr;
-   double max_favorable_excursion;
    double max_adverse_excursion;
 };
 
 PositionInfo positionTracking[];
+CTicketIndex positionTrackingIndex;   // ticket -> positionTracking slot
+CPositionState positionState;         // per-tick state, same slots as positionTracking
+CTradeBook tradeBook;                 // open positions, fed by OnTradeTransaction
+CPositionProfit positionProfit;       // net profit per position id, booked per deal
+CStopScheduler stopScheduler;         // SL/TP modifications: minimum step, per-ticket rate limit
+CVirtualStops virtualStops;           // UseVirtualStops: BE/trailing stops checked on each tick
+CPriceTriggers priceTriggers;         // price at which each position's next TP/BE/trailing step may be due
+COrderExecutor orderExecutor;         // entries: cached filling mode, requote/busy retries
+double triggerAtr = 0;                // ATR the trailing trigger levels were armed with
+
+//--- Warm restart: tracking state, counters and peaks are written to a
+//--- binary snapshot on opens, closes and new bars; the TP/BE/trailing
+//--- steps in between go to the journal (aux1 = original volume, aux2 =
+//--- MFE). OnInit reads the snapshot and replays the newer journal records
+#define STATE_FILE_MAGIC     0x53435442   // "BTCS"
+#define STATE_FILE_VERSION   3
+string stateFile = "";
+bool stateDirty = false;
+CStateJournal journal;
 
 //+------------------------------------------------------------------+
 //| Expert initialization                                             |
@@ -251,63 +322,49 @@ int OnInit()
    }
 
    // Initialize primary indicators
-   handleEMA_Fast = iMA(_Symbol, PrimaryTF, EMA_Fast, 0, MODE_EMA, PRICE_CLOSE);
-   handleEMA_Medium = iMA(_Symbol, PrimaryTF, EMA_Medium, 0, MODE_EMA, PRICE_CLOSE);
-   handleEMA_Slow = iMA(_Symbol, PrimaryTF, EMA_Slow, 0, MODE_EMA, PRICE_CLOSE);
-   handleEMA_Trend = iMA(_Symbol, PrimaryTF, EMA_Trend, 0, MODE_EMA, PRICE_CLOSE);
-   handleEMA_LongTerm = iMA(_Symbol, PrimaryTF, EMA_LongTerm, 0, MODE_EMA, PRICE_CLOSE);
-   handleRSI = iRSI(_Symbol, PrimaryTF, RSI_Period, PRICE_CLOSE);
-   handleATR = iATR(_Symbol, PrimaryTF, ATR_Period);
-   handleADX = iADX(_Symbol, PrimaryTF, ADX_Period);
-   handleBB = iBands(_Symbol, PrimaryTF, BB_Period, 0, BB_Deviation, PRICE_CLOSE);
+   primaryFeed.Init(_Symbol, PrimaryTF);
+   ema_fast.Init(EMA_Fast);
+   ema_medium.Init(EMA_Medium);
+   ema_slow.Init(EMA_Slow);
+   ema_trend.Init(EMA_Trend);
+   ema_longterm.Init(EMA_LongTerm);
+   rsi.Init(RSI_Period);
+   atr.Init(ATR_Period);
+   adx.Init(ADX_Period);
+   bb.Init(BB_Period, BB_Deviation);
+   breakoutHigh.Init(BREAKOUT_BARS, true);
+   breakoutLow.Init(BREAKOUT_BARS, false);
+   swingHighMax.Init(SWING_BARS - 1, true, 1);
+   swingHighMin.Init(SWING_BARS - 1, false, 1);
+   swingLowMax.Init(SWING_BARS - 1, true, 1);
+   swingLowMin.Init(SWING_BARS - 1, false, 1);
 
    // Initialize higher timeframe indicators
    if(UseMultiTimeframe)
    {
-      handleEMA_Fast_HTF = iMA(_Symbol, ConfirmTF, EMA_Fast, 0, MODE_EMA, PRICE_CLOSE);
-      handleEMA_Slow_HTF = iMA(_Symbol, ConfirmTF, EMA_Slow, 0, MODE_EMA, PRICE_CLOSE);
-      handleRSI_HTF = iRSI(_Symbol, ConfirmTF, RSI_Period, PRICE_CLOSE);
-   }
-
-   // Validate indicators
-   if(handleEMA_Fast == INVALID_HANDLE || handleEMA_Medium == INVALID_HANDLE ||
-      handleEMA_Slow == INVALID_HANDLE || handleEMA_Trend == INVALID_HANDLE ||
-      handleRSI == INVALID_HANDLE || handleATR == INVALID_HANDLE ||
-      handleADX == INVALID_HANDLE || handleBB == INVALID_HANDLE)
-   {
-      Print("❌ ERROR: Failed to initialize indicators");
-      return(INIT_FAILED);
-   }
-
-   if(UseMultiTimeframe && (handleEMA_Fast_HTF == INVALID_HANDLE ||
-      handleEMA_Slow_HTF == INVALID_HANDLE || handleRSI_HTF == INVALID_HANDLE))
-   {
-      Print("❌ ERROR: Failed to initialize HTF indicators");
-      return(INIT_FAILED);
+      confirmFeed.Init(_Symbol, ConfirmTF);
+      ema_fast_htf.Init(EMA_Fast);
+      ema_slow_htf.Init(EMA_Slow);
+      rsi_htf.Init(RSI_Period);
    }
 
-   // Setup arrays
-   ArraySetAsSeries(ema_fast, true);
-   ArraySetAsSeries(ema_medium, true);
-   ArraySetAsSeries(ema_slow, true);
-   ArraySetAsSeries(ema_trend, true);
-   ArraySetAsSeries(ema_longterm, true);
-   ArraySetAsSeries(rsi, true);
-   ArraySetAsSeries(atr, true);
-   ArraySetAsSeries(adx, true);
-   ArraySetAsSeries(bb_upper, true);
-   ArraySetAsSeries(bb_middle, true);
-   ArraySetAsSeries(bb_lower, true);
-
-   if(UseMultiTimeframe)
-   {
-      ArraySetAsSeries(ema_fast_htf, true);
-      ArraySetAsSeries(ema_slow_htf, true);
-      ArraySetAsSeries(rsi_htf, true);
-   }
+   // Labels are never rendered in a non-visual test, skip the per-tick redraw
+   drawDashboard = ShowDashboard &&
+                   (!MQLInfoInteger(MQL_TESTER) || MQLInfoInteger(MQL_VISUAL_MODE));
 
    // Initialize tracking
    ArrayResize(positionTracking, 0);
+   positionTrackingIndex.Clear();
+   positionTrackingIndex.Reserve(MaxPositions);
+   positionState.Clear();
+   positionState.Reserve(MaxPositions);
+   tradeBook.Init(_Symbol, MagicNumber, MaxPositions);
+   positionProfit.Init(MagicNumber, MaxPositions);
+   stopScheduler.Init(_Symbol, MagicNumber, MaxStopModsPerSecond, MaxPositions);
+   virtualStops.Init(_Symbol, MagicNumber, Slippage, MaxPositions);
+   priceTriggers.Init(MaxPositions);
+   orderExecutor.Init(_Symbol, EntryMaxAttempts, EntryRetryBudgetMs, EntryMaxDriftPoints);
+   tradeBook.Reconcile();
    startingDailyBalance = AccountInfoDouble(ACCOUNT_BALANCE);
    startingWeeklyBalance = startingDailyBalance;
    peakEquity = AccountInfoDouble(ACCOUNT_EQUITY);
@@ -315,6 +372,15 @@ int OnInit()
    lastDayCheck = TimeCurrent();
    lastWeekCheck = TimeCurrent();
 
+   // Resume the state of the previous run (TP ladder, BE/trailing, counters);
+   // per account, as the tickets and counters are the account's
+   string stateKey = IntegerToString(MagicNumber) + "_" + IntegerToString(AccountInfoInteger(ACCOUNT_LOGIN)) + "_" + _Symbol;
+   stateFile = "btc_state_" + stateKey + ".bin";
+   if(PersistState)
+      journal.Open("btc_journal_" + stateKey + ".bin", MagicNumber, MaxPositions);
+   if(PersistState && LoadState())
+      Print("♻️ State restored: ", ArraySize(positionTracking), " tracked positions");
+
    // Display configuration
    Print("╔══════════════════════════════════════════════════════╗");
    Print("║            v4.03 FIXES APPLIED                       ║");
@@ -341,23 +407,8 @@ int OnInit()
 //+------------------------------------------------------------------+
 void OnDeinit(const int reason)
 {
-   // Release indicators
-   IndicatorRelease(handleEMA_Fast);
-   IndicatorRelease(handleEMA_Medium);
-   IndicatorRelease(handleEMA_Slow);
-   IndicatorRelease(handleEMA_Trend);
-   IndicatorRelease(handleEMA_LongTerm);
-   IndicatorRelease(handleRSI);
-   IndicatorRelease(handleATR);
-   IndicatorRelease(handleADX);
-   IndicatorRelease(handleBB);
-
-   if(UseMultiTimeframe)
-   {
-      IndicatorRelease(handleEMA_Fast_HTF);
-      IndicatorRelease(handleEMA_Slow_HTF);
-      IndicatorRelease(handleRSI_HTF);
-   }
+   if(PersistState) SaveState();
+   journal.Close();
 
    // Delete dashboard
    if(ShowDashboard)
@@ -377,6 +428,17 @@ void OnDeinit(const int reason)
    Print("   Losses: ", losingTrades);
    Print("   Consecutive Losses: ", consecutiveLosses);
    Print("   Total Profit: $", DoubleToString(totalProfit, 2));
+   Print("   Signal frames: ", signalFrameBuilds, " built, ", signalFrameHits, " evaluations reused");
+   Print("   Stop modifications: ", stopScheduler.Requested(), " requested, ", stopScheduler.Sent(), " sent, ",
+         stopScheduler.Suppressed(), " suppressed (", stopScheduler.BelowStep(), " below min step, ",
+         stopScheduler.Coalesced(), " coalesced), ", stopScheduler.Failed(), " failed");
+   if(UseVirtualStops)
+      Print("   Virtual stops: ", virtualStops.Moves(), " stop moves kept off the server, ", virtualStops.Closes(), " closes, ",
+            virtualStops.Failed(), " failed");
+   Print("   Entries: ", orderExecutor.Orders(), " sent, ", orderExecutor.Filled(), " filled (", orderExecutor.Retried(),
+         " after a retry), ", orderExecutor.Failed(), " missed | ", DoubleToString(orderExecutor.AvgAttempts(), 2),
+         " attempts and ", DoubleToString(orderExecutor.AvgMs(), 0), " ms avg, ", orderExecutor.MaxMs(), " ms max | ",
+         orderExecutor.Requotes(), " requotes, ", orderExecutor.Busy(), " busy, ", orderExecutor.Drifted(), " drifted away");
    Print("══════════════════════════════════════════════════════");
 }
 
@@ -403,13 +465,19 @@ string GetDeinitReasonText(int reason)
 //+------------------------------------------------------------------+
 void OnTick()
 {
+   // Snapshot what the previous tick and its trade events changed
+   if(stateDirty) SaveState();
+   journal.Tick();
+
    // Emergency stop check
    if(emergencyStop)
    {
-      if(ShowDashboard) UpdateDashboard();
+      if(drawDashboard) UpdateDashboard();
       return;
    }
 
+   primaryBarsReady = SyncPrimaryBars();
+
    // New bar check
    if(!IsNewBar())
    {
@@ -418,15 +486,13 @@ void OnTick()
          ManageDynamicPositions();
          PrintNoEntryReason();
       }
-      if(ShowDashboard) UpdateDashboard();
+      if(drawDashboard) UpdateDashboard();
       return;
    }
 
-   // ⭐ NEW: Strategy tracking
-   if(ShowStrategyStats)
-   {
-      TrackStrategySignals();
-   }
+   // Counters and excursions are saved once per bar
+   SyncExcursions();
+   stateDirty = true;
 
    // Daily/weekly reset
    CheckDailyProfit();
@@ -435,10 +501,16 @@ void OnTick()
    // Update indicators first
    if(!UpdateIndicators())
    {
-      if(ShowDashboard) UpdateDashboard();
+      if(drawDashboard) UpdateDashboard();
       return;
    }
 
+   // ⭐ NEW: Strategy tracking (builds this bar's signal frame)
+   if(ShowStrategyStats)
+   {
+      TrackStrategySignals();
+   }
+
    // Risk checks
    if(!CheckRiskLimits()) return;
 
@@ -455,10 +527,10 @@ void OnTick()
    // Execute trading logic
    CheckAndExecuteSignals();
    ManageDynamicPositions();
-   CleanupPositionTracking();
+   if(tradeBook.ReconcileDue()) CleanupPositionTracking();
 
    // Update display
-   if(ShowDashboard) UpdateDashboard();
+   if(drawDashboard) UpdateDashboard();
 }
 
 //+------------------------------------------------------------------+
@@ -467,8 +539,8 @@ void OnTick()
 void TrackStrategySignals()
 {
    // ⭐ CRITICAL FIX: Verify all arrays are populated before checking strategies
-   if(ArraySize(ema_fast) < 3 || ArraySize(ema_slow) < 3 ||
-      ArraySize(rsi) < 3 || ArraySize(atr) < 3 || ArraySize(adx) < 3)
+   if(ema_fast.Count() < 3 || ema_slow.Count() < 3 ||
+      rsi.Count() < 3 || atr.Count() < 3 || adx.Count() < 3)
    {
       return; // Skip if indicators not ready
    }
@@ -477,25 +549,12 @@ void TrackStrategySignals()
 
    barCountFor24H++;
 
-   if(UseTrendStrategy)
-   {
-      if(CheckTrendLong() || CheckTrendShort()) trendSignalCount++;
-   }
-
-   if(UseBreakoutStrategy)
-   {
-      if(CheckBreakoutLong() || CheckBreakoutShort()) breakoutSignalCount++;
-   }
-
-   if(UseMomentumStrategy)
-   {
-      if(CheckMomentumLong() || CheckMomentumShort()) momentumSignalCount++;
-   }
-
-   if(UseStructureStrategy)
-   {
-      if(CheckStructureLong() || CheckStructureShort()) structureSignalCount++;
-   }
+   UpdateSignalFrame();
+   uint mask = signalFrame.mask;
+   if((mask & (SIGNAL_TREND_LONG | SIGNAL_TREND_SHORT)) != 0) trendSignalCount++;
+   if((mask & (SIGNAL_BREAKOUT_LONG | SIGNAL_BREAKOUT_SHORT)) != 0) breakoutSignalCount++;
+   if((mask & (SIGNAL_MOMENTUM_LONG | SIGNAL_MOMENTUM_SHORT)) != 0) momentumSignalCount++;
+   if((mask & (SIGNAL_STRUCTURE_LONG | SIGNAL_STRUCTURE_SHORT)) != 0) structureSignalCount++;
 
    // Print summary every 24 bars (24 hours on H1)
    if(barCountFor24H >= 24)
@@ -573,35 +632,12 @@ void PrintNoEntryReason()
    // 3. Strategy Status with Signal Counting
    if(reason == "")
    {
-      int longSignals = 0;
-      int shortSignals = 0;
-      string longReasons = "";
-      string shortReasons = "";
-
-      // Check each strategy
-      if(UseTrendStrategy)
-      {
-         if(CheckTrendLong()) { longSignals++; longReasons += "TREND "; }
-         if(CheckTrendShort()) { shortSignals++; shortReasons += "TREND "; }
-      }
-
-      if(UseBreakoutStrategy)
-      {
-         if(CheckBreakoutLong()) { longSignals++; longReasons += "BREAK "; }
-         if(CheckBreakoutShort()) { shortSignals++; shortReasons += "BREAK "; }
-      }
-
-      if(UseMomentumStrategy)
-      {
-         if(CheckMomentumLong()) { longSignals++; longReasons += "MOM "; }
-         if(CheckMomentumShort()) { shortSignals++; shortReasons += "MOM "; }
-      }
-
-      if(UseStructureStrategy)
-      {
-         if(CheckStructureLong()) { longSignals++; longReasons += "STRUCT "; }
-         if(CheckStructureShort()) { shortSignals++; shortReasons += "STRUCT "; }
-      }
+      // Strategies of this bar
+      UpdateSignalFrame();
+      int longSignals = signalFrame.longSignals;
+      int shortSignals = signalFrame.shortSignals;
+      string longReasons = signalFrame.longReasons;
+      string shortReasons = signalFrame.shortReasons;
 
       int requiredSignals = RequireMultipleSignals ? 2 : 1;
 
@@ -638,24 +674,44 @@ bool IsNewBar()
    return false;
 }
 
+//+------------------------------------------------------------------+
+//| Push new closed primary bars to the indicators and price windows  |
+//+------------------------------------------------------------------+
+bool SyncPrimaryBars()
+{
+   int added = primaryFeed.Sync();
+   if(added < 0) return false;
+   if(primaryFeed.Restarted())
+   {
+      ema_fast.Reset(); ema_medium.Reset(); ema_slow.Reset(); ema_trend.Reset(); ema_longterm.Reset();
+      rsi.Reset(); atr.Reset(); adx.Reset(); bb.Reset();
+      breakoutHigh.Reset(); breakoutLow.Reset();
+      swingHighMax.Reset(); swingHighMin.Reset(); swingLowMax.Reset(); swingLowMin.Reset();
+   }
+   for(int i = 0; i < added; i++)
+   {
+      MqlRates bar = primaryFeed.Bar(i);
+      ema_fast.Push(bar); ema_medium.Push(bar); ema_slow.Push(bar); ema_trend.Push(bar); ema_longterm.Push(bar);
+      rsi.Push(bar); atr.Push(bar); adx.Push(bar); bb.Push(bar);
+      breakoutHigh.Push(bar.high); breakoutLow.Push(bar.low);
+      swingHighMax.Push(bar.high); swingHighMin.Push(bar.high);
+      swingLowMax.Push(bar.low); swingLowMin.Push(bar.low);
+   }
+   return true;
+}
+
 //+------------------------------------------------------------------+
 //| Update all indicators                                             |
 //+------------------------------------------------------------------+
 bool UpdateIndicators()
 {
    if(Bars(_Symbol, PrimaryTF) < 210) return false;
+   if(!primaryBarsReady) return false;
 
-   if(CopyBuffer(handleEMA_Fast, 0, 0, 3, ema_fast) < 3) return false;
-   if(CopyBuffer(handleEMA_Medium, 0, 0, 3, ema_medium) < 3) return false;
-   if(CopyBuffer(handleEMA_Slow, 0, 0, 3, ema_slow) < 3) return false;
-   if(CopyBuffer(handleEMA_Trend, 0, 0, 3, ema_trend) < 3) return false;
-   if(CopyBuffer(handleEMA_LongTerm, 0, 0, 3, ema_longterm) < 3) return false;
-   if(CopyBuffer(handleRSI, 0, 0, 3, rsi) < 3) return false;
-   if(CopyBuffer(handleATR, 0, 0, 3, atr) < 3) return false;
-   if(CopyBuffer(handleADX, 0, 0, 3, adx) < 3) return false;
-   if(CopyBuffer(handleBB, 0, 0, 3, bb_upper) < 3) return false;
-   if(CopyBuffer(handleBB, 1, 0, 3, bb_middle) < 3) return false;
-   if(CopyBuffer(handleBB, 2, 0, 3, bb_lower) < 3) return false;
+   MqlRates forming = primaryFeed.Forming();
+   ema_fast.Forming(forming); ema_medium.Forming(forming); ema_slow.Forming(forming);
+   ema_trend.Forming(forming); ema_longterm.Forming(forming);
+   rsi.Forming(forming); atr.Forming(forming); adx.Forming(forming); bb.Forming(forming);
 
    if(atr[0] <= 0 || atr[1] <= 0 || atr[2] <= 0) return false;
 
@@ -663,9 +719,19 @@ bool UpdateIndicators()
    {
       if(Bars(_Symbol, ConfirmTF) < 210) return false;
 
-      if(CopyBuffer(handleEMA_Fast_HTF, 0, 0, 2, ema_fast_htf) < 2) return false;
-      if(CopyBuffer(handleEMA_Slow_HTF, 0, 0, 2, ema_slow_htf) < 2) return false;
-      if(CopyBuffer(handleRSI_HTF, 0, 0, 2, rsi_htf) < 2) return false;
+      int htfAdded = confirmFeed.Sync();
+      if(htfAdded < 0) return false;
+      if(confirmFeed.Restarted())
+      {
+         ema_fast_htf.Reset(); ema_slow_htf.Reset(); rsi_htf.Reset();
+      }
+      for(int i = 0; i < htfAdded; i++)
+      {
+         MqlRates bar = confirmFeed.Bar(i);
+         ema_fast_htf.Push(bar); ema_slow_htf.Push(bar); rsi_htf.Push(bar);
+      }
+      MqlRates htfForming = confirmFeed.Forming();
+      ema_fast_htf.Forming(htfForming); ema_slow_htf.Forming(htfForming); rsi_htf.Forming(htfForming);
    }
 
    return true;
@@ -833,64 +899,9 @@ bool IsTradingSession()
 //+------------------------------------------------------------------+
 void CheckAndExecuteSignals()
 {
-   int longSignals = 0, shortSignals = 0;
-   string longReasons = "", shortReasons = "";
-
-   if(UseTrendStrategy)
-   {
-      if(CheckTrendLong())
-      {
-         longSignals++;
-         longReasons += "TREND ";
-      }
-      if(CheckTrendShort())
-      {
-         shortSignals++;
-         shortReasons += "TREND ";
-      }
-   }
-
-   if(UseBreakoutStrategy)
-   {
-      if(CheckBreakoutLong())
-      {
-         longSignals++;
-         longReasons += "BREAKOUT ";
-      }
-      if(CheckBreakoutShort())
-      {
-         shortSignals++;
-         shortReasons += "BREAKOUT ";
-      }
-   }
-
-   if(UseMomentumStrategy)
-   {
-      if(CheckMomentumLong())
-      {
-         longSignals++;
-         longReasons += "MOMENTUM ";
-      }
-      if(CheckMomentumShort())
-      {
-         shortSignals++;
-         shortReasons += "MOMENTUM ";
-      }
-   }
-
-   if(UseStructureStrategy)
-   {
-      if(CheckStructureLong())
-      {
-         longSignals++;
-         longReasons += "STRUCTURE ";
-      }
-      if(CheckStructureShort())
-      {
-         shortSignals++;
-         shortReasons += "STRUCTURE ";
-      }
-   }
+   UpdateSignalFrame();
+   int longSignals = signalFrame.longSignals, shortSignals = signalFrame.shortSignals;
+   string longReasons = signalFrame.longReasons, shortReasons = signalFrame.shortReasons;
 
    if(UseMultiTimeframe)
    {
@@ -953,6 +964,70 @@ void CheckAndExecuteSignals()
    }
 }
 
+//+------------------------------------------------------------------+
+//| Evaluate the strategies once per bar into signalFrame             |
+//+------------------------------------------------------------------+
+void UpdateSignalFrame()
+{
+   datetime barTime = primaryFeed.Forming().time;
+   if(signalFrame.barTime == barTime && barTime != 0)
+   {
+      signalFrameHits++;
+      return;
+   }
+   signalFrameBuilds++;
+
+   signalFrame.barTime = barTime;
+   signalFrame.mask = 0;
+   if(UseTrendStrategy)
+   {
+      if(CheckTrendLong()) signalFrame.mask |= SIGNAL_TREND_LONG;
+      if(CheckTrendShort()) signalFrame.mask |= SIGNAL_TREND_SHORT;
+   }
+   if(UseBreakoutStrategy)
+   {
+      if(CheckBreakoutLong()) signalFrame.mask |= SIGNAL_BREAKOUT_LONG;
+      if(CheckBreakoutShort()) signalFrame.mask |= SIGNAL_BREAKOUT_SHORT;
+   }
+   if(UseMomentumStrategy)
+   {
+      if(CheckMomentumLong()) signalFrame.mask |= SIGNAL_MOMENTUM_LONG;
+      if(CheckMomentumShort()) signalFrame.mask |= SIGNAL_MOMENTUM_SHORT;
+   }
+   if(UseStructureStrategy)
+   {
+      if(CheckStructureLong()) signalFrame.mask |= SIGNAL_STRUCTURE_LONG;
+      if(CheckStructureShort()) signalFrame.mask |= SIGNAL_STRUCTURE_SHORT;
+   }
+
+   signalFrame.longSignals = 0;
+   signalFrame.shortSignals = 0;
+   signalFrame.longReasons = "";
+   signalFrame.shortReasons = "";
+   AddFrameSignal(SIGNAL_TREND_LONG, SIGNAL_TREND_SHORT, "TREND ");
+   AddFrameSignal(SIGNAL_BREAKOUT_LONG, SIGNAL_BREAKOUT_SHORT, "BREAKOUT ");
+   AddFrameSignal(SIGNAL_MOMENTUM_LONG, SIGNAL_MOMENTUM_SHORT, "MOMENTUM ");
+   AddFrameSignal(SIGNAL_STRUCTURE_LONG, SIGNAL_STRUCTURE_SHORT, "STRUCTURE ");
+
+   signalFrame.trendStrength = CalculateTrendStrength();
+   signalFrame.momentum = CalculateMomentum();
+   signalFrame.volatility = GetVolatilityRegime();
+}
+
+void AddFrameSignal(uint longBit, uint shortBit, string name)
+{
+   if((signalFrame.mask & longBit) != 0)
+   {
+      signalFrame.longSignals++;
+      signalFrame.longReasons += name;
+   }
+   if((signalFrame.mask & shortBit) != 0)
+   {
+      signalFrame.shortSignals++;
+      signalFrame.shortReasons += name;
+   }
+}
+
 //+------------------------------------------------------------------+
 //| Trend following strategy - LONG                                   |
 //+------------------------------------------------------------------+
@@ -1004,12 +1079,7 @@ bool CheckTrendShort()
 //+------------------------------------------------------------------+
 bool CheckBreakoutLong()
 {
-   double high20 = 0;
-   for(int i = 1; i <= 20; i++)
-   {
-      double h = GetHighPrice(_Symbol, PrimaryTF, i);
-      if(h > high20) high20 = h;
-   }
+   double high20 = breakoutHigh.Value();
 
    double currentPrice = SymbolInfoDouble(_Symbol, SYMBOL_BID);
    double breakoutStrength = (currentPrice - high20) / atr[0];
@@ -1028,12 +1098,7 @@ bool CheckBreakoutLong()
 //+------------------------------------------------------------------+
 bool CheckBreakoutShort()
 {
-   double low20 = 999999;
-   for(int i = 1; i <= 20; i++)
-   {
-      double l = GetLowPrice(_Symbol, PrimaryTF, i);
-      if(l < low20) low20 = l;
-   }
+   double low20 = breakoutLow.Value();
 
    double currentPrice = SymbolInfoDouble(_Symbol, SYMBOL_ASK);
    double breakoutStrength = (low20 - currentPrice) / atr[0];
@@ -1060,7 +1125,7 @@ bool CheckMomentumLong()
 
    bool aboveTrend = (currentPrice > ema_trend[0]);
 
-   bool bbExpansion = (bb_upper[0] - bb_lower[0]) > (bb_upper[1] - bb_lower[1]);
+   bool bbExpansion = (bb.Upper(0) - bb.Lower(0)) > (bb.Upper(1) - bb.Lower(1));
 
    bool adxRising = (adx[0] > adx[1]);
 
@@ -1080,7 +1145,7 @@ bool CheckMomentumShort()
 
    bool belowTrend = (currentPrice < ema_trend[0]);
 
-   bool bbExpansion = (bb_upper[0] - bb_lower[0]) > (bb_upper[1] - bb_lower[1]);
+   bool bbExpansion = (bb.Upper(0) - bb.Lower(0)) > (bb.Upper(1) - bb.Lower(1));
 
    bool adxRising = (adx[0] > adx[1]);
 
@@ -1094,27 +1159,10 @@ bool CheckStructureLong()
 {
    double currentPrice = SymbolInfoDouble(_Symbol, SYMBOL_BID);
 
-   bool higherHigh = false;
-   double recentHigh = GetHighPrice(_Symbol, PrimaryTF, 1);
-   for(int i = 2; i <= 10; i++)
-   {
-      if(recentHigh > GetHighPrice(_Symbol, PrimaryTF, i))
-      {
-         higherHigh = true;
-         break;
-      }
-   }
-
-   bool higherLow = false;
-   double recentLow = GetLowPrice(_Symbol, PrimaryTF, 1);
-   for(int i = 2; i <= 10; i++)
-   {
-      if(recentLow > GetLowPrice(_Symbol, PrimaryTF, i))
-      {
-         higherLow = true;
-         break;
-      }
-   }
+   // Last closed bar above any of the previous swing bars
+   MqlRates recent = primaryFeed.LastClosed();
+   bool higherHigh = (recent.high > swingHighMin.Value());
+   bool higherLow = (recent.low > swingLowMin.Value());
 
    bool structureShift = (ema_fast[0] > ema_slow[0] && ema_fast[1] <= ema_slow[1]);
 
@@ -1130,27 +1178,10 @@ bool CheckStructureShort()
 {
    double currentPrice = SymbolInfoDouble(_Symbol, SYMBOL_ASK);
 
-   bool lowerLow = false;
-   double recentLow = GetLowPrice(_Symbol, PrimaryTF, 1);
-   for(int i = 2; i <= 10; i++)
-   {
-      if(recentLow < GetLowPrice(_Symbol, PrimaryTF, i))
-      {
-         lowerLow = true;
-         break;
-      }
-   }
-
-   bool lowerHigh = false;
-   double recentHigh = GetHighPrice(_Symbol, PrimaryTF, 1);
-   for(int i = 2; i <= 10; i++)
-   {
-      if(recentHigh < GetHighPrice(_Symbol, PrimaryTF, i))
-      {
-         lowerHigh = true;
-         break;
-      }
-   }
+   // Last closed bar below any of the previous swing bars
+   MqlRates recent = primaryFeed.LastClosed();
+   bool lowerLow = (recent.low < swingLowMax.Value());
+   bool lowerHigh = (recent.high < swingHighMax.Value());
 
    bool structureShift = (ema_fast[0] < ema_slow[0] && ema_fast[1] >= ema_slow[1]);
 
@@ -1190,7 +1221,7 @@ double CalculateStopLoss(ENUM_ORDER_TYPE orderType)
                          SymbolInfoDouble(_Symbol, SYMBOL_BID);
 
    double atrMultiplier = ATR_SL_NORMAL;
-   double volatility = GetVolatilityRegime();
+   double volatility = signalFrame.volatility;
 
    if(volatility >= VOLATILITY_EXTREME)
       atrMultiplier = ATR_SL_WIDE;
@@ -1230,9 +1261,9 @@ double CalculateDynamicTakeProfit(ENUM_ORDER_TYPE orderType, double stopLoss)
 
    if(UseDynamicTP)
    {
-      double trendStrength = CalculateTrendStrength();
-      double momentum = CalculateMomentum();
-      double volatility = GetVolatilityRegime();
+      double trendStrength = signalFrame.trendStrength;
+      double momentum = signalFrame.momentum;
+      double volatility = signalFrame.volatility;
 
       if(trendStrength > TREND_STRENGTH_EXTREME && momentum > MOMENTUM_EXTREME)
          rrMultiplier = MaxRR;
@@ -1341,7 +1372,7 @@ double CalculateLotSize(double stopLoss)
 
    if(UseVolatilityScaling)
    {
-      double volatility = GetVolatilityRegime();
+      double volatility = signalFrame.volatility;
       if(volatility >= VOLATILITY_EXTREME)
          riskAmount *= 0.7;
       else if(volatility >= VOLATILITY_VERY_HIGH)
@@ -1391,7 +1422,7 @@ void OpenTrade(ENUM_ORDER_TYPE orderType, double lotSize, double sl, double tp,
    request.magic = MagicNumber;
    request.comment = TradeComment;
 
-   if(OrderSend(request, result))
+   if(orderExecutor.Send(request, result))
    {
       double rr = MathAbs(tp - result.price) / MathAbs(result.price - sl);
 
@@ -1400,6 +1431,7 @@ void OpenTrade(ENUM_ORDER_TYPE orderType, double lotSize, double sl, double tp,
       Print("╚══════════════════════════════════════════════════════╝");
       Print("Direction: ", (orderType == ORDER_TYPE_BUY ? "🟢 LONG" : "🔴 SHORT"));
       Print("Entry: ", DoubleToString(result.price, _Digits));
+      Print("Execution: ", orderExecutor.LastAttempts(), " attempt(s) in ", orderExecutor.LastMs(), " ms");
       Print("SL: ", DoubleToString(sl, _Digits), " (-", DoubleToString(MathAbs(result.price - sl), _Digits), ")");
       Print("TP: ", DoubleToString(tp, _Digits), " (+", DoubleToString(MathAbs(tp - result.price), _Digits), ")");
       Print("Lot Size: ", lotSize);
@@ -1408,7 +1440,8 @@ void OpenTrade(ENUM_ORDER_TYPE orderType, double lotSize, double sl, double tp,
       Print("Strategies: ", reason);
       Print("══════════════════════════════════════════════════════");
 
-      CreatePositionTracking(result.order, lotSize, result.price, reason);
+      int slot = CreatePositionTracking(result.order, lotSize, result.price, reason);
+      JournalTransition(slot, JOURNAL_OPEN, positionState.sl[slot]);
       dailyTradeCount++;
       totalTrades++;
       lastTradeTime = TimeCurrent();
@@ -1439,35 +1472,43 @@ void OpenTrade(ENUM_ORDER_TYPE orderType, double lotSize, double sl, double tp,
 //+------------------------------------------------------------------+
 //| Create position tracking                                          |
 //+------------------------------------------------------------------+
-void CreatePositionTracking(ulong ticket, double volume, double entryPrice, string reason)
+int CreatePositionTracking(ulong ticket, double volume, double entryPrice, string reason)
 {
-   int size = ArraySize(positionTracking);
-   ArrayResize(positionTracking, size + 1);
+   int size = positionTrackingIndex.Add(positionTracking, ticket);
 
-   positionTracking[size].ticket = ticket;
-   positionTracking[size].tp1_hit = false;
-   positionTracking[size].tp2_hit = false;
-   positionTracking[size].tp3_hit = false;
-   positionTracking[size].tp4_hit = false;
-   positionTracking[size].be_moved = false;
-   positionTracking[size].trailing_active = false;
    positionTracking[size].original_volume = volume;
    positionTracking[size].current_volume = volume;
-   positionTracking[size].entry_price = entryPrice;
-   positionTracking[size].highest_price = entryPrice;
-   positionTracking[size].lowest_price = entryPrice;
+   BuildCloseSchedule(size);
    positionTracking[size].entry_time = TimeCurrent();
    positionTracking[size].entry_reason = reason;
    positionTracking[size].entry_atr = atr[0];
-   positionTracking[size].max_favorable_excursion = 0;
    positionTracking[size].max_adverse_excursion = 0;
+
+   // Prices as the server holds them, the per-tick pass compares against these
+   int side = POSITION_SIDE_BUY;
+   double sl = 0, tp = 0;
+   if(PositionSelectByTicket(ticket))
+   {
+      if(PositionGetInteger(POSITION_TYPE) == POSITION_TYPE_SELL) side = POSITION_SIDE_SELL;
+      entryPrice = PositionGetDouble(POSITION_PRICE_OPEN);
+      sl = PositionGetDouble(POSITION_SL);
+      tp = PositionGetDouble(POSITION_TP);
+   }
+   positionState.Add(side, entryPrice, sl, tp);
+   ArmTrigger(size);
+   stateDirty = true;
+   return size;
 }
 
 //+------------------------------------------------------------------+
-//| Manage dynamic positions                                          |
+//| Track positions of this EA opened elsewhere (earlier runs)        |
 //+------------------------------------------------------------------+
-void ManageDynamicPositions()
+void TrackUntrackedPositions()
 {
+   // Our own trades are tracked when opened, so rescan only when the
+   // trade book holds positions that are not tracked
+   if(tradeBook.Positions() <= ArraySize(positionTracking)) return;
+
    for(int i = PositionsTotal() - 1; i >= 0; i--)
    {
       ulong ticket = PositionGetTicket(i);
@@ -1476,167 +1517,368 @@ void ManageDynamicPositions()
       if(PositionGetString(POSITION_SYMBOL) != _Symbol) continue;
       if(PositionGetInteger(POSITION_MAGIC) != MagicNumber) continue;
 
-      double currentPrice = PositionGetDouble(POSITION_PRICE_CURRENT);
-      double openPrice = PositionGetDouble(POSITION_PRICE_OPEN);
-      double sl = PositionGetDouble(POSITION_SL);
-      double tp = PositionGetDouble(POSITION_TP);
-      double volume = PositionGetDouble(POSITION_VOLUME);
-      double profit = PositionGetDouble(POSITION_PROFIT);
+      if(FindPositionTrackingIndex(ticket) >= 0) continue;
 
-      ENUM_POSITION_TYPE posType = (ENUM_POSITION_TYPE)PositionGetInteger(POSITION_TYPE);
+      // The journal may know its TP/BE/trailing progress
+      int slot = CreatePositionTracking(ticket, PositionGetDouble(POSITION_VOLUME), PositionGetDouble(POSITION_PRICE_OPEN), "Legacy");
+      if(!ApplyJournal(slot, 0)) JournalTransition(slot, JOURNAL_OPEN, positionState.sl[slot]);
+   }
+}
 
-      int trackIndex = FindPositionTrackingIndex(ticket);
-      if(trackIndex < 0)
-      {
-         CreatePositionTracking(ticket, volume, openPrice, "Legacy");
-         trackIndex = ArraySize(positionTracking) - 1;
-      }
+//+------------------------------------------------------------------+
+//| Manage dynamic positions                                          |
+//+------------------------------------------------------------------+
+void ManageDynamicPositions()
+{
+   TrackUntrackedPositions();
 
-      if(posType == POSITION_TYPE_BUY)
-      {
-         if(currentPrice > positionTracking[trackIndex].highest_price)
-            positionTracking[trackIndex].highest_price = currentPrice;
+   // Only the positions whose trigger level this quote crossed are looked
+   // at; the excursions of the others catch up when they are (see
+   // SyncExcursions)
+   double bid = SymbolInfoDouble(_Symbol, SYMBOL_BID);
+   double ask = SymbolInfoDouble(_Symbol, SYMBOL_ASK);
+   priceTriggers.Tick(bid, ask);
 
-         double favorableMove = currentPrice - openPrice;
-         if(favorableMove > positionTracking[trackIndex].max_favorable_excursion)
-            positionTracking[trackIndex].max_favorable_excursion = favorableMove;
-      }
-      else
-      {
-         if(currentPrice < positionTracking[trackIndex].lowest_price)
-            positionTracking[trackIndex].lowest_price = currentPrice;
+   // Trailing targets held back by the rate limit go out once allowed
+   if(atr.Count() > 0) stopScheduler.SetMinStep(MathMax(TrailingMinStepPoints * _Point, atr[0] * TrailingMinStep_ATR));
+   stopScheduler.Flush();
+   if(virtualStops.Count() > 0) virtualStops.Check(bid, ask);
 
-         double favorableMove = openPrice - currentPrice;
-         if(favorableMove > positionTracking[trackIndex].max_favorable_excursion)
-            positionTracking[trackIndex].max_favorable_excursion = favorableMove;
-      }
+   // A smaller ATR brings trailing levels closer (a larger one only
+   // fires them early), so they are re-armed when it drops
+   if(atr.Count() > 0)
+   {
+      if(atr[0] < triggerAtr) ArmAllTriggers();
+      triggerAtr = atr[0];
+   }
 
-      double riskDistance = MathAbs(openPrice - sl);
-      if(riskDistance == 0) continue;
+   ulong fired[];
+   int firedCount = priceTriggers.Fired(bid, ask, fired);
+   for(int k = 0; k < firedCount; k++)
+   {
+      int i = FindPositionTrackingIndex(fired[k]);
+      if(i < 0) continue;
 
-      double profitDistance = (posType == POSITION_TYPE_BUY) ?
-                              currentPrice - openPrice :
-                              openPrice - currentPrice;
-      double currentRR = profitDistance / riskDistance;
+      CatchUpExcursion(i, bid, ask);
+      ManageFiredPosition(i);
+      ArmTrigger(i);
+   }
+}
 
-      if(UsePartialTP)
-      {
-         if(!positionTracking[trackIndex].tp1_hit && currentRR >= TP1_RR)
-         {
-            double closeVol = NormalizeDouble(positionTracking[trackIndex].original_volume * (TP1_Percent / 100), 2);
-            if(closeVol >= SymbolInfoDouble(_Symbol, SYMBOL_VOLUME_MIN))
-            {
-               if(ClosePartialPosition(ticket, closeVol, posType))
-               {
-                  positionTracking[trackIndex].tp1_hit = true;
-                  positionTracking[trackIndex].current_volume -= closeVol;
-                  Print("🎯 TP1 Hit #", ticket, " @ ", DoubleToString(currentRR, 2), "R | Closed ", TP1_Percent, "%");
-               }
-            }
-         }
+//+------------------------------------------------------------------+
+//| Partial TPs, breakeven and trailing of a position whose trigger   |
+//| level was crossed                                                  |
+//+------------------------------------------------------------------+
+void ManageFiredPosition(int i)
+{
+   double riskDistance = MathAbs(positionState.entry[i] - positionState.sl[i]);
+   if(riskDistance == 0) return;
 
-         if(positionTracking[trackIndex].tp1_hit && !positionTracking[trackIndex].tp2_hit && currentRR >= TP2_RR)
-         {
-            double closeVol = NormalizeDouble(positionTracking[trackIndex].original_volume * (TP2_Percent / 100), 2);
-            if(closeVol >= SymbolInfoDouble(_Symbol, SYMBOL_VOLUME_MIN))
-            {
-               if(ClosePartialPosition(ticket, closeVol, posType))
-               {
-                  positionTracking[trackIndex].tp2_hit = true;
-                  positionTracking[trackIndex].current_volume -= closeVol;
-                  Print("🎯 TP2 Hit #", ticket, " @ ", DoubleToString(currentRR, 2), "R | Closed ", TP2_Percent, "%");
-               }
-            }
-         }
+   double profitDistance = positionState.move[i];
+   double currentRR = profitDistance / riskDistance;
+   if(!PositionManagementDue(i, profitDistance, currentRR)) return;
 
-         if(positionTracking[trackIndex].tp2_hit && !positionTracking[trackIndex].tp3_hit && currentRR >= TP3_RR)
-         {
-            double closeVol = NormalizeDouble(positionTracking[trackIndex].original_volume * (TP3_Percent / 100), 2);
-            if(closeVol >= SymbolInfoDouble(_Symbol, SYMBOL_VOLUME_MIN))
-            {
-               if(ClosePartialPosition(ticket, closeVol, posType))
-               {
-                  positionTracking[trackIndex].tp3_hit = true;
-                  positionTracking[trackIndex].current_volume -= closeVol;
-                  Print("🎯 TP3 Hit #", ticket, " @ ", DoubleToString(currentRR, 2), "R | Closed ", TP3_Percent, "%");
-               }
-            }
-         }
+   ulong ticket = positionTracking[i].ticket;
+   if(!PositionSelectByTicket(ticket)) return;
 
-         if(positionTracking[trackIndex].tp3_hit && !positionTracking[trackIndex].tp4_hit && currentRR >= TP4_RR)
-         {
-            double closeVol = positionTracking[trackIndex].current_volume;
-            if(closeVol >= SymbolInfoDouble(_Symbol, SYMBOL_VOLUME_MIN))
-            {
-               if(ClosePartialPosition(ticket, closeVol, posType))
-               {
-                  positionTracking[trackIndex].tp4_hit = true;
-                  Print("🎯 TP4 Hit #", ticket, " @ ", DoubleToString(currentRR, 2), "R | Runner closed!");
-               }
-            }
-         }
+   ManageTrackedPosition(i, ticket, profitDistance, currentRR);
+
+   // Stops may have moved, keep the cached copy equal to the ones in force
+   if(PositionSelectByTicket(ticket))
+   {
+      positionState.sl[i] = virtualStops.Stop(ticket, PositionGetDouble(POSITION_SL));
+      positionState.tp[i] = PositionGetDouble(POSITION_TP);
+   }
+}
+
+//+------------------------------------------------------------------+
+//| Favourable move from entry at which PositionManagementDue may     |
+//| hold and ManageTrackedPosition act; the trigger level of a        |
+//| position is its entry plus this move. 0 = nothing left to do.     |
+//+------------------------------------------------------------------+
+double TriggerLevel(int trackIndex)
+{
+   double entry = positionState.entry[trackIndex];
+   double risk = MathAbs(entry - positionState.sl[trackIndex]);
+   if(risk == 0) return 0;
+
+   int flags = positionState.flags[trackIndex];
+   double due = DBL_MAX;
+
+   if(UsePartialTP && (flags & POSITION_STATE_TP4) == 0)
+   {
+      double nextRR = (flags & POSITION_STATE_TP1) == 0 ? TP1_RR :
+                      (flags & POSITION_STATE_TP2) == 0 ? TP2_RR :
+                      (flags & POSITION_STATE_TP3) == 0 ? TP3_RR : TP4_RR;
+      due = MathMin(due, nextRR * risk);
+   }
+
+   // Breakeven only while it would still move the stop; a stop trailed
+   // past it would fire the level on every tick without ever setting BE
+   double beStop = entry + positionState.side[trackIndex] * BreakevenBuffer * _Point;
+   if(MoveToBreakeven && (flags & POSITION_STATE_BE) == 0 &&
+      positionState.side[trackIndex] * (beStop - positionState.sl[trackIndex]) > 0)
+      due = MathMin(due, MathAbs(positionState.tp[trackIndex] - entry) * BreakevenTrigger);
+
+   if(UseTrailing)
+      due = MathMin(due, TrailingTriggerMove(trackIndex, risk));
+
+   if(due == DBL_MAX) return 0;
+   double level = entry + positionState.side[trackIndex] * due;
+   return level > 0 ? level : 0;
+}
+
+//+------------------------------------------------------------------+
+//| Favourable move at which the trailing stop starts or moves next:  |
+//| price minus the trail distance of its R band (see                 |
+//| ManageTrackedPosition) must clear both the stop and the entry.    |
+//| Server stops must also clear the scheduler's minimum step, from   |
+//| the target it holds back if any, or the level would fire again on |
+//| every tick the scheduler turns the move down.                     |
+//+------------------------------------------------------------------+
+double TrailingTriggerMove(int trackIndex, double risk)
+{
+   double start = TrailingStart_RR * risk;
+   if(!positionState.Has(trackIndex, POSITION_STATE_TRAILING) || atr.Count() == 0) return start;
+
+   double stop = positionState.sl[trackIndex];
+   double step = 0;
+   if(!UseVirtualStops)
+   {
+      stopScheduler.Held(positionTracking[trackIndex].ticket, stop);
+      // a point more, as the scheduler rounds the new stop to the digits
+      if(stopScheduler.MinStep() > 0) step = stopScheduler.MinStep() + _Point;
+   }
+   double clear = MathMax(positionState.side[trackIndex] * (stop - positionState.entry[trackIndex]), 0);
+   double bandFrom[4] = {0, 3.0, 4.0, 5.0};
+   double bandAtr[4];
+   bandAtr[0] = TrailingDistance_ATR; bandAtr[1] = 1.2; bandAtr[2] = 1.0; bandAtr[3] = 0.8;
+
+   double due = DBL_MAX;
+   for(int b = 0; b < 4; b++)
+   {
+      double from = MathMax(bandFrom[b] * risk, start);
+      double to = b < 3 ? bandFrom[b + 1] * risk : DBL_MAX;
+      double move = MathMax(from, clear + atr[0] * bandAtr[b] + step);
+      if(move < to && move < due) due = move;
+   }
+   return due;
+}
+
+//+------------------------------------------------------------------+
+//| Arm the trigger of a position at its next level                   |
+//+------------------------------------------------------------------+
+void ArmTrigger(int trackIndex)
+{
+   priceTriggers.Arm(positionTracking[trackIndex].ticket, positionState.side[trackIndex], TriggerLevel(trackIndex));
+}
+
+void ArmAllTriggers()
+{
+   for(int i = positionState.Count() - 1; i >= 0; i--)
+      ArmTrigger(i);
+}
+
+//+------------------------------------------------------------------+
+//| Bring extremes and excursions of a position up to the quotes      |
+//| since it was last looked at                                       |
+//+------------------------------------------------------------------+
+void CatchUpExcursion(int trackIndex, double bid, double ask)
+{
+   bool buy = positionState.side[trackIndex] == POSITION_SIDE_BUY;
+   double best;
+   if(priceTriggers.Best(positionTracking[trackIndex].ticket, best))
+   {
+      if(buy && best > positionState.highest[trackIndex]) positionState.highest[trackIndex] = best;
+      if(!buy && best < positionState.lowest[trackIndex]) positionState.lowest[trackIndex] = best;
+      double bestMove = positionState.side[trackIndex] * (best - positionState.entry[trackIndex]);
+      if(bestMove > positionState.maxMove[trackIndex]) positionState.maxMove[trackIndex] = bestMove;
+   }
+   positionState.move[trackIndex] = positionState.side[trackIndex] * ((buy ? bid : ask) - positionState.entry[trackIndex]);
+}
+
+//+------------------------------------------------------------------+
+//| All positions caught up (once per bar and before a snapshot);     |
+//| the quotes they have all seen are dropped                         |
+//+------------------------------------------------------------------+
+void SyncExcursions()
+{
+   double bid = SymbolInfoDouble(_Symbol, SYMBOL_BID);
+   double ask = SymbolInfoDouble(_Symbol, SYMBOL_ASK);
+   for(int i = positionState.Count() - 1; i >= 0; i--)
+      CatchUpExcursion(i, bid, ask);
+   priceTriggers.Trim();
+}
+
+//+------------------------------------------------------------------+
+//| Can ManageTrackedPosition act on this position at this price?     |
+//+------------------------------------------------------------------+
+bool PositionManagementDue(int trackIndex, double profitDistance, double currentRR)
+{
+   int flags = positionState.flags[trackIndex];
+
+   if(UsePartialTP && (flags & POSITION_STATE_TP4) == 0)
+   {
+      double nextRR = (flags & POSITION_STATE_TP1) == 0 ? TP1_RR :
+                      (flags & POSITION_STATE_TP2) == 0 ? TP2_RR :
+                      (flags & POSITION_STATE_TP3) == 0 ? TP3_RR : TP4_RR;
+      if(currentRR >= nextRR) return true;
+   }
+
+   if(MoveToBreakeven && (flags & POSITION_STATE_BE) == 0)
+   {
+      double tpDistance = MathAbs(positionState.tp[trackIndex] - positionState.entry[trackIndex]);
+      if(profitDistance >= tpDistance * BreakevenTrigger) return true;
+   }
+
+   return UseTrailing && currentRR >= TrailingStart_RR;
+}
+
+//+------------------------------------------------------------------+
+//| Partial TPs, breakeven and trailing of one selected position      |
+//+------------------------------------------------------------------+
+void ManageTrackedPosition(int trackIndex, ulong ticket, double profitDistance, double currentRR)
+{
+   double currentPrice = PositionGetDouble(POSITION_PRICE_CURRENT);
+   double openPrice = PositionGetDouble(POSITION_PRICE_OPEN);
+   double sl = virtualStops.Stop(ticket, PositionGetDouble(POSITION_SL));
+   double tp = PositionGetDouble(POSITION_TP);
+
+   ENUM_POSITION_TYPE posType = (ENUM_POSITION_TYPE)PositionGetInteger(POSITION_TYPE);
+
+   if(UsePartialTP)
+   {
+      // Walk the close schedule built at entry, level by level; a level
+      // merged into the next one closes nothing
+      for(int level = 0; level < TP_LEVELS; level++)
+      {
+         int flag = POSITION_STATE_TP1 << level;
+         if(positionState.Has(trackIndex, flag)) continue;
+         if(currentRR < TakeProfitRR(level)) break;
+
+         double closeVol = positionTracking[trackIndex].close_volume[level];
+         if(closeVol > 0 && !ClosePartialPosition(ticket, closeVol, posType)) break;
+
+         positionState.flags[trackIndex] |= flag;
+         positionTracking[trackIndex].current_volume = NormalizeDouble(positionTracking[trackIndex].current_volume - closeVol, 8);
+         JournalTransition(trackIndex, JOURNAL_TAKE_PROFIT, sl);
+         if(closeVol > 0)
+            Print("🎯 TP", level + 1, " Hit #", ticket, " @ ", DoubleToString(currentRR, 2), "R | Closed ", DoubleToString(closeVol, 2),
+                  level == TP_LEVELS - 1 ? " | Runner closed!" : "");
       }
+   }
 
-      if(MoveToBreakeven && !positionTracking[trackIndex].be_moved)
+   if(MoveToBreakeven && !positionState.Has(trackIndex, POSITION_STATE_BE))
+   {
+      double tpDistance = MathAbs(tp - openPrice);
+      double triggerDistance = tpDistance * BreakevenTrigger;
+
+      if(profitDistance >= triggerDistance)
       {
-         double tpDistance = MathAbs(tp - openPrice);
-         double triggerDistance = tpDistance * BreakevenTrigger;
+         double newSL = (posType == POSITION_TYPE_BUY) ?
+                       openPrice + (BreakevenBuffer * _Point) :
+                       openPrice - (BreakevenBuffer * _Point);
 
-         if(profitDistance >= triggerDistance)
+         if((posType == POSITION_TYPE_BUY && newSL > sl) ||
+            (posType == POSITION_TYPE_SELL && newSL < sl))
          {
-            double newSL = (posType == POSITION_TYPE_BUY) ?
-                          openPrice + (BreakevenBuffer * _Point) :
-                          openPrice - (BreakevenBuffer * _Point);
-
-            if((posType == POSITION_TYPE_BUY && newSL > sl) ||
-               (posType == POSITION_TYPE_SELL && newSL < sl))
+            if(MoveStop(ticket, posType, newSL, tp, true))
             {
-               if(ModifyPosition(ticket, newSL, tp))
-               {
-                  positionTracking[trackIndex].be_moved = true;
-                  Print("🔒 Breakeven Set #", ticket, " @ ", DoubleToString(newSL, _Digits));
-               }
+               positionState.flags[trackIndex] |= POSITION_STATE_BE;
+               JournalTransition(trackIndex, JOURNAL_BREAKEVEN, newSL);
+               Print("🔒 Breakeven Set #", ticket, " @ ", DoubleToString(newSL, _Digits));
             }
          }
       }
+   }
 
-      if(UseTrailing && currentRR >= TrailingStart_RR)
+   if(UseTrailing && currentRR >= TrailingStart_RR)
+   {
+      if(!positionState.Has(trackIndex, POSITION_STATE_TRAILING))
       {
-         if(!positionTracking[trackIndex].trailing_active)
-         {
-            positionTracking[trackIndex].trailing_active = true;
-            Print("📍 Trailing Started #", ticket);
-         }
+         positionState.flags[trackIndex] |= POSITION_STATE_TRAILING;
+         JournalTransition(trackIndex, JOURNAL_TRAILING, sl);
+         Print("📍 Trailing Started #", ticket);
+      }
 
-         double trailDistance = atr[0] * TrailingDistance_ATR;
+      double trailDistance = atr[0] * TrailingDistance_ATR;
 
-         if(currentRR >= 5.0)
-            trailDistance = atr[0] * 0.8;
-         else if(currentRR >= 4.0)
-            trailDistance = atr[0] * 1.0;
-         else if(currentRR >= 3.0)
-            trailDistance = atr[0] * 1.2;
+      if(currentRR >= 5.0)
+         trailDistance = atr[0] * 0.8;
+      else if(currentRR >= 4.0)
+         trailDistance = atr[0] * 1.0;
+      else if(currentRR >= 3.0)
+         trailDistance = atr[0] * 1.2;
 
-         if(posType == POSITION_TYPE_BUY)
+      if(posType == POSITION_TYPE_BUY)
+      {
+         double newSL = currentPrice - trailDistance;
+         if(newSL > sl && newSL > openPrice)
          {
-            double newSL = currentPrice - trailDistance;
-            if(newSL > sl && newSL > openPrice)
-            {
-               ModifyPosition(ticket, newSL, tp);
-            }
+            if(MoveStop(ticket, posType, newSL, tp, false)) JournalTransition(trackIndex, JOURNAL_TRAILING, newSL);
          }
-         else
+      }
+      else
+      {
+         double newSL = currentPrice + trailDistance;
+         if(newSL < sl && newSL < openPrice)
          {
-            double newSL = currentPrice + trailDistance;
-            if(newSL < sl && newSL < openPrice)
-            {
-               ModifyPosition(ticket, newSL, tp);
-            }
+            if(MoveStop(ticket, posType, newSL, tp, false)) JournalTransition(trackIndex, JOURNAL_TRAILING, newSL);
          }
       }
    }
 }
 
+//+------------------------------------------------------------------+
+//| R multiple of take-profit level 0..3                              |
+//+------------------------------------------------------------------+
+double TakeProfitRR(int level)
+{
+   switch(level)
+   {
+      case 0:  return TP1_RR;
+      case 1:  return TP2_RR;
+      case 2:  return TP3_RR;
+      default: return TP4_RR;
+   }
+}
+
+//+------------------------------------------------------------------+
+//| Split the original volume over TP1..TP4 once per position, in     |
+//| whole volume steps: TP1..TP3 close their percent (rounded on the  |
+//| running total, so rounding does not add up) and TP4 the runner.   |
+//| A level below the minimum volume is merged into the next one; a   |
+//| level that would leave a runner below the minimum takes it along. |
+//+------------------------------------------------------------------+
+void BuildCloseSchedule(int trackIndex)
+{
+   double step = SymbolInfoDouble(_Symbol, SYMBOL_VOLUME_STEP);
+   if(step <= 0) step = 0.01;
+   long total = (long)MathRound(positionTracking[trackIndex].original_volume / step);
+   long minSteps = MathMax((long)MathCeil(SymbolInfoDouble(_Symbol, SYMBOL_VOLUME_MIN) / step - 1e-9), 1);
+
+   double share[TP_LEVELS];
+   share[0] = TP1_Percent;
+   share[1] = share[0] + TP2_Percent;
+   share[2] = share[1] + TP3_Percent;
+   share[3] = 100;
+
+   long planned = 0;
+   for(int level = 0; level < TP_LEVELS; level++)
+   {
+      long target = level == TP_LEVELS - 1 ? total : MathMin((long)MathRound(total * share[level] / 100), total);
+      long steps = MathMax(target - planned, 0);
+      long left = total - planned - steps;
+      if(level < TP_LEVELS - 1)
+      {
+         if(steps < minSteps) steps = 0;
+         else if(left > 0 && left < minSteps) steps += left;
+      }
+      positionTracking[trackIndex].close_volume[level] = NormalizeDouble(steps * step, 8);
+      planned += steps;
+   }
+}
+
 //+------------------------------------------------------------------+
 //| Close partial position                                            |
 //+------------------------------------------------------------------+
@@ -1667,19 +1909,14 @@ bool ClosePartialPosition(ulong ticket, double volume, ENUM_POSITION_TYPE posTyp
 }
 
 //+------------------------------------------------------------------+
-//| Modify position                                                    |
+//| Move a stop: through the scheduler, or in memory (virtual stops)  |
 //+------------------------------------------------------------------+
-bool ModifyPosition(ulong ticket, double sl, double tp)
+bool MoveStop(ulong ticket, ENUM_POSITION_TYPE posType, double sl, double tp, bool force)
 {
-   MqlTradeRequest request = {};
-   MqlTradeResult result = {};
+   if(!UseVirtualStops) return stopScheduler.Modify(ticket, sl, tp, force);
 
-   request.action = TRADE_ACTION_SLTP;
-   request.position = ticket;
-   request.sl = NormalizeDouble(sl, _Digits);
-   request.tp = NormalizeDouble(tp, _Digits);
-
-   return OrderSend(request, result);
+   virtualStops.Set(ticket, posType == POSITION_TYPE_BUY, NormalizeDouble(sl, _Digits));
+   return true;
 }
 
 //+------------------------------------------------------------------+
@@ -1687,60 +1924,333 @@ bool ModifyPosition(ulong ticket, double sl, double tp)
 //+------------------------------------------------------------------+
 int FindPositionTrackingIndex(ulong ticket)
 {
-   for(int i = 0; i < ArraySize(positionTracking); i++)
+   return positionTrackingIndex.Find(ticket);
+}
+
+//+------------------------------------------------------------------+
+//| Trade events: closed positions are booked as their deal arrives   |
+//+------------------------------------------------------------------+
+void OnTradeTransaction(const MqlTradeTransaction &trans, const MqlTradeRequest &request, const MqlTradeResult &result)
+{
+   if(trans.type == TRADE_TRANSACTION_DEAL_ADD) positionProfit.OnDeal(trans.deal);
+   ulong closed = tradeBook.OnTransaction(trans);
+   if(closed > 0)
+   {
+      int trackIndex = FindPositionTrackingIndex(closed);
+      if(trackIndex >= 0) BookClosedPosition(trackIndex);
+   }
+   else if(trans.type == TRADE_TRANSACTION_POSITION)
+   {
+      int trackIndex = FindPositionTrackingIndex(trans.position);
+      if(trackIndex >= 0)
+      {
+         positionState.sl[trackIndex] = virtualStops.Stop(trans.position, trans.price_sl);
+         positionState.tp[trackIndex] = trans.price_tp;
+         ArmTrigger(trackIndex);
+      }
+   }
+}
+
+//+------------------------------------------------------------------+
+//| Book the result of a closed position and stop tracking it         |
+//+------------------------------------------------------------------+
+void BookClosedPosition(int trackIndex)
+{
+   // Net of swap and commission
+   double posProfit = positionProfit.Take(positionTracking[trackIndex].ticket);
+
+   if(posProfit > 0)
    {
-      if(positionTracking[i].ticket == ticket) return i;
+      winningTrades++;
+      totalProfit += posProfit;
+      if(posProfit > largestWin) largestWin = posProfit;
+      consecutiveWins++;
+      consecutiveLosses = 0;
    }
-   return -1;
+   else if(posProfit < 0)
+   {
+      losingTrades++;
+      totalLoss += posProfit;
+      if(posProfit < largestLoss) largestLoss = posProfit;
+      consecutiveLosses++;
+      consecutiveWins = 0;
+   }
+
+   journal.Remove(positionTracking[trackIndex].ticket);
+   stopScheduler.Forget(positionTracking[trackIndex].ticket);
+   virtualStops.Remove(positionTracking[trackIndex].ticket);
+   priceTriggers.Remove(positionTracking[trackIndex].ticket);
+   positionTrackingIndex.RemoveAt(positionTracking, trackIndex);
+   positionState.RemoveAt(trackIndex);
+   stateDirty = true;
 }
 
 //+------------------------------------------------------------------+
-//| Cleanup position tracking                                         |
+//| Cleanup position tracking (safety net for missed trade events)    |
 //+------------------------------------------------------------------+
 void CleanupPositionTracking()
 {
    for(int i = ArraySize(positionTracking) - 1; i >= 0; i--)
    {
       if(!PositionSelectByTicket(positionTracking[i].ticket))
-      {
-         if(HistorySelectByPosition(positionTracking[i].ticket))
-         {
-            double posProfit = 0;
-            for(int j = HistoryDealsTotal() - 1; j >= 0; j--)
-            {
-               ulong dealTicket = HistoryDealGetTicket(j);
-               if(HistoryDealGetInteger(dealTicket, DEAL_POSITION_ID) == positionTracking[i].ticket)
-               {
-                  posProfit += HistoryDealGetDouble(dealTicket, DEAL_PROFIT);
-               }
-            }
+         BookClosedPosition(i);
+   }
+   tradeBook.Reconcile();
+}
 
-            if(posProfit > 0)
-            {
-               winningTrades++;
-               totalProfit += posProfit;
-               if(posProfit > largestWin) largestWin = posProfit;
-               consecutiveWins++;
-               consecutiveLosses = 0;
-            }
-            else if(posProfit < 0)
-            {
-               losingTrades++;
-               totalLoss += posProfit;
-               if(posProfit < largestLoss) largestLoss = posProfit;
-               consecutiveLosses++;
-               consecutiveWins = 0;
-            }
-         }
+//+------------------------------------------------------------------+
+//| Save the state snapshot (write a temp file, then rename over)     |
+//+------------------------------------------------------------------+
+void SaveState()
+{
+   stateDirty = false;
+   if(!PersistState) return;
+   SyncExcursions();
 
-         int size = ArraySize(positionTracking);
-         for(int j = i; j < size - 1; j++)
-         {
-            positionTracking[j] = positionTracking[j + 1];
-         }
-         ArrayResize(positionTracking, size - 1);
+   string tempFile = stateFile + ".tmp";
+   int handle = FileOpen(tempFile, FILE_WRITE | FILE_BIN);
+   if(handle == INVALID_HANDLE)
+   {
+      Print("⚠️ State not saved, error ", GetLastError());
+      return;
+   }
+
+   FileWriteInteger(handle, STATE_FILE_MAGIC);
+   FileWriteInteger(handle, STATE_FILE_VERSION);
+   FileWriteLong(handle, MagicNumber);
+   FileWriteLong(handle, AccountInfoInteger(ACCOUNT_LOGIN));
+   WriteStateString(handle, _Symbol);
+   FileWriteLong(handle, (long)journal.LastSeq());
+
+   FileWriteLong(handle, lastBarTime);
+   FileWriteLong(handle, lastTradeTime);
+   FileWriteDouble(handle, dailyProfit);
+   FileWriteDouble(handle, weeklyProfit);
+   FileWriteDouble(handle, startingDailyBalance);
+   FileWriteDouble(handle, startingWeeklyBalance);
+   FileWriteLong(handle, lastDayCheck);
+   FileWriteLong(handle, lastWeekCheck);
+   FileWriteInteger(handle, dailyLimitReached ? 1 : 0, CHAR_VALUE);
+   FileWriteInteger(handle, weeklyLimitReached ? 1 : 0, CHAR_VALUE);
+   FileWriteInteger(handle, emergencyStop ? 1 : 0, CHAR_VALUE);
+   FileWriteInteger(handle, dailyTradeCount);
+   FileWriteInteger(handle, consecutiveLosses);
+   FileWriteInteger(handle, consecutiveWins);
+   FileWriteDouble(handle, peakEquity);
+   FileWriteDouble(handle, peakBalance);
+   FileWriteDouble(handle, maxDrawdownReached);
+   FileWriteInteger(handle, totalTrades);
+   FileWriteInteger(handle, winningTrades);
+   FileWriteInteger(handle, losingTrades);
+   FileWriteDouble(handle, totalProfit);
+   FileWriteDouble(handle, totalLoss);
+   FileWriteDouble(handle, largestWin);
+   FileWriteDouble(handle, largestLoss);
+
+   int count = ArraySize(positionTracking);
+   FileWriteInteger(handle, count);
+   for(int i = 0; i < count; i++)
+   {
+      FileWriteLong(handle, (long)positionTracking[i].ticket);
+      FileWriteDouble(handle, positionTracking[i].original_volume);
+      FileWriteDouble(handle, positionTracking[i].current_volume);
+      FileWriteLong(handle, positionTracking[i].entry_time);
+      WriteStateString(handle, positionTracking[i].entry_reason);
+      FileWriteDouble(handle, positionTracking[i].entry_atr);
+      FileWriteDouble(handle, positionTracking[i].max_adverse_excursion);
+
+      FileWriteInteger(handle, positionState.side[i]);
+      FileWriteDouble(handle, positionState.entry[i]);
+      FileWriteDouble(handle, positionState.sl[i]);
+      FileWriteDouble(handle, positionState.tp[i]);
+      FileWriteDouble(handle, positionState.highest[i]);
+      FileWriteDouble(handle, positionState.lowest[i]);
+      FileWriteDouble(handle, positionState.move[i]);
+      FileWriteDouble(handle, positionState.maxMove[i]);
+      FileWriteDouble(handle, positionState.beThreshold[i]);
+      FileWriteDouble(handle, positionState.trailingStart[i]);
+      FileWriteDouble(handle, positionState.trailingStep[i]);
+      FileWriteInteger(handle, positionState.flags[i]);
+
+      // Net result booked so far, so the close needs no history query
+      double booked = 0;
+      bool known = positionProfit.Get(positionTracking[i].ticket, booked);
+      FileWriteInteger(handle, known ? 1 : 0, CHAR_VALUE);
+      FileWriteDouble(handle, booked);
+   }
+
+   // On disk before it replaces the previous snapshot
+   FileFlush(handle);
+   FileClose(handle);
+   if(!FileMove(tempFile, 0, stateFile, FILE_REWRITE))
+      Print("⚠️ State not saved, error ", GetLastError());
+}
+
+//+------------------------------------------------------------------+
+//| Load the state snapshot of the previous run                       |
+//+------------------------------------------------------------------+
+bool LoadState()
+{
+   if(!FileIsExist(stateFile)) return false;
+
+   int handle = FileOpen(stateFile, FILE_READ | FILE_BIN);
+   if(handle == INVALID_HANDLE) return false;
+
+   if(FileReadInteger(handle) != STATE_FILE_MAGIC ||
+      FileReadInteger(handle) != STATE_FILE_VERSION ||
+      FileReadLong(handle) != MagicNumber ||
+      FileReadLong(handle) != AccountInfoInteger(ACCOUNT_LOGIN) ||
+      ReadStateString(handle) != _Symbol)
+   {
+      Print("⚠️ State file ", stateFile, " does not match this EA, ignored");
+      FileClose(handle);
+      return false;
+   }
+   ulong journalSeq = (ulong)FileReadLong(handle);
+
+   lastBarTime = (datetime)FileReadLong(handle);
+   lastTradeTime = (datetime)FileReadLong(handle);
+   dailyProfit = FileReadDouble(handle);
+   weeklyProfit = FileReadDouble(handle);
+   startingDailyBalance = FileReadDouble(handle);
+   startingWeeklyBalance = FileReadDouble(handle);
+   lastDayCheck = (datetime)FileReadLong(handle);
+   lastWeekCheck = (datetime)FileReadLong(handle);
+   dailyLimitReached = FileReadInteger(handle, CHAR_VALUE) != 0;
+   weeklyLimitReached = FileReadInteger(handle, CHAR_VALUE) != 0;
+   // Reloading the EA is how an emergency stop is cleared: it is not
+   // restored, and the drawdown peak and loss streak it tripped on start
+   // over as on a fresh start
+   bool stopped = FileReadInteger(handle, CHAR_VALUE) != 0;
+   dailyTradeCount = FileReadInteger(handle);
+   consecutiveLosses = FileReadInteger(handle);
+   consecutiveWins = FileReadInteger(handle);
+   peakEquity = FileReadDouble(handle);
+   peakBalance = FileReadDouble(handle);
+   maxDrawdownReached = FileReadDouble(handle);
+   totalTrades = FileReadInteger(handle);
+   winningTrades = FileReadInteger(handle);
+   losingTrades = FileReadInteger(handle);
+   totalProfit = FileReadDouble(handle);
+   totalLoss = FileReadDouble(handle);
+   largestWin = FileReadDouble(handle);
+   largestLoss = FileReadDouble(handle);
+   if(stopped)
+   {
+      peakBalance = AccountInfoDouble(ACCOUNT_BALANCE);
+      consecutiveLosses = 0;
+      Print("♻️ Emergency stop of the previous run cleared by the reload");
+   }
+
+   int count = FileReadInteger(handle);
+   for(int i = 0; i < count && !FileIsEnding(handle); i++)
+   {
+      ulong ticket = (ulong)FileReadLong(handle);
+      int slot = positionTrackingIndex.Add(positionTracking, ticket);
+      positionTracking[slot].original_volume = FileReadDouble(handle);
+      positionTracking[slot].current_volume = FileReadDouble(handle);
+      BuildCloseSchedule(slot);
+      positionTracking[slot].entry_time = (datetime)FileReadLong(handle);
+      positionTracking[slot].entry_reason = ReadStateString(handle);
+      positionTracking[slot].entry_atr = FileReadDouble(handle);
+      positionTracking[slot].max_adverse_excursion = FileReadDouble(handle);
+
+      int side = FileReadInteger(handle);
+      double entry = FileReadDouble(handle);
+      double sl = FileReadDouble(handle);
+      double tp = FileReadDouble(handle);
+      positionState.Add(side, entry, sl, tp);
+      positionState.highest[slot] = FileReadDouble(handle);
+      positionState.lowest[slot] = FileReadDouble(handle);
+      positionState.move[slot] = FileReadDouble(handle);
+      positionState.maxMove[slot] = FileReadDouble(handle);
+      positionState.beThreshold[slot] = FileReadDouble(handle);
+      positionState.trailingStart[slot] = FileReadDouble(handle);
+      positionState.trailingStep[slot] = FileReadDouble(handle);
+      positionState.flags[slot] = FileReadInteger(handle);
+
+      bool known = FileReadInteger(handle, CHAR_VALUE) != 0;
+      double booked = FileReadDouble(handle);
+      if(known) positionProfit.Restore(ticket, booked);
+   }
+   FileClose(handle);
+
+   // Positions closed while the EA was not running are booked now; the
+   // journal has the steps taken after the snapshot, the server the stops
+   for(int i = ArraySize(positionTracking) - 1; i >= 0; i--)
+   {
+      if(!PositionSelectByTicket(positionTracking[i].ticket))
+         BookClosedPosition(i);
+      else
+      {
+         RestoreVirtualStop(i, positionState.sl[i]);
+         ApplyJournal(i, journalSeq);
+         positionState.sl[i] = virtualStops.Stop(positionTracking[i].ticket, PositionGetDouble(POSITION_SL));
+         positionState.tp[i] = PositionGetDouble(POSITION_TP);
+         ArmTrigger(i);
       }
    }
+   stateDirty = true;
+   return true;
+}
+
+//+------------------------------------------------------------------+
+//| Journal one management step of a tracked position                 |
+//+------------------------------------------------------------------+
+void JournalTransition(int trackIndex, int event, double sl)
+{
+   journal.Append(positionTracking[trackIndex].ticket, event, positionState.flags[trackIndex],
+                  positionTracking[trackIndex].current_volume, sl, positionState.tp[trackIndex],
+                  positionTracking[trackIndex].original_volume, positionState.maxMove[trackIndex]);
+}
+
+//+------------------------------------------------------------------+
+//| Resume a tracked position from its journal record newer than seq  |
+//+------------------------------------------------------------------+
+bool ApplyJournal(int trackIndex, ulong afterSeq)
+{
+   StateJournalRecord record;
+   if(!journal.Find(positionTracking[trackIndex].ticket, record) || record.seq <= afterSeq) return false;
+
+   positionState.flags[trackIndex] = record.flags;
+   positionTracking[trackIndex].current_volume = record.volume;
+   positionTracking[trackIndex].original_volume = record.aux1;
+   BuildCloseSchedule(trackIndex);
+   if(record.aux2 > positionState.maxMove[trackIndex]) positionState.maxMove[trackIndex] = record.aux2;
+   RestoreVirtualStop(trackIndex, record.sl);
+   ArmTrigger(trackIndex);
+   return true;
+}
+
+//+------------------------------------------------------------------+
+//| A virtual stop outlives a restart in the state file and journal   |
+//| only: resume it when "sl" is tighter than the selected position's |
+//+------------------------------------------------------------------+
+void RestoreVirtualStop(int trackIndex, double sl)
+{
+   if(!UseVirtualStops || sl <= 0) return;
+
+   bool buy = positionState.side[trackIndex] == POSITION_SIDE_BUY;
+   double serverSL = PositionGetDouble(POSITION_SL);
+   if(serverSL > 0 && (buy ? sl <= serverSL : sl >= serverSL)) return;
+
+   virtualStops.Set(positionTracking[trackIndex].ticket, buy, sl);
+   positionState.sl[trackIndex] = sl;
+}
+
+//+------------------------------------------------------------------+
+//| Length-prefixed strings of the state file                         |
+//+------------------------------------------------------------------+
+void WriteStateString(int handle, string text)
+{
+   FileWriteInteger(handle, StringLen(text));
+   FileWriteString(handle, text);
+}
+
+string ReadStateString(int handle)
+{
+   int length = FileReadInteger(handle);
+   return length > 0 ? FileReadString(handle, length) : "";
 }
 
 //+------------------------------------------------------------------+
@@ -1790,19 +2300,7 @@ void CloseAllPositions(string reason)
 //+------------------------------------------------------------------+
 int CountOpenPositions()
 {
-   int count = 0;
-   for(int i = 0; i < PositionsTotal(); i++)
-   {
-      ulong ticket = PositionGetTicket(i);
-      if(ticket <= 0) continue;
-
-      if(PositionGetString(POSITION_SYMBOL) == _Symbol &&
-         PositionGetInteger(POSITION_MAGIC) == MagicNumber)
-      {
-         count++;
-      }
-   }
-   return count;
+   return tradeBook.Positions();
 }
 
 //+------------------------------------------------------------------+
@@ -1874,7 +2372,7 @@ void CheckWeeklyProfit()
 //+------------------------------------------------------------------+
 void UpdateDashboard()
 {
-   if(!ShowDashboard) return;
+   if(!drawDashboard) return;
 
    if(atr[0] <= 0 || adx[0] <= 0 || rsi[0] <= 0) return;
 
@@ -1962,28 +2460,6 @@ void CreateLabel(string name, int x, int y, string text, color clr, int fontSize
    ObjectSetInteger(0, name, OBJPROP_COLOR, clr);
 }
 
-//+------------------------------------------------------------------+
-//| Get high price (custom wrapper)                                   |
-//+------------------------------------------------------------------+
-double GetHighPrice(string symbol, ENUM_TIMEFRAMES timeframe, int index)
-{
-   double highArray[];
-   ArraySetAsSeries(highArray, true);
-   if(CopyHigh(symbol, timeframe, index, 1, highArray) <= 0) return 0;
-   return highArray[0];
-}
-
-//+------------------------------------------------------------------+
-//| Get low price (custom wrapper)                                    |
-//+------------------------------------------------------------------+
-double GetLowPrice(string symbol, ENUM_TIMEFRAMES timeframe, int index)
-{
-   double lowArray[];
-   ArraySetAsSeries(lowArray, true);
-   if(CopyLow(symbol, timeframe, index, 1, lowArray) <= 0) return 0;
-   return lowArray[0];
-}
-
 //+------------------------------------------------------------------+
 //| Get close price (custom wrapper)                                  |
 //+------------------------------------------------------------------+
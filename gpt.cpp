@@ -7,6 +7,17 @@
 #property version   "4.00"
 #property strict
 
+#include "IndicatorCache.mqh"
+#include "IncrementalIndicators.mqh"
+#include "TicketIndex.mqh"
+#include "PositionState.mqh"
+#include "TradeBook.mqh"
+#include "PositionProfit.mqh"
+#include "AsyncOrders.mqh"
+#include "VirtualPositions.mqh"
+#include "VirtualStops.mqh"
+#include "OrderExecutor.mqh"
+
 //==================== STRUCTURES ====================================//
 struct PriceActionData {
     bool isEngulfing;
@@ -26,21 +37,10 @@ struct OrderFlowData {
 
 struct PositionInfo {
     ulong ticket;
-    string side;
-    double entryPrice;
     double lotSize;
-    double sl;
-    double tp;
     int level;
     string strength;
     int entryScore;
-    bool beMovedTo;
-    bool trailingActive;
-    double highest;
-    double lowest;
-    double beThreshold;
-    double trailingStart;
-    double trailingStep;
     datetime openTime;
 };
 
@@ -70,6 +70,11 @@ input double MaxLotSize = 5.0;                 // Max Allowed Lot
 input int MaxPositions = 2;                   // Max Positions per Signal (Updated to 50)
 input int MaxTotalPositions = 50;              // Max Total Open Positions (Updated to 10)
 input int Slippage = 3;                        // Max Slippage
+input int MaxOrdersInFlight = 10;              // Max Async Orders Awaiting an Answer
+// Net orders: one deal per signal is rounded once instead of per level,
+// so the balance, and with it the lot sizes, drift from per-level orders
+input bool NetOrderMode = false;               // One Order per Signal, Levels as Virtual Sub-Positions
+input bool UseVirtualStops = false;            // BE/Trailing Stops Kept in the EA, Entry SL Stays on the Server
 input int MagicNumber = 123456;                // Magic Number
 input bool UseBreakeven = true;                // Use Breakeven
 input double BreakevenOffset = 0.0001;         // Breakeven Offset
@@ -92,17 +97,57 @@ double atr[];
 double emaFast[];
 double emaSlow[];
 PositionInfo positions[];
+CTicketIndex positionIndex;      // ticket -> positions slot
+CPositionState posState;         // prices/flags read every tick, same slots as positions[]
+CTradeBook tradeBook;            // open positions, fed by OnTradeTransaction
+CPositionProfit positionProfit;  // net profit per position id, booked per deal
 TradingStats stats;
+// Signal of each batch of orders still in flight, see OnOrderAnswer
+struct OrderBatchInfo {
+    int batch;
+    string signal;
+    string strength;
+    int score;
+    double price;
+    int subs;                    // NetOrderMode: levels carried by the one order
+    double lot;                  // volume of one level
+};
+OrderBatchInfo orderBatches[];
+CAsyncOrders asyncOrders;        // OrderSendAsync batches, answered in OnTradeTransaction
+CVirtualPositions virtualPositions; // NetOrderMode: levels of the net orders, keyed in positions[]
+CVirtualStops virtualStops;      // UseVirtualStops: moved stops of the real positions
+COrderExecutor orderExecutor;    // filling mode of the symbol, detected once
 string lastSignal = "NONE";
 int lastSignalScore = 0;
 
 // Indicators Handles
 int hRSI, hATR, hEMAFast, hEMASlow;
 
+// Last M1 bars, [0] = forming bar; fetched with one CopyRates per tick
+#define M1_SNAPSHOT_BARS 6
+MqlRates m1Bars[];
+CIncVolume orderFlow;            // buy/sell tick volume of the last 5 M1 bars
+datetime orderFlowBarTime = 0;   // newest closed bar pushed to orderFlow
+// Higher timeframe EMAs, live handles kept for the whole run
+CIndicatorCache indicatorCache;
+
 //==================== INITIALIZATION ================================//
 int OnInit() {
     ArrayResize(positions, 0);
+    positionIndex.Clear();
+    positionIndex.Reserve(MaxTotalPositions);
+    posState.Clear();
+    posState.Reserve(MaxTotalPositions);
+    tradeBook.Init(_Symbol, MagicNumber, MaxTotalPositions);
+    positionProfit.Init(MagicNumber, MaxTotalPositions);
+    asyncOrders.Init(MaxOrdersInFlight, MaxTotalPositions);
+    virtualPositions.Init(_Symbol, MagicNumber, Slippage, MaxTotalPositions);
+    virtualStops.Init(_Symbol, MagicNumber, Slippage, MaxTotalPositions);
+    orderExecutor.Init(_Symbol, ORDER_EXECUTOR_MAX_ATTEMPTS, ORDER_EXECUTOR_BUDGET_MS, 0);
+    ArrayResize(orderBatches, 0);
     ZeroMemory(stats);
+    ArraySetAsSeries(m1Bars, true);
+    orderFlow.Init(5);
 
     // Initialize Indicators
     hRSI = iRSI(_Symbol, PERIOD_M1, 14, PRICE_CLOSE);
@@ -112,6 +157,9 @@ int OnInit() {
 
     if(hRSI == INVALID_HANDLE || hATR == INVALID_HANDLE) return INIT_FAILED;
 
+    indicatorCache.Handle(_Symbol, TrendTF1, CACHED_EMA, TrendEMA1);
+    indicatorCache.Handle(_Symbol, TrendTF2, CACHED_EMA, TrendEMA2);
+
     return(INIT_SUCCEEDED);
 }
 
@@ -120,6 +168,11 @@ void OnDeinit(const int reason) {
     IndicatorRelease(hATR);
     IndicatorRelease(hEMAFast);
     IndicatorRelease(hEMASlow);
+    Print("Indicator cache: ", indicatorCache.Created(), " handles created, ", indicatorCache.Reused(), " creations avoided");
+    indicatorCache.Release();
+    if(NetOrderMode) Print("Net orders: ", virtualPositions.Opened(), " sub-positions, ", virtualPositions.Closes(), " virtual stops, ", virtualPositions.OrdersSaved(), " orders saved");
+    if(UseVirtualStops) Print("Virtual stops: ", virtualStops.Moves(), " stop moves kept off the server, ", virtualStops.Closes(), " closes, ", virtualStops.Failed(), " failed");
+    Print("Async orders: ", asyncOrders.Sent(), " sent, ", asyncOrders.Filled(), " filled, ", asyncOrders.Failed(), " failed, ", asyncOrders.Resent(), " requotes resent");
 }
 
 void OnTick() {
@@ -135,9 +188,13 @@ void OnTick() {
 
     // 2. Manage Existing Positions & Display
     ManagePositions();
-    SyncPositions();
+    asyncOrders.CheckTimeouts();
+    if(tradeBook.ReconcileDue()) SyncPositions();
     UpdateStats();
-    UpdateDisplay();
+    // Analysis and entries need the M1 snapshot; management above does not
+    if(CopyRates(_Symbol, PERIOD_M1, 0, M1_SNAPSHOT_BARS, m1Bars) < M1_SNAPSHOT_BARS) return;
+    UpdateOrderFlow(m1Bars);
+    UpdateDisplay(m1Bars);
 
     // 3. Filters (Time, News, Drawdown)
     if(!IsTradingSession() || IsNewsTime() || CheckEquityStop() || CheckDailyLossStop()) return;
@@ -148,10 +205,10 @@ void OnTick() {
     datetime currentBarTime = iTime(_Symbol, Period(), 0);
 
     // --- A. GATHER DATA ---
-    PriceActionData pa = AnalyzePriceAction();
-    OrderFlowData flow = AnalyzeOrderFlow();
+    PriceActionData pa = AnalyzePriceAction(m1Bars);
+    OrderFlowData flow = AnalyzeOrderFlow(m1Bars);
     int trend = GetHigherTFTrend();
-    bool rsiDiv = CheckRSIDivergence();
+    bool rsiDiv = CheckRSIDivergence(m1Bars);
 
     int score = 0;
     string signal = "NONE";
@@ -211,19 +268,19 @@ void OnTick() {
 }
 
 //==================== PRICE ACTION ANALYSIS =========================//
-PriceActionData AnalyzePriceAction() {
+PriceActionData AnalyzePriceAction(const MqlRates &bars[]) {
     PriceActionData pa;
     ZeroMemory(pa);
 
-    double open0 = iOpen(_Symbol, PERIOD_M1, 0);
-    double close0 = iClose(_Symbol, PERIOD_M1, 0);
-    double high0 = iHigh(_Symbol, PERIOD_M1, 0);
-    double low0 = iLow(_Symbol, PERIOD_M1, 0);
+    double open0 = bars[0].open;
+    double close0 = bars[0].close;
+    double high0 = bars[0].high;
+    double low0 = bars[0].low;
 
-    double open1 = iOpen(_Symbol, PERIOD_M1, 1);
-    double close1 = iClose(_Symbol, PERIOD_M1, 1);
-    double high1 = iHigh(_Symbol, PERIOD_M1, 1);
-    double low1 = iLow(_Symbol, PERIOD_M1, 1);
+    double open1 = bars[1].open;
+    double close1 = bars[1].close;
+    double high1 = bars[1].high;
+    double low1 = bars[1].low;
 
     double body0 = MathAbs(close0 - open0);
     double range0 = high0 - low0;
@@ -262,28 +319,32 @@ PriceActionData AnalyzePriceAction() {
 }
 
 //==================== ORDER FLOW ANALYSIS ===========================//
-OrderFlowData AnalyzeOrderFlow() {
+// Closed bars enter the volume window once; the snapshot holds more
+// closed bars than the window, so no bar is missed between ticks.
+void UpdateOrderFlow(const MqlRates &bars[]) {
+    for(int i = M1_SNAPSHOT_BARS - 1; i >= 1; i--) {
+        if(bars[i].time > orderFlowBarTime) {
+            orderFlow.Push(bars[i]);
+            orderFlowBarTime = bars[i].time;
+        }
+    }
+    orderFlow.Forming(bars[0]);
+}
+
+OrderFlowData AnalyzeOrderFlow(const MqlRates &bars[]) {
     OrderFlowData flow;
     ZeroMemory(flow);
 
-    double buyVol = 0, sellVol = 0;
-
-    for(int i = 0; i < 5; i++) {
-        double open = iOpen(_Symbol, PERIOD_M1, i);
-        double close = iClose(_Symbol, PERIOD_M1, i);
-        double vol = (double)iVolume(_Symbol, PERIOD_M1, i);
-
-        if(close > open) buyVol += vol;
-        else sellVol += vol;
-    }
+    double buyVol = orderFlow.BuyVolume();
+    double sellVol = orderFlow.SellVolume();
 
     flow.buyVolume = buyVol;
     flow.sellVolume = sellVol;
     flow.volumeImbalance = (sellVol > 0) ? (buyVol / sellVol) : 1.0;
 
     // Price velocity
-    double price0 = iClose(_Symbol, PERIOD_M1, 0);
-    double price5 = iClose(_Symbol, PERIOD_M1, 5);
+    double price0 = bars[0].close;
+    double price5 = bars[5].close;
     flow.priceVelocity = (price0 - price5) / price5;
 
     // Momentum
@@ -295,11 +356,11 @@ OrderFlowData AnalyzeOrderFlow() {
 }
 
 //==================== RSI DIVERGENCE CHECK ==========================//
-bool CheckRSIDivergence() {
+bool CheckRSIDivergence(const MqlRates &bars[]) {
     if(ArraySize(rsi) < 5) return false;
 
-    double price0 = iClose(_Symbol, PERIOD_M1, 0);
-    double price4 = iClose(_Symbol, PERIOD_M1, 4);
+    double price0 = bars[0].close;
+    double price4 = bars[4].close;
 
     // Bullish divergence: price lower, RSI higher
     if(price0 < price4 && rsi[0] > rsi[4]) return true;
@@ -312,16 +373,7 @@ bool CheckRSIDivergence() {
 
 //==================== HIGHER TIMEFRAME TREND ========================//
 double GetEMA(ENUM_TIMEFRAMES tf, int period) {
-    int h = iMA(_Symbol, tf, period, 0, MODE_EMA, PRICE_CLOSE);
-    if(h == INVALID_HANDLE) return 0;
-
-    double buf[1];
-    if(CopyBuffer(h, 0, 0, 1, buf) <= 0) {
-        IndicatorRelease(h);
-        return 0;
-    }
-    IndicatorRelease(h);
-    return buf[0];
+    return indicatorCache.Value(_Symbol, tf, CACHED_EMA, period);
 }
 
 int GetHigherTFTrend() {
@@ -418,11 +470,8 @@ double GetDynamicLot(double slDistance, double riskPct, string strength) {
     return lot;
 }
 
-ulong OpenOrder(string side, double lot, double sl, double tp, string comment) {
-    MqlTradeRequest request;
-    MqlTradeResult result;
+void BuildOrderRequest(MqlTradeRequest &request, string side, double lot, double sl, double tp, string comment) {
     ZeroMemory(request);
-    ZeroMemory(result);
 
     request.action = TRADE_ACTION_DEAL;
     request.symbol = _Symbol;
@@ -436,22 +485,8 @@ ulong OpenOrder(string side, double lot, double sl, double tp, string comment) {
     request.deviation = Slippage;
     request.magic = MagicNumber;
     request.comment = comment;
-    request.type_filling = ORDER_FILLING_IOC;
-
-    if(!OrderSend(request, result)) {
-        request.type_filling = ORDER_FILLING_FOK;
-        if(!OrderSend(request, result)) {
-            request.type_filling = ORDER_FILLING_RETURN;
-            OrderSend(request, result);
-        }
-    }
-
-    if(result.retcode != TRADE_RETCODE_DONE) {
-        Print("OrderSend failed: ", result.retcode, " - ", result.comment);
-        return 0;
-    }
-
-    return result.order;
+    // Requotes and a refused filling mode are resent by asyncOrders
+    request.type_filling = orderExecutor.Filling();
 }
 
 bool ValidateStops(double entry, double &sl, double &tp, string side) {
@@ -481,7 +516,8 @@ bool CanOpenMorePositions() {
 }
 
 void OpenSmartPositions(string signal, string strength, int score) {
-    int currentOpen = CountOpenPositions();
+    // Orders still on their way count as open positions
+    int currentOpen = CountOpenPositions() + asyncOrders.InFlight() + asyncOrders.Queued();
 
     // Determine the number of positions to open based on score
     int desiredMaxPositions = 0;
@@ -539,9 +575,37 @@ void OpenSmartPositions(string signal, string strength, int score) {
     Print("TP Distance: ", DoubleToString(tpDistance, _Digits));
     Print("========================================");
 
-    int successCount = 0;
+    // Contexts of finished batches are no longer needed
+    for(int b = ArraySize(orderBatches) - 1; b >= 0; b--) {
+        if(asyncOrders.Active(orderBatches[b].batch)) continue;
+        orderBatches[b] = orderBatches[ArraySize(orderBatches) - 1];
+        ArrayResize(orderBatches, ArraySize(orderBatches) - 1);
+    }
+
+    int batch = asyncOrders.BeginBatch(price);
+    int n = ArraySize(orderBatches);
+    ArrayResize(orderBatches, n + 1);
+    orderBatches[n].batch = batch;
+    orderBatches[n].signal = signal;
+    orderBatches[n].strength = strength;
+    orderBatches[n].score = score;
+    orderBatches[n].price = price;
+    orderBatches[n].subs = 0;
+    orderBatches[n].lot = lot;
+
+    int queued = 0;
+
+    // NetOrderMode: the levels ride on one order, see OnOrderAnswer
+    int orders = numToOpen;
+    double volume = lot;
+    if(NetOrderMode && numToOpen > 1) {
+        int subs = numToOpen;
+        volume = virtualPositions.NetVolume(lot, subs);
+        orderBatches[n].subs = subs;
+        orders = 1;
+    }
 
-    for(int i = 0; i < numToOpen; i++) {
+    for(int i = 0; i < orders; i++) {
         double sl, tp;
 
         if(signal == "BUY") {
@@ -559,43 +623,71 @@ void OpenSmartPositions(string signal, string strength, int score) {
 
         string comment = StringFormat("%s_%s_L%d_S%d",
             signal, strength, i+1, score);
+        if(orderBatches[n].subs > 0)
+            comment = StringFormat("%s_%s_NET%d_S%d", signal, strength, orderBatches[n].subs, score);
 
-        ulong ticket = OpenOrder(signal, lot, sl, tp, comment);
-
-        if(ticket > 0) {
-            int size = ArraySize(positions);
-            ArrayResize(positions, size + 1);
-
-            positions[size].ticket = ticket;
-            positions[size].side = signal;
-            positions[size].entryPrice = price;
-            positions[size].lotSize = lot;
-            positions[size].sl = sl;
-            positions[size].tp = tp;
-            positions[size].level = i + 1;
-            positions[size].strength = strength;
-            positions[size].entryScore = score;
-            positions[size].beMovedTo = false;
-            positions[size].trailingActive = false;
-            positions[size].highest = price;
-            positions[size].lowest = price;
-            positions[size].beThreshold = GetBEThreshold(strength);
-            positions[size].trailingStart = GetTrailingStart(strength);
-            positions[size].trailingStep = GetTrailingStep(strength);
-            positions[size].openTime = TimeCurrent();
-
-            Print("✓ Opened L", i+1, " #", ticket);
-            successCount++;
-            stats.totalTrades++;
-            stats.todayTrades++;
-        } else {
-            Print("✗ Failed L", i+1);
-        }
+        MqlTradeRequest request;
+        BuildOrderRequest(request, signal, volume, sl, tp, comment);
+        asyncOrders.Queue(request, orderBatches[n].subs > 0 ? 0 : i + 1);
+        queued++;
+    }
 
-        Sleep(200);
+    // Sends up to MaxOrdersInFlight now, the rest as answers come in
+    asyncOrders.EndBatch();
+    Print("Batch #", batch, ": submitted ", queued, "/", orders, " orders");
+}
+
+// Answer to one order of a batch: track the new position
+void OnOrderAnswer(const AsyncOrderFill &fill) {
+    int b = -1;
+    for(int i = 0; i < ArraySize(orderBatches); i++)
+        if(orderBatches[i].batch == fill.batch) b = i;
+
+    if(!fill.done) {
+        Print("✗ Failed L", fill.tag, ": ", fill.retcode, " - ", fill.comment);
+        return;
     }
+    Print("✓ Opened ", (fill.tag > 0 ? "L" + IntegerToString(fill.tag) : "net"), " #", fill.order, " @ ", DoubleToString(fill.price, _Digits),
+          " (slippage ", DoubleToString(fill.slippage, 1), " pts, ", fill.latency, " ms, ", fill.attempts, " attempt(s))");
+    if(b < 0 || !PositionSelectByTicket(fill.order)) return;
 
-    Print("Successfully opened ", successCount, "/", numToOpen, " positions");
+    if(orderBatches[b].subs == 0) {
+        TrackOpenedLevel(fill.order, b, fill.tag, fill.request.volume, fill.request.sl, fill.request.tp);
+        return;
+    }
+    // A partly filled net order carries the levels its volume covers
+    double lot = orderBatches[b].lot;
+    int subs = MathMin(orderBatches[b].subs, MathMax(1, (int)MathFloor(fill.volume / lot + 0.5)));
+    for(int level = 1; level <= subs; level++)
+        TrackOpenedLevel(virtualPositions.Key(fill.order, level), b, level, lot, fill.request.sl, fill.request.tp);
+    virtualPositions.Open(fill.order, subs);
+}
+
+// One level of a batch opened: a position, or a sub-position of a net order
+void TrackOpenedLevel(ulong ticket, int b, int level, double lot, double sl, double tp) {
+    string strength = orderBatches[b].strength;
+    int size = positionIndex.Find(ticket);
+    if(size < 0) {
+        size = positionIndex.Add(positions, ticket);
+        posState.Add(orderBatches[b].signal == "BUY" ? POSITION_SIDE_BUY : POSITION_SIDE_SELL,
+                     orderBatches[b].price, sl, tp);
+    }
+
+    positions[size].lotSize = lot;
+    positions[size].level = level;
+    positions[size].strength = strength;
+    positions[size].entryScore = orderBatches[b].score;
+    positions[size].openTime = TimeCurrent();
+
+    posState.beThreshold[size] = GetBEThreshold(strength);
+    posState.trailingStart[size] = GetTrailingStart(strength);
+    posState.trailingStep[size] = GetTrailingStep(strength);
+    // Breakeven is skipped for STRONG/VERY_STRONG to let them run
+    if(strength == "STRONG" || strength == "VERY_STRONG")
+        posState.flags[size] |= POSITION_STATE_LET_RUN;
+
+    stats.totalTrades++;
+    stats.todayTrades++;
 }
 
 //==================== POSITION MANAGEMENT ===========================//
@@ -620,105 +712,195 @@ bool ModifyPosition(ulong ticket, double sl, double tp) {
 }
 
 void ManagePositions() {
-    for(int i = ArraySize(positions) - 1; i >= 0; i--) {
-        if(!PositionSelectByTicket(positions[i].ticket)) continue;
-
-        double currentPrice = (positions[i].side == "BUY") ?
-            SymbolInfoDouble(_Symbol, SYMBOL_BID) :
-            SymbolInfoDouble(_Symbol, SYMBOL_ASK);
+    // One pass over the per-tick state; only positions due a breakeven or
+    // trailing move are selected and modified below.
+    posState.Update(SymbolInfoDouble(_Symbol, SYMBOL_BID), SymbolInfoDouble(_Symbol, SYMBOL_ASK));
+    if(virtualPositions.Subs() > 0) CheckVirtualStops();
+    if(virtualStops.Count() > 0) virtualStops.Check(SymbolInfoDouble(_Symbol, SYMBOL_BID), SymbolInfoDouble(_Symbol, SYMBOL_ASK));
 
-        if(positions[i].side == "BUY") {
-            if(currentPrice > positions[i].highest)
-                positions[i].highest = currentPrice;
-        } else {
-            if(currentPrice < positions[i].lowest)
-                positions[i].lowest = currentPrice;
-        }
-
-        double profitPct = (positions[i].side == "BUY") ?
-            (currentPrice - positions[i].entryPrice) / positions[i].entryPrice :
-            (positions[i].entryPrice - currentPrice) / positions[i].entryPrice;
+    for(int i = ArraySize(positions) - 1; i >= 0; i--) {
+        double entry = posState.entry[i];
+        double profitPct = posState.move[i] / entry;
 
         // Breakeven logic (skip for STRONG/VERY_STRONG to let them run)
-        bool skipBE = (positions[i].strength == "STRONG" ||
-                       positions[i].strength == "VERY_STRONG");
+        bool beDue = UseBreakeven && !posState.Has(i, POSITION_STATE_LET_RUN) &&
+                     !posState.Has(i, POSITION_STATE_BE) && profitPct >= posState.beThreshold[i];
+        bool trailDue = UseTrailing && (beDue || posState.Has(i, POSITION_STATE_BE)) &&
+                        profitPct >= posState.trailingStart[i];
+        if(!beDue && !trailDue) continue;
+        if(!PositionSelectByTicket(PositionTicket(i))) continue;
 
-        if(UseBreakeven && !skipBE && !positions[i].beMovedTo &&
-           profitPct >= positions[i].beThreshold) {
+        bool buy = (posState.side[i] == POSITION_SIDE_BUY);
 
-            double newSL = (positions[i].side == "BUY") ?
-                positions[i].entryPrice * (1 + BreakevenOffset) :
-                positions[i].entryPrice * (1 - BreakevenOffset);
+        if(beDue) {
+            double newSL = buy ?
+                entry * (1 + BreakevenOffset) :
+                entry * (1 - BreakevenOffset);
 
             newSL = NormalizeDouble(newSL, _Digits);
 
-            bool shouldMove = (positions[i].side == "BUY" && newSL > positions[i].sl) ||
-                              (positions[i].side == "SELL" && newSL < positions[i].sl);
+            bool shouldMove = (buy && newSL > posState.sl[i]) ||
+                              (!buy && newSL < posState.sl[i]);
 
-            if(shouldMove && ModifyPosition(positions[i].ticket, newSL, positions[i].tp)) {
-                positions[i].sl = newSL;
-                positions[i].beMovedTo = true;
-                Print("✓ BE set #", positions[i].ticket, " @", DoubleToString(newSL, _Digits));
+            if(shouldMove && MoveStop(i, newSL)) {
+                posState.sl[i] = newSL;
+                posState.flags[i] |= POSITION_STATE_BE;
+                Print("✓ BE set #", PositionTicket(i), " @", DoubleToString(newSL, _Digits));
             }
         }
 
         // Trailing stop
-        if(UseTrailing && positions[i].beMovedTo &&
-           profitPct >= positions[i].trailingStart) {
+        if(UseTrailing && posState.Has(i, POSITION_STATE_BE) &&
+           profitPct >= posState.trailingStart[i]) {
 
             double trailingSL;
             bool shouldModify = false;
 
-            if(positions[i].side == "BUY") {
-                trailingSL = positions[i].highest * (1 - positions[i].trailingStep);
+            if(buy) {
+                trailingSL = posState.highest[i] * (1 - posState.trailingStep[i]);
                 trailingSL = NormalizeDouble(trailingSL, _Digits);
-                if(trailingSL > positions[i].sl + (_Point * 5))
+                if(trailingSL > posState.sl[i] + (_Point * 5))
                     shouldModify = true;
             } else {
-                trailingSL = positions[i].lowest * (1 + positions[i].trailingStep);
+                trailingSL = posState.lowest[i] * (1 + posState.trailingStep[i]);
                 trailingSL = NormalizeDouble(trailingSL, _Digits);
-                if(trailingSL < positions[i].sl - (_Point * 5))
+                if(trailingSL < posState.sl[i] - (_Point * 5))
                     shouldModify = true;
             }
 
-            if(shouldModify && ModifyPosition(positions[i].ticket, trailingSL, positions[i].tp)) {
-                positions[i].sl = trailingSL;
-                Print("✓ Trailing #", positions[i].ticket, " -> ", DoubleToString(trailingSL, _Digits));
+            if(shouldModify && MoveStop(i, trailingSL)) {
+                posState.sl[i] = trailingSL;
+                Print("✓ Trailing #", PositionTicket(i), " -> ", DoubleToString(trailingSL, _Digits));
             }
         }
     }
 }
 
-//==================== POSITION SYNC =================================//
-void SyncPositions() {
-    // Remove closed positions
+// Sub-positions whose virtual stop or target was reached are closed off
+// their net position
+void CheckVirtualStops() {
+    double bid = SymbolInfoDouble(_Symbol, SYMBOL_BID);
+    double ask = SymbolInfoDouble(_Symbol, SYMBOL_ASK);
+
     for(int i = ArraySize(positions) - 1; i >= 0; i--) {
-        if(!PositionSelectByTicket(positions[i].ticket)) {
-            double profit = 0;
-
-            if(HistorySelectByPosition(positions[i].ticket)) {
-                for(int j = HistoryDealsTotal() - 1; j >= 0; j--) {
-                    ulong dealTicket = HistoryDealGetTicket(j);
-                    if(HistoryDealGetInteger(dealTicket, DEAL_POSITION_ID) == positions[i].ticket) {
-                        profit += HistoryDealGetDouble(dealTicket, DEAL_PROFIT);
-                    }
-                }
-            }
+        if(virtualPositions.IsVirtual(positions[i].ticket) &&
+           virtualPositions.Hit(posState.side[i], bid, ask, posState.sl[i], posState.tp[i]))
+            virtualPositions.MarkHit(i, positions[i].ticket, positions[i].lotSize);
+    }
+
+    int slots[];
+    double profits[];
+    int closed = virtualPositions.CloseHits(slots, profits);
+    for(int h = 0; h < closed; h++) {
+        Print("✓ Virtual stop L", positions[slots[h]].level, " #", PositionTicket(slots[h]),
+              " P/L ", DoubleToString(profits[h], 2));
+        BookResult(slots[h], profits[h]);
+    }
+}
 
-            stats.totalProfit += profit;
-            stats.todayProfit += profit;
+// Move the stop of "slot": on the server, or in memory for a sub-position
+// and, with UseVirtualStops, for every position
+bool MoveStop(int slot, double sl) {
+    if(virtualPositions.IsVirtual(positions[slot].ticket))
+        return virtualPositions.StopAllowed(posState.side[slot], sl, posState.tp[slot], posState.sl[slot]);
+    if(UseVirtualStops) {
+        virtualStops.Set(positions[slot].ticket, posState.side[slot] == POSITION_SIDE_BUY, sl);
+        return true;
+    }
+    return ModifyPosition(positions[slot].ticket, sl, posState.tp[slot]);
+}
 
-            if(profit > 0) {
-                stats.winningTrades++;
-                stats.consecutiveLosses = 0;
-            } else if(profit < 0) {
-                stats.losingTrades++;
-                stats.consecutiveLosses++;
-            }
+// Real ticket of the position in "slot" (the net order of a sub-position)
+ulong PositionTicket(int slot) {
+    return virtualPositions.Position(positions[slot].ticket);
+}
 
-            ArrayRemove(positions, i, 1);
+//==================== TRADE EVENTS ==================================//
+// Closed positions are booked as their deal arrives; SyncPositions only
+// runs as a periodic safety net
+void OnTradeTransaction(const MqlTradeTransaction &trans, const MqlTradeRequest &request, const MqlTradeResult &result) {
+    AsyncOrderFill fill;
+    if(asyncOrders.OnTransaction(trans, result, fill)) {
+        OnOrderAnswer(fill);
+        return;
+    }
+    if(trans.type == TRADE_TRANSACTION_DEAL_ADD) positionProfit.OnDeal(trans.deal);
+    ulong closed = tradeBook.OnTransaction(trans);
+    if(closed > 0) {
+        int slot = positionIndex.Find(closed);
+        if(slot >= 0) BookClosedPosition(slot);
+        else if(virtualPositions.Has(closed)) BookClosedNetPosition(closed);
+    }
+    else if(trans.type == TRADE_TRANSACTION_DEAL_ADD) {
+        // Our own orders are tracked by OnOrderAnswer with their signal
+        if(!asyncOrders.Busy() && tradeBook.HasPosition(trans.position) && positionIndex.Find(trans.position) < 0 &&
+           !virtualPositions.Has(trans.position) && PositionSelectByTicket(trans.position)) {
+            TrackExternalPosition(trans.position);
         }
     }
+}
+
+void BookClosedPosition(int slot) {
+    BookResult(slot, positionProfit.Take(positions[slot].ticket));
+}
+
+// The net order behind sub-positions is gone: its result beyond the subs'
+// partial closes is shared by the subs still open
+void BookClosedNetPosition(ulong ticket) {
+    int subs;
+    double rest = virtualPositions.Settle(ticket, positionProfit.Take(ticket), subs);
+    if(subs == 0) {
+        stats.totalProfit += rest;
+        stats.todayProfit += rest;
+        return;
+    }
+    for(int i = ArraySize(positions) - 1; i >= 0; i--) {
+        if(virtualPositions.Position(positions[i].ticket) == ticket) BookResult(i, rest / subs);
+    }
+}
+
+void BookResult(int slot, double profit) {
+    stats.totalProfit += profit;
+    stats.todayProfit += profit;
+
+    if(profit > 0) {
+        stats.winningTrades++;
+        stats.consecutiveLosses = 0;
+    } else if(profit < 0) {
+        stats.losingTrades++;
+        stats.consecutiveLosses++;
+    }
+
+    virtualStops.Remove(positions[slot].ticket);
+    positionIndex.RemoveAt(positions, slot);
+    posState.RemoveAt(slot);
+}
+
+// Track the selected position with fallback settings
+void TrackExternalPosition(ulong ticket) {
+    int size = positionIndex.Add(positions, ticket);
+
+    positions[size].lotSize = PositionGetDouble(POSITION_VOLUME);
+    positions[size].level = 1;
+    positions[size].strength = "UNKNOWN";
+    positions[size].openTime = (datetime)PositionGetInteger(POSITION_TIME);
+    positions[size].entryScore = 0;
+
+    posState.Add((PositionGetInteger(POSITION_TYPE) == POSITION_TYPE_BUY) ? POSITION_SIDE_BUY : POSITION_SIDE_SELL,
+                 PositionGetDouble(POSITION_PRICE_OPEN), PositionGetDouble(POSITION_SL), PositionGetDouble(POSITION_TP));
+    posState.beThreshold[size] = 0.0003;
+    posState.trailingStart[size] = 0.0005;
+    posState.trailingStep[size] = 0.0002;
+}
+
+//==================== POSITION SYNC =================================//
+void SyncPositions() {
+    // Remove closed positions
+    for(int i = ArraySize(positions) - 1; i >= 0; i--) {
+        if(i >= ArraySize(positions) || PositionSelectByTicket(PositionTicket(i))) continue;
+        if(virtualPositions.IsVirtual(positions[i].ticket)) BookClosedNetPosition(PositionTicket(i));
+        else BookClosedPosition(i);
+    }
 
     // Add external positions
     for(int i = PositionsTotal() - 1; i >= 0; i--) {
@@ -726,51 +908,16 @@ void SyncPositions() {
         if(ticket > 0 && PositionGetString(POSITION_SYMBOL) == _Symbol &&
            PositionGetInteger(POSITION_MAGIC) == MagicNumber) {
 
-            bool found = false;
-            for(int j = 0; j < ArraySize(positions); j++) {
-                if(positions[j].ticket == ticket) {
-                    found = true;
-                    break;
-                }
-            }
-
-            if(!found) {
-                int size = ArraySize(positions);
-                ArrayResize(positions, size + 1);
-
-                positions[size].ticket = ticket;
-                positions[size].side = (PositionGetInteger(POSITION_TYPE) == POSITION_TYPE_BUY) ? "BUY" : "SELL";
-                positions[size].entryPrice = PositionGetDouble(POSITION_PRICE_OPEN);
-                positions[size].lotSize = PositionGetDouble(POSITION_VOLUME);
-                positions[size].sl = PositionGetDouble(POSITION_SL);
-                positions[size].tp = PositionGetDouble(POSITION_TP);
-                positions[size].level = 1;
-                positions[size].strength = "UNKNOWN";
-                positions[size].beMovedTo = false;
-                positions[size].trailingActive = false;
-                positions[size].highest = positions[size].entryPrice;
-                positions[size].lowest = positions[size].entryPrice;
-                positions[size].beThreshold = 0.0003;
-                positions[size].trailingStart = 0.0005;
-                positions[size].trailingStep = 0.0002;
-                positions[size].openTime = (datetime)PositionGetInteger(POSITION_TIME);
-                positions[size].entryScore = 0;
-            }
+            if(positionIndex.Find(ticket) < 0 && !virtualPositions.Has(ticket)) TrackExternalPosition(ticket);
         }
     }
+    tradeBook.Reconcile();
 }
 
 //==================== UTILITY FUNCTIONS =============================//
 int CountOpenPositions() {
-    int count = 0;
-    for(int i = PositionsTotal() - 1; i >= 0; i--) {
-        ulong ticket = PositionGetTicket(i);
-        if(ticket > 0 && PositionGetString(POSITION_SYMBOL) == _Symbol &&
-           PositionGetInteger(POSITION_MAGIC) == MagicNumber) {
-            count++;
-        }
-    }
-    return count;
+    // a net order counts as its sub-positions
+    return tradeBook.Positions() - virtualPositions.Count() + virtualPositions.Subs();
 }
 
 bool IsTradingSession() {
@@ -828,7 +975,7 @@ void UpdateStats() {
 }
 
 //==================== DISPLAY =======================================//
-void UpdateDisplay() {
+void UpdateDisplay(const MqlRates &bars[]) {
     MqlDateTime dt;
     TimeToStruct(TimeCurrent() + 7 * 3600, dt);
 
@@ -843,14 +990,15 @@ void UpdateDisplay() {
         session = "NY"; sessionColor = "🟢";
     }
 
-    double price = iClose(_Symbol, PERIOD_M1, 0);
+    double price = bars[0].close;
     int openPos = CountOpenPositions();
 
     double currentProfit = 0;
     for(int i = 0; i < ArraySize(positions); i++) {
-        if(PositionSelectByTicket(positions[i].ticket)) {
-            currentProfit += PositionGetDouble(POSITION_PROFIT);
-        }
+        if(!PositionSelectByTicket(PositionTicket(i))) continue;
+        double share = virtualPositions.IsVirtual(positions[i].ticket) ?
+            positions[i].lotSize / PositionGetDouble(POSITION_VOLUME) : 1.0;
+        currentProfit += PositionGetDouble(POSITION_PROFIT) * share;
     }
 
     double winRate = (stats.totalTrades > 0) ?
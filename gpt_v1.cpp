@@ -6,6 +6,14 @@
 #property version   "3.00"
 #property strict
 
+#include "IncrementalIndicators.mqh"
+#include "IndicatorCache.mqh"
+#include "TicketIndex.mqh"
+#include "TradeBook.mqh"
+#include "PositionProfit.mqh"
+#include "VirtualStops.mqh"
+#include "OrderExecutor.mqh"
+
 //==================== INPUT PARAMETERS ==============================//
 input group "=== Trading Settings ===";
 input int      MaxPositions = 3;              // Maximum positions per signal
@@ -38,9 +46,13 @@ input int      MinSignalScore = 2;            // Minimum score to trade
 input group "=== Risk Management ===";
 input int      MagicNumber = 234000;          // Magic Number
 input int      Slippage = 20;                 // Slippage in points
+input int      EntryMaxAttempts = 4;          // Sends per market order on requotes/busy server
+input int      EntryRetryBudgetMs = 1500;     // Time allowed for the retries of an order (ms)
+input int      EntryMaxDriftPoints = 0;       // Max re-price drift from the first quote (0 = Slippage)
 input double   BreakevenOffset = 0.0001;      // Breakeven offset (fractional)
 input bool     UseBreakeven = true;           // Enable Breakeven
 input bool     UseTrailing = true;            // Enable Trailing Stop
+input bool     UseVirtualStops = false;       // BE/trailing stops kept in the EA, entry SL stays on the server
 
 input group "=== Trading Hours (Cambodia UTC+7) ===";
 input bool     UseAsianSession = true;        // Trade Asian Session (00:00-08:00)
@@ -76,9 +88,15 @@ input bool     DisableMultipleSignalsByDefault = true; // safer default
 bool saferDefaultsApplied = false;
 
 //==================== GLOBALS ======================================//
-int emaFastHandle = INVALID_HANDLE, emaSlowHandle = INVALID_HANDLE;
-int rsiHandle = INVALID_HANDLE, bbHandle = INVALID_HANDLE, macdHandle = INVALID_HANDLE;
-double emaFast[], emaSlow[], rsi[], bbUpper[], bbLower[], bbMid[], macdMain[], macdSignal[];
+// M1 indicators, updated incrementally from the bars (no CopyBuffer per tick)
+CIncBarFeed m1Feed;
+CIncEMA emaFast, emaSlow;
+CIncRSI rsi;
+CIncBands bb;
+CIncMACD macd;
+CIncVolume volumeStats;          // 20-bar tick volume (volume filter)
+// ATR/EMA helpers read from live handles kept for the whole run
+CIndicatorCache indicatorCache;
 datetime lastBarTime = 0;
 datetime lastSignalTime = 0;
 string lastSignal = "NONE";
@@ -105,6 +123,11 @@ struct PositionInfo {
 };
 
 PositionInfo positions[];
+CTicketIndex positionIndex;   // ticket -> positions slot
+CTradeBook tradeBook;         // open positions, fed by OnTradeTransaction
+CPositionProfit positionProfit; // net profit per position id, booked per deal
+CVirtualStops virtualStops;   // UseVirtualStops: moved stops of the positions
+COrderExecutor orderExecutor; // market orders: cached filling mode, requote/busy retries
 
 // Strategy settings struct
 struct StrategySettings {
@@ -125,16 +148,6 @@ struct Stats {
    int consecutiveLosses;
 } stats;
 
-//==================== UTIL: Array Remove ============================//
-template<typename T>
-void ArrayRemove(T &arr[], int index, int count = 1) {
-   int size = ArraySize(arr);
-   if(index < 0 || index >= size || count <= 0) return;
-   int removeCount = MathMin(count, size - index);
-   for(int i = index; i < size - removeCount; i++) arr[i] = arr[i + removeCount];
-   ArrayResize(arr, size - removeCount);
-}
-
 //==================== ON INIT ======================================//
 int OnInit() {
    // Apply safer defaults if user left high-risk values
@@ -155,27 +168,21 @@ int OnInit() {
       return(INIT_PARAMETERS_INCORRECT);
    }
 
-   // Create indicator handles (M1 base)
-   emaFastHandle = iMA(_Symbol, PERIOD_M1, EMA_Fast, 0, MODE_EMA, PRICE_CLOSE);
-   emaSlowHandle = iMA(_Symbol, PERIOD_M1, EMA_Slow, 0, MODE_EMA, PRICE_CLOSE);
-   rsiHandle = iRSI(_Symbol, PERIOD_M1, RSI_Period, PRICE_CLOSE);
-   bbHandle = iBands(_Symbol, PERIOD_M1, BB_Period, 0, BB_Deviation, PRICE_CLOSE);
-   macdHandle = iMACD(_Symbol, PERIOD_M1, MACD_Fast, MACD_Slow, MACD_Signal, PRICE_CLOSE);
-
-   if(emaFastHandle == INVALID_HANDLE || emaSlowHandle == INVALID_HANDLE ||
-      rsiHandle == INVALID_HANDLE || bbHandle == INVALID_HANDLE || macdHandle == INVALID_HANDLE) {
-      Print("ERROR: Failed to create indicators!");
-      return(INIT_FAILED);
-   }
-
-   // Initialize arrays (3 values)
-   ArrayResize(emaFast, 3); ArrayResize(emaSlow, 3);
-   ArrayResize(rsi, 3); ArrayResize(bbUpper, 3); ArrayResize(bbLower, 3); ArrayResize(bbMid, 3);
-   ArrayResize(macdMain, 3); ArrayResize(macdSignal, 3);
-
-   ArraySetAsSeries(emaFast, true); ArraySetAsSeries(emaSlow, true);
-   ArraySetAsSeries(rsi, true); ArraySetAsSeries(bbUpper, true); ArraySetAsSeries(bbLower, true);
-   ArraySetAsSeries(bbMid, true); ArraySetAsSeries(macdMain, true); ArraySetAsSeries(macdSignal, true);
+   // Indicators (M1 base)
+   m1Feed.Init(_Symbol, PERIOD_M1);
+   emaFast.Init(EMA_Fast); emaSlow.Init(EMA_Slow);
+   rsi.Init(RSI_Period);
+   bb.Init(BB_Period, BB_Deviation);
+   macd.Init(MACD_Fast, MACD_Slow, MACD_Signal);
+   positionIndex.Reserve(MaxTotalPositions);
+   tradeBook.Init(_Symbol, MagicNumber, MaxTotalPositions);
+   positionProfit.Init(MagicNumber, MaxTotalPositions);
+   virtualStops.Init(_Symbol, MagicNumber, Slippage, MaxTotalPositions);
+   orderExecutor.Init(_Symbol, EntryMaxAttempts, EntryRetryBudgetMs, EntryMaxDriftPoints);
+   volumeStats.Init(20);
+   indicatorCache.Handle(_Symbol, PERIOD_M1, CACHED_ATR, ATR_Period);
+   indicatorCache.Handle(_Symbol, TrendTF1, CACHED_EMA, TrendEMA1);
+   indicatorCache.Handle(_Symbol, TrendTF2, CACHED_EMA, TrendEMA2);
 
    // Initialize stats
    stats.totalSignals = 0; stats.totalTrades = 0; stats.winningTrades = 0; stats.losingTrades = 0; stats.totalProfit = 0; stats.consecutiveLosses = 0;
@@ -200,18 +207,16 @@ int OnInit() {
 
 //==================== ON DEINIT ====================================//
 void OnDeinit(const int reason) {
-   if(emaFastHandle != INVALID_HANDLE) IndicatorRelease(emaFastHandle);
-   if(emaSlowHandle != INVALID_HANDLE) IndicatorRelease(emaSlowHandle);
-   if(rsiHandle != INVALID_HANDLE) IndicatorRelease(rsiHandle);
-   if(bbHandle != INVALID_HANDLE) IndicatorRelease(bbHandle);
-   if(macdHandle != INVALID_HANDLE) IndicatorRelease(macdHandle);
-
    Print("========================================");
    Print("Smart Scalping Bot v3 stopped - Reason: ", GetDeinitReasonText(reason));
    Print("Total Signals: ", stats.totalSignals, " Total Trades: ", stats.totalTrades);
    if(stats.totalTrades > 0) Print("Win Rate: ", DoubleToString(stats.winningTrades * 100.0 / stats.totalTrades, 2), "%");
    Print("Total Profit: ", DoubleToString(stats.totalProfit,2));
+   Print("Indicator cache: ", indicatorCache.Created(), " handles created, ", indicatorCache.Reused(), " creations avoided");
+   Print("Entries: ", orderExecutor.Orders(), " sent, ", orderExecutor.Filled(), " filled (", orderExecutor.Retried(), " after a retry), ", orderExecutor.Failed(), " missed, ", DoubleToString(orderExecutor.AvgAttempts(), 2), " attempts and ", DoubleToString(orderExecutor.AvgMs(), 0), " ms avg, ", orderExecutor.MaxMs(), " ms max, ", orderExecutor.Requotes(), " requotes, ", orderExecutor.Busy(), " busy, ", orderExecutor.Drifted(), " drifted away");
+   if(UseVirtualStops) Print("Virtual stops: ", virtualStops.Moves(), " stop moves kept off the server, ", virtualStops.Closes(), " closes, ", virtualStops.Failed(), " failed");
    Print("========================================");
+   indicatorCache.Release();
 }
 
 string GetDeinitReasonText(int reason) {
@@ -247,8 +252,8 @@ void OnTick() {
       return;
    }
 
-   // Sync
-   SyncPositions();
+   // Sync (closed/new positions arrive in OnTradeTransaction)
+   if(tradeBook.ReconcileDue()) SyncPositions();
 
    // Trading session
    if(!IsTradingSession()) {
@@ -320,37 +325,76 @@ void OnTick() {
 
 //==================== UPDATE INDICATORS ============================//
 bool UpdateIndicators() {
-   if(CopyBuffer(emaFastHandle, 0, 0, 3, emaFast) <= 0) { if(ShowDebugInfo) Print("Failed to copy EMA Fast"); return false; }
-   if(CopyBuffer(emaSlowHandle, 0, 0, 3, emaSlow) <= 0) { if(ShowDebugInfo) Print("Failed to copy EMA Slow"); return false; }
-   if(CopyBuffer(rsiHandle, 0, 0, 3, rsi) <= 0) { if(ShowDebugInfo) Print("Failed to copy RSI"); return false; }
-   if(CopyBuffer(bbHandle, 1, 0, 3, bbUpper) <= 0) { if(ShowDebugInfo) Print("Failed to copy BB Upper"); return false; }
-   if(CopyBuffer(bbHandle, 2, 0, 3, bbLower) <= 0) { if(ShowDebugInfo) Print("Failed to copy BB Lower"); return false; }
-   if(CopyBuffer(bbHandle, 0, 0, 3, bbMid) <= 0) { if(ShowDebugInfo) Print("Failed to copy BB Mid"); return false; }
-   if(CopyBuffer(macdHandle, 0, 0, 3, macdMain) <= 0) { if(ShowDebugInfo) Print("Failed to copy MACD Main"); return false; }
-   if(CopyBuffer(macdHandle, 1, 0, 3, macdSignal) <= 0) { if(ShowDebugInfo) Print("Failed to copy MACD Signal"); return false; }
+   int added = m1Feed.Sync();
+   if(added < 0) { if(ShowDebugInfo) Print("Failed to copy M1 rates"); return false; }
+   if(m1Feed.Restarted()) { emaFast.Reset(); emaSlow.Reset(); rsi.Reset(); bb.Reset(); macd.Reset(); volumeStats.Reset(); }
+   for(int i = 0; i < added; i++) {
+      MqlRates bar = m1Feed.Bar(i);
+      emaFast.Push(bar); emaSlow.Push(bar); rsi.Push(bar); bb.Push(bar); macd.Push(bar); volumeStats.Push(bar);
+   }
+   MqlRates forming = m1Feed.Forming();
+   emaFast.Forming(forming); emaSlow.Forming(forming); rsi.Forming(forming); bb.Forming(forming); macd.Forming(forming);
+   volumeStats.Forming(forming);
    return true;
 }
 
+//==================== TRADE EVENTS =================================//
+// Closed positions are booked as their deal arrives; SyncPositions is
+// only the periodic safety net
+void OnTradeTransaction(const MqlTradeTransaction &trans, const MqlTradeRequest &request, const MqlTradeResult &result) {
+   if(trans.type == TRADE_TRANSACTION_DEAL_ADD) positionProfit.OnDeal(trans.deal);
+   ulong closed = tradeBook.OnTransaction(trans);
+   if(closed > 0) {
+      int slot = positionIndex.Find(closed);
+      if(slot >= 0) BookClosedPosition(slot);
+   }
+   else if(trans.type == TRADE_TRANSACTION_DEAL_ADD) {
+      if(tradeBook.HasPosition(trans.position) && positionIndex.Find(trans.position) < 0 && PositionSelectByTicket(trans.position))
+         TrackExternalPosition(trans.position);
+   }
+   else if(trans.type == TRADE_TRANSACTION_POSITION) {
+      int slot = positionIndex.Find(trans.position);
+      if(slot >= 0) { positions[slot].sl = virtualStops.Stop(trans.position, trans.price_sl); positions[slot].tp = trans.price_tp; }
+   }
+}
+
+void BookClosedPosition(int slot) {
+   // closed profit for stats, net of swap and commission
+   double profit = positionProfit.Take(positions[slot].ticket);
+   stats.totalProfit += profit;
+   if(profit > 0) { stats.winningTrades++; stats.consecutiveLosses = 0; }
+   else if(profit < 0) { stats.losingTrades++; stats.consecutiveLosses++; }
+   if(ShowDebugInfo) Print("Position #", positions[slot].ticket, " closed profit: ", DoubleToString(profit,2));
+   virtualStops.Remove(positions[slot].ticket);
+   positionIndex.RemoveAt(positions, slot);
+}
+
+// Track the selected position with fallback settings
+void TrackExternalPosition(ulong ticket) {
+   int size = positionIndex.Add(positions, ticket);
+   positions[size].side = (PositionGetInteger(POSITION_TYPE) == POSITION_TYPE_BUY) ? "BUY" : "SELL";
+   positions[size].entryPrice = PositionGetDouble(POSITION_PRICE_OPEN);
+   positions[size].lotSize = PositionGetDouble(POSITION_VOLUME);
+   positions[size].sl = PositionGetDouble(POSITION_SL);
+   positions[size].tp = PositionGetDouble(POSITION_TP);
+   positions[size].level = 1;
+   positions[size].strength = "UNKNOWN";
+   positions[size].beMovedTo = false;
+   positions[size].trailingActive = false;
+   positions[size].highest = positions[size].entryPrice;
+   positions[size].lowest = positions[size].entryPrice;
+   positions[size].beThreshold = 0.0003;
+   positions[size].trailingStart = 0.0005;
+   positions[size].trailingStep = 0.0002;
+   positions[size].openTime = (datetime)PositionGetInteger(POSITION_TIME);
+   if(ShowDebugInfo) Print("Added external position #", ticket, " to tracking");
+}
+
 //==================== SYNC POSITIONS ================================//
 void SyncPositions() {
    // remove closed
    for(int i = ArraySize(positions)-1; i >= 0; i--) {
-      if(!PositionSelectByTicket(positions[i].ticket)) {
-         // compute closed profit for stats
-         double profit = 0;
-         if(HistorySelectByPosition(positions[i].ticket)) {
-            for(int j = HistoryDealsTotal() - 1; j >= 0; j--) {
-               ulong dealTicket = HistoryDealGetTicket(j);
-               if(HistoryDealGetInteger(dealTicket, DEAL_POSITION_ID) == positions[i].ticket)
-                  profit += HistoryDealGetDouble(dealTicket, DEAL_PROFIT);
-            }
-         }
-         stats.totalProfit += profit;
-         if(profit > 0) { stats.winningTrades++; stats.consecutiveLosses = 0; }
-         else if(profit < 0) { stats.losingTrades++; stats.consecutiveLosses++; }
-         if(ShowDebugInfo) Print("Position #", positions[i].ticket, " closed profit: ", DoubleToString(profit,2));
-         ArrayRemove(positions, i, 1);
-      }
+      if(!PositionSelectByTicket(positions[i].ticket)) BookClosedPosition(i);
    }
 
    // add external positions with our magic
@@ -358,34 +402,13 @@ void SyncPositions() {
       ulong ticket = PositionGetTicket(i);
       if(ticket > 0) {
          if(PositionGetString(POSITION_SYMBOL) == _Symbol && PositionGetInteger(POSITION_MAGIC) == MagicNumber) {
-            bool found = false;
-            for(int j = 0; j < ArraySize(positions); j++) {
-               if(positions[j].ticket == ticket) { found = true; positions[j].sl = PositionGetDouble(POSITION_SL); positions[j].tp = PositionGetDouble(POSITION_TP); break; }
-            }
-            if(!found) {
-               int size = ArraySize(positions);
-               ArrayResize(positions, size + 1);
-               positions[size].ticket = ticket;
-               positions[size].side = (PositionGetInteger(POSITION_TYPE) == POSITION_TYPE_BUY) ? "BUY" : "SELL";
-               positions[size].entryPrice = PositionGetDouble(POSITION_PRICE_OPEN);
-               positions[size].lotSize = PositionGetDouble(POSITION_VOLUME);
-               positions[size].sl = PositionGetDouble(POSITION_SL);
-               positions[size].tp = PositionGetDouble(POSITION_TP);
-               positions[size].level = 1;
-               positions[size].strength = "UNKNOWN";
-               positions[size].beMovedTo = false;
-               positions[size].trailingActive = false;
-               positions[size].highest = positions[size].entryPrice;
-               positions[size].lowest = positions[size].entryPrice;
-               positions[size].beThreshold = 0.0003;
-               positions[size].trailingStart = 0.0005;
-               positions[size].trailingStep = 0.0002;
-               positions[size].openTime = (datetime)PositionGetInteger(POSITION_TIME);
-               if(ShowDebugInfo) Print("Added external position #", ticket, " to tracking");
-            }
+            int j = positionIndex.Find(ticket);
+            if(j >= 0) { positions[j].sl = virtualStops.Stop(ticket, PositionGetDouble(POSITION_SL)); positions[j].tp = PositionGetDouble(POSITION_TP); }
+            else TrackExternalPosition(ticket);
          }
       }
    }
+   tradeBook.Reconcile();
 }
 
 //==================== SESSION CHECK ================================//
@@ -404,7 +427,7 @@ void AnalyzeSignal(string &signal, string &strength, int &score) {
 
    double close0 = iClose(_Symbol, PERIOD_M1, 0);
    double close1 = iClose(_Symbol, PERIOD_M1, 1);
-   double volume0 = (double)iVolume(_Symbol, PERIOD_M1, 0);
+   double volume0 = volumeStats.Volume();
 
    // 1. EMA Crossover (3 points)
    bool emaBullCross = (emaFast[0] > emaSlow[0] && emaFast[1] <= emaSlow[1]);
@@ -422,24 +445,21 @@ void AnalyzeSignal(string &signal, string &strength, int &score) {
    else if(rsi[0] > RSI_Overbought) { sellScore += 2; if(ShowDebugInfo) Print("SELL: RSI Overbought (+2) rsi=", DoubleToString(rsi[0],2)); }
 
    // 4. BB proximity
-   double bbWidth = bbUpper[0] - bbLower[0];
+   double bbWidth = bb.Upper(0) - bb.Lower(0);
    if(bbWidth > 0) {
-      double closeToLower = (close0 - bbLower[0]) / bbWidth;
-      double closeToUpper = (bbUpper[0] - close0) / bbWidth;
+      double closeToLower = (close0 - bb.Lower(0)) / bbWidth;
+      double closeToUpper = (bb.Upper(0) - close0) / bbWidth;
       if(closeToLower < 0.3) { buyScore += 2; if(ShowDebugInfo) Print("BUY: Near BB Lower (+2)"); }
       else if(closeToUpper < 0.3) { sellScore += 2; if(ShowDebugInfo) Print("SELL: Near BB Upper (+2)"); }
    }
 
    // 5. MACD
-   double macdDiff = macdMain[0] - macdSignal[0];
+   double macdDiff = macd.Main(0) - macd.Signal(0);
    if(macdDiff > 0) { buyScore += 1; if(ShowDebugInfo) Print("BUY: MACD Positive (+1)"); }
    else if(macdDiff < 0) { sellScore += 1; if(ShowDebugInfo) Print("SELL: MACD Negative (+1)"); }
 
    // 6. Volume confirmation using 20-bar average
-double volMA = 0;
-int volBars = MathMin(20, iBars(_Symbol, PERIOD_M1));  // ADDED: Safety check
-for(int i=0; i<volBars; i++) volMA += (double)iVolume(_Symbol, PERIOD_M1, i);
-volMA /= (double)volBars;  // CHANGED: Divide by actual bars counted
+double volMA = volumeStats.Sma();  // average over the bars available, at most 20
 
 if(volMA <= 0) {  // ADDED: Validation
    if(ShowDebugInfo) Print("Invalid volume data - skipping volume filter");
@@ -576,9 +596,7 @@ void OpenSmartPositions(string signal, string strength, int score) {
       ulong ticket = OpenOrder(signal, lotToTrade, sl, tp, comment);
 
       if(ticket > 0) {
-         int size = ArraySize(positions);
-         ArrayResize(positions, size + 1);
-         positions[size].ticket = ticket;
+         int size = positionIndex.Add(positions, ticket);
          positions[size].side = signal;
          positions[size].entryPrice = price;
          positions[size].lotSize = lotToTrade;
@@ -637,17 +655,8 @@ ulong OpenOrder(string side, double lot, double sl, double tp, string comment) {
    request.type = (side == "BUY") ? ORDER_TYPE_BUY : ORDER_TYPE_SELL;
    request.price = (side == "BUY") ? SymbolInfoDouble(_Symbol,SYMBOL_ASK) : SymbolInfoDouble(_Symbol,SYMBOL_BID);
    request.sl = sl; request.tp = tp; request.deviation = Slippage; request.magic = MagicNumber; request.comment = comment;
-   request.type_filling = ORDER_FILLING_IOC;
-
-   if(!OrderSend(request, result)) {
-      request.type_filling = ORDER_FILLING_FOK;
-      if(!OrderSend(request, result)) {
-         request.type_filling = ORDER_FILLING_RETURN;
-         OrderSend(request, result);
-      }
-   }
 
-   if(result.retcode != TRADE_RETCODE_DONE) {
+   if(!orderExecutor.Send(request, result)) {
       Print("OrderSend failed: ", result.retcode, " - ", result.comment);
       Print("Request: ", comment, " ", DoubleToString(lot,2), " @", DoubleToString(request.price,_Digits));
       return 0;
@@ -657,6 +666,7 @@ ulong OpenOrder(string side, double lot, double sl, double tp, string comment) {
 
 //==================== MANAGE POSITIONS (BE & TRAIL) =================//
 void ManagePositions() {
+   if(virtualStops.Count() > 0) virtualStops.Check(SymbolInfoDouble(_Symbol,SYMBOL_BID), SymbolInfoDouble(_Symbol,SYMBOL_ASK));
    for(int i = ArraySize(positions)-1; i >= 0; i--) {
       if(!PositionSelectByTicket(positions[i].ticket)) continue;
 
@@ -674,7 +684,7 @@ void ManagePositions() {
          double newSL = (positions[i].side == "BUY") ? positions[i].entryPrice * (1 + BreakevenOffset) : positions[i].entryPrice * (1 - BreakevenOffset);
          newSL = NormalizeDouble(newSL, _Digits);
          bool shouldMove = (positions[i].side=="BUY" && newSL > positions[i].sl) || (positions[i].side=="SELL" && newSL < positions[i].sl);
-         if(shouldMove && ModifyPosition(positions[i].ticket, newSL, positions[i].tp)) {
+         if(shouldMove && MoveStop(i, newSL)) {
             positions[i].sl = newSL; positions[i].beMovedTo = true;
             Print("✓ Breakeven set #", positions[i].ticket, " @", DoubleToString(newSL,_Digits));
          }
@@ -692,7 +702,7 @@ void ManagePositions() {
             trailingSL = NormalizeDouble(trailingSL, _Digits);
             if(trailingSL < positions[i].sl - (_Point*5)) shouldModify = true;
          }
-         if(shouldModify && ModifyPosition(positions[i].ticket, trailingSL, positions[i].tp)) {
+         if(shouldModify && MoveStop(i, trailingSL)) {
             double oldSL = positions[i].sl; positions[i].sl = trailingSL;
             Print("✓ Trailing updated #", positions[i].ticket, " from ", DoubleToString(oldSL,_Digits), " -> ", DoubleToString(trailingSL,_Digits));
          }
@@ -701,6 +711,12 @@ void ManagePositions() {
 }
 
 //==================== MODIFY POSITION ===============================//
+// Move the stop of "slot": on the server, or in memory with UseVirtualStops
+bool MoveStop(int slot, double sl) {
+   if(UseVirtualStops) { virtualStops.Set(positions[slot].ticket, positions[slot].side == "BUY", sl); return true; }
+   return ModifyPosition(positions[slot].ticket, sl, positions[slot].tp);
+}
+
 bool ModifyPosition(ulong ticket, double sl, double tp) {
    if(!PositionSelectByTicket(ticket)) { Print("Position #", ticket, " not found"); return false; }
    double currentSL = PositionGetDouble(POSITION_SL), currentTP = PositionGetDouble(POSITION_TP);
@@ -716,14 +732,7 @@ bool ModifyPosition(ulong ticket, double sl, double tp) {
 
 //==================== COUNT POSITIONS ===============================//
 int CountOpenPositions() {
-   int count = 0;
-   for(int i=PositionsTotal()-1;i>=0;i--) {
-      ulong ticket = PositionGetTicket(i);
-      if(ticket>0) {
-         if(PositionGetString(POSITION_SYMBOL) == _Symbol && PositionGetInteger(POSITION_MAGIC) == MagicNumber) count++;
-      }
-   }
-   return count;
+   return tradeBook.Positions();
 }
 
 //==================== DISPLAY INFO ================================//
@@ -753,19 +762,11 @@ void UpdateDisplay() {
 
 //==================== ATR / HTF HELPERS ============================//
 double GetATR(ENUM_TIMEFRAMES tf, int period) {
-   int handle = iATR(_Symbol, tf, period);
-   if(handle == INVALID_HANDLE) return 0.0;
-   double buffer[]; ArrayResize(buffer,2); ArraySetAsSeries(buffer,true);
-   if(CopyBuffer(handle,0,0,2,buffer) <= 0) { IndicatorRelease(handle); return 0.0; }
-   IndicatorRelease(handle); return buffer[0];
+   return indicatorCache.Value(_Symbol, tf, CACHED_ATR, period);
 }
 
 double GetEMA(ENUM_TIMEFRAMES tf, int period) {
-   int h = iMA(_Symbol, tf, period, 0, MODE_EMA, PRICE_CLOSE);
-   if(h == INVALID_HANDLE) return 0.0;
-   double buf[]; ArrayResize(buf,2); ArraySetAsSeries(buf,true);
-   if(CopyBuffer(h,0,0,2,buf) <= 0) { IndicatorRelease(h); return 0.0; }
-   IndicatorRelease(h); return buf[0];
+   return indicatorCache.Value(_Symbol, tf, CACHED_EMA, period);
 }
 
 // returns 1 for up, -1 for down, 0 unknown / mixed
@@ -0,0 +1,1013 @@
+//+------------------------------------------------------------------+
+//|                                                          api.cpp |
+//|      Terminal functions: timeseries, indicators, trade, objects   |
+//+------------------------------------------------------------------+
+#include "indicators.h"
+
+#include <cstring>
+
+using mql::Current;
+
+namespace
+{
+//--- index of the bar "shift" positions back from the newest, or -1
+int ShiftIndex(const mql::Series *s, int shift)
+  {
+   if(s == nullptr || shift < 0 || shift >= s->Total())
+      return -1;
+   return s->Total() - 1 - shift;
+  }
+
+mql::Series *SeriesFor(const string &symbol, ENUM_TIMEFRAMES tf)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().series_calls++;
+   mql::Series *s = t.GetSeries(symbol, tf);
+   if(s == nullptr)
+      t.last_error = ERR_MARKET_UNKNOWN_SYMBOL;
+   return s;
+  }
+
+//--- clamp a [start, start+count) request counted from the newest bar;
+//--- returns the chronological index of the oldest bar copied
+int Window(int total, int start, int &count)
+  {
+   if(start < 0 || start >= total || count <= 0)
+      return -1;
+   if(count > total - start)
+      count = total - start;
+   return total - start - count;
+  }
+
+template<typename T>
+const T *Column(const mql::Series *s, mql::SeriesColumn col);
+
+template<>
+const double *Column<double>(const mql::Series *s, mql::SeriesColumn col)
+  {
+   switch(col)
+     {
+      case mql::COL_OPEN:  return s->Open();
+      case mql::COL_HIGH:  return s->High();
+      case mql::COL_LOW:   return s->Low();
+      case mql::COL_CLOSE: return s->Close();
+      default:             return nullptr;
+     }
+  }
+
+template<>
+const long *Column<long>(const mql::Series *s, mql::SeriesColumn col)
+  {
+   switch(col)
+     {
+      case mql::COL_TIME:        return s->Time();
+      case mql::COL_TICK_VOLUME: return s->TickVolume();
+      case mql::COL_REAL_VOLUME: return s->RealVolume();
+      default:                   return nullptr;
+     }
+  }
+
+template<>
+const int *Column<int>(const mql::Series *s, mql::SeriesColumn col)
+  {
+   return col == mql::COL_SPREAD ? s->Spread() : nullptr;
+  }
+
+template<typename T>
+int CopyColumn(const string &symbol, ENUM_TIMEFRAMES tf, mql::SeriesColumn col, int start, int count, std::vector<T> &dst)
+  {
+   mql::Series *s = SeriesFor(symbol, tf);
+   if(s == nullptr)
+      return -1;
+   int first = Window(s->Total(), start, count);
+   const T *src = Column<T>(s, col);
+   if(first < 0 || src == nullptr)
+      return -1;
+   dst.resize((size_t)count);
+   std::memcpy(dst.data(), src + first, sizeof(T) * (size_t)count);
+   return count;
+  }
+
+mql::Indicator *IndicatorFor(int handle)
+  {
+   mql::Terminal &t = Current();
+   mql::Indicator *ind = t.GetIndicator(handle);
+   if(ind == nullptr)
+      t.last_error = ERR_INDICATOR_WRONG_HANDLE;
+   return ind;
+  }
+
+int AddIndicator(const string &symbol, ENUM_TIMEFRAMES tf, mql::Indicator *(*make)(mql::Series *, const void *), const void *args)
+  {
+   mql::Terminal &t = Current();
+   mql::Series *s = t.GetSeries(symbol, tf);
+   if(s == nullptr)
+     {
+      t.last_error = ERR_MARKET_UNKNOWN_SYMBOL;
+      return INVALID_HANDLE;
+     }
+   return t.AddIndicator(make(s, args));
+  }
+}
+
+namespace mql
+{
+int CopySeries(const string &symbol, ENUM_TIMEFRAMES tf, SeriesColumn col, int start, int count, std::vector<double> &dst)
+  {
+   return CopyColumn(symbol, tf, col, start, count, dst);
+  }
+
+int CopySeries(const string &symbol, ENUM_TIMEFRAMES tf, SeriesColumn col, int start, int count, std::vector<long> &dst)
+  {
+   return CopyColumn(symbol, tf, col, start, count, dst);
+  }
+
+int CopySeries(const string &symbol, ENUM_TIMEFRAMES tf, SeriesColumn col, int start, int count, std::vector<int> &dst)
+  {
+   return CopyColumn(symbol, tf, col, start, count, dst);
+  }
+
+int CopySeries(const string &symbol, ENUM_TIMEFRAMES tf, SeriesColumn col, int start, int count, void *dst, size_t capacity)
+  {
+   mql::Series *s = SeriesFor(symbol, tf);
+   if(s == nullptr)
+      return -1;
+   if(count > (int)capacity)
+      count = (int)capacity;
+   int first = Window(s->Total(), start, count);
+   if(first < 0)
+      return -1;
+   const void *src;
+   size_t      width;
+   switch(col)
+     {
+      case COL_TIME:        src = s->Time() + first;       width = sizeof(datetime); break;
+      case COL_OPEN:        src = s->Open() + first;       width = sizeof(double); break;
+      case COL_HIGH:        src = s->High() + first;       width = sizeof(double); break;
+      case COL_LOW:         src = s->Low() + first;        width = sizeof(double); break;
+      case COL_CLOSE:       src = s->Close() + first;      width = sizeof(double); break;
+      case COL_TICK_VOLUME: src = s->TickVolume() + first; width = sizeof(long); break;
+      case COL_REAL_VOLUME: src = s->RealVolume() + first; width = sizeof(long); break;
+      default:              src = s->Spread() + first;     width = sizeof(int); break;
+     }
+   std::memcpy(dst, src, width * (size_t)count);
+   return count;
+  }
+
+int CopyIndicator(int handle, int buffer, int start, int count, std::vector<double> &dst)
+  {
+   Terminal &t = Current();
+   t.Stats().copy_buffer_calls++;
+   Indicator *ind = IndicatorFor(handle);
+   if(ind == nullptr || buffer < 0 || buffer >= ind->Buffers())
+      return -1;
+   int total = ind->Calculate(t.Stats());
+   int first = Window(total, start, count);
+   if(first < 0)
+     {
+      t.last_error = ERR_INDICATOR_DATA_NOT_FOUND;
+      return -1;
+     }
+   dst.resize((size_t)count);
+   std::memcpy(dst.data(), ind->Buffer(buffer) + first, sizeof(double) * (size_t)count);
+   return count;
+  }
+
+int CopyIndicator(int handle, int buffer, int start, int count, double *dst, size_t capacity)
+  {
+   Terminal &t = Current();
+   t.Stats().copy_buffer_calls++;
+   Indicator *ind = IndicatorFor(handle);
+   if(ind == nullptr || buffer < 0 || buffer >= ind->Buffers())
+      return -1;
+   if(count > (int)capacity)
+      count = (int)capacity;
+   int total = ind->Calculate(t.Stats());
+   int first = Window(total, start, count);
+   if(first < 0)
+     {
+      t.last_error = ERR_INDICATOR_DATA_NOT_FOUND;
+      return -1;
+     }
+   std::memcpy(dst, ind->Buffer(buffer) + first, sizeof(double) * (size_t)count);
+   return count;
+  }
+}
+
+//+------------------------------------------------------------------+
+//| Timeseries access                                                |
+//+------------------------------------------------------------------+
+int Bars(const string &symbol, ENUM_TIMEFRAMES timeframe)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   return s != nullptr ? s->Total() : 0;
+  }
+
+int iBars(const string &symbol, ENUM_TIMEFRAMES timeframe)
+  {
+   return Bars(symbol, timeframe);
+  }
+
+datetime iTime(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   int i = ShiftIndex(s, shift);
+   return i < 0 ? 0 : s->Time()[i];
+  }
+
+double iOpen(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   int i = ShiftIndex(s, shift);
+   return i < 0 ? 0.0 : s->Open()[i];
+  }
+
+double iHigh(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   int i = ShiftIndex(s, shift);
+   return i < 0 ? 0.0 : s->High()[i];
+  }
+
+double iLow(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   int i = ShiftIndex(s, shift);
+   return i < 0 ? 0.0 : s->Low()[i];
+  }
+
+double iClose(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   int i = ShiftIndex(s, shift);
+   return i < 0 ? 0.0 : s->Close()[i];
+  }
+
+long iVolume(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift)
+  {
+   return iTickVolume(symbol, timeframe, shift);
+  }
+
+long iTickVolume(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   int i = ShiftIndex(s, shift);
+   return i < 0 ? 0 : s->TickVolume()[i];
+  }
+
+long iRealVolume(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   int i = ShiftIndex(s, shift);
+   return i < 0 ? 0 : s->RealVolume()[i];
+  }
+
+int iSpread(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   int i = ShiftIndex(s, shift);
+   return i < 0 ? 0 : s->Spread()[i];
+  }
+
+static int Extreme(const string &symbol, ENUM_TIMEFRAMES timeframe, int type, int count, int start, bool highest)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   if(s == nullptr || start < 0 || start >= s->Total())
+      return -1;
+   if(count < 0 || count > s->Total() - start)
+      count = s->Total() - start;
+   const double *col = nullptr;
+   switch(type)
+     {
+      case MODE_OPEN:  col = s->Open(); break;
+      case MODE_LOW:   col = s->Low(); break;
+      case MODE_HIGH:  col = s->High(); break;
+      case MODE_CLOSE: col = s->Close(); break;
+      default:         break;
+     }
+   int best = -1;
+   for(int shift = start; shift < start + count; shift++)
+     {
+      int i = s->Total() - 1 - shift;
+      double v = col != nullptr ? col[i] : (double)s->TickVolume()[i];
+      double b = best < 0 ? 0.0 : (col != nullptr ? col[s->Total() - 1 - best] : (double)s->TickVolume()[s->Total() - 1 - best]);
+      if(best < 0 || (highest ? v > b : v < b))
+         best = shift;
+     }
+   return best;
+  }
+
+int iHighest(const string &symbol, ENUM_TIMEFRAMES timeframe, int type, int count, int start)
+  {
+   return Extreme(symbol, timeframe, type, count, start, true);
+  }
+
+int iLowest(const string &symbol, ENUM_TIMEFRAMES timeframe, int type, int count, int start)
+  {
+   return Extreme(symbol, timeframe, type, count, start, false);
+  }
+
+int iBarShift(const string &symbol, ENUM_TIMEFRAMES timeframe, datetime time, bool exact)
+  {
+   mql::Series *s = SeriesFor(symbol, timeframe);
+   if(s == nullptr || s->Total() == 0)
+      return -1;
+   const datetime *t = s->Time();
+   const datetime *it = std::upper_bound(t, t + s->Total(), time);
+   if(it == t)
+      return -1;
+   int index = (int)(it - t) - 1;
+   if(exact && t[index] != time)
+      return -1;
+   return s->Total() - 1 - index;
+  }
+
+bool SymbolInfoTick(const string &symbol, MqlTick &tick)
+  {
+   mql::SymbolState *s = Current().FindSymbol(symbol);
+   if(s == nullptr || !s->has_tick)
+      return false;
+   tick = s->tick;
+   return true;
+  }
+
+int CopyRates(const string &symbol, ENUM_TIMEFRAMES tf, int start, int count, mql::array<MqlRates> &rates)
+  {
+   mql::Series *s = SeriesFor(symbol, tf);
+   if(s == nullptr)
+      return -1;
+   int first = Window(s->Total(), start, count);
+   if(first < 0)
+      return -1;
+   std::vector<MqlRates> &out = rates.Raw();
+   out.resize((size_t)count);
+   for(int i = 0; i < count; i++)
+      s->Rates(first + i, out[(size_t)i]);
+   return count;
+  }
+
+//+------------------------------------------------------------------+
+//| Technical indicators                                             |
+//+------------------------------------------------------------------+
+int iMA(const string &symbol, ENUM_TIMEFRAMES period, int ma_period, int, ENUM_MA_METHOD method, ENUM_APPLIED_PRICE applied_price)
+  {
+   struct Args { int period; ENUM_MA_METHOD method; ENUM_APPLIED_PRICE price; } args = {ma_period, method, applied_price};
+   return AddIndicator(symbol, period, [](mql::Series *s, const void *p) {
+      const Args *a = (const Args *)p;
+      return mql::CreateMA(s, a->period, a->method, a->price);
+   }, &args);
+  }
+
+int iRSI(const string &symbol, ENUM_TIMEFRAMES period, int ma_period, ENUM_APPLIED_PRICE applied_price)
+  {
+   struct Args { int period; ENUM_APPLIED_PRICE price; } args = {ma_period, applied_price};
+   return AddIndicator(symbol, period, [](mql::Series *s, const void *p) {
+      const Args *a = (const Args *)p;
+      return mql::CreateRSI(s, a->period, a->price);
+   }, &args);
+  }
+
+int iATR(const string &symbol, ENUM_TIMEFRAMES period, int ma_period)
+  {
+   return AddIndicator(symbol, period, [](mql::Series *s, const void *p) {
+      return mql::CreateATR(s, *(const int *)p);
+   }, &ma_period);
+  }
+
+int iADX(const string &symbol, ENUM_TIMEFRAMES period, int adx_period)
+  {
+   return AddIndicator(symbol, period, [](mql::Series *s, const void *p) {
+      return mql::CreateADX(s, *(const int *)p);
+   }, &adx_period);
+  }
+
+int iBands(const string &symbol, ENUM_TIMEFRAMES period, int bands_period, int, double deviation, ENUM_APPLIED_PRICE applied_price)
+  {
+   struct Args { int period; double deviation; ENUM_APPLIED_PRICE price; } args = {bands_period, deviation, applied_price};
+   return AddIndicator(symbol, period, [](mql::Series *s, const void *p) {
+      const Args *a = (const Args *)p;
+      return mql::CreateBands(s, a->period, a->deviation, a->price);
+   }, &args);
+  }
+
+int iMACD(const string &symbol, ENUM_TIMEFRAMES period, int fast_ema_period, int slow_ema_period, int signal_period, ENUM_APPLIED_PRICE applied_price)
+  {
+   struct Args { int fast, slow, signal; ENUM_APPLIED_PRICE price; } args = {fast_ema_period, slow_ema_period, signal_period, applied_price};
+   return AddIndicator(symbol, period, [](mql::Series *s, const void *p) {
+      const Args *a = (const Args *)p;
+      return mql::CreateMACD(s, a->fast, a->slow, a->signal, a->price);
+   }, &args);
+  }
+
+bool IndicatorRelease(int handle)
+  {
+   return Current().ReleaseIndicator(handle);
+  }
+
+int BarsCalculated(int handle)
+  {
+   mql::Indicator *ind = IndicatorFor(handle);
+   return ind != nullptr ? ind->Calculate(Current().Stats()) : -1;
+  }
+
+//+------------------------------------------------------------------+
+//| Market and account information                                  |
+//+------------------------------------------------------------------+
+bool SymbolInfoDouble(const string &symbol, ENUM_SYMBOL_INFO_DOUBLE property, double &value)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().symbol_info_calls++;
+   mql::SymbolState *s = t.FindSymbol(symbol);
+   if(s == nullptr)
+     {
+      t.last_error = ERR_MARKET_UNKNOWN_SYMBOL;
+      return false;
+     }
+   const mql::SymbolSpec &spec = s->spec;
+   switch(property)
+     {
+      case SYMBOL_BID:                 value = s->tick.bid; break;
+      case SYMBOL_ASK:                 value = s->tick.ask; break;
+      case SYMBOL_LAST:                value = s->tick.last; break;
+      case SYMBOL_POINT:               value = spec.point; break;
+      case SYMBOL_TRADE_TICK_VALUE:    value = spec.tick_value; break;
+      case SYMBOL_TRADE_TICK_SIZE:     value = spec.tick_size; break;
+      case SYMBOL_TRADE_CONTRACT_SIZE: value = spec.contract_size; break;
+      case SYMBOL_VOLUME_MIN:          value = spec.volume_min; break;
+      case SYMBOL_VOLUME_MAX:          value = spec.volume_max; break;
+      case SYMBOL_VOLUME_STEP:         value = spec.volume_step; break;
+      default:                         value = 0.0; break;
+     }
+   return true;
+  }
+
+double SymbolInfoDouble(const string &symbol, ENUM_SYMBOL_INFO_DOUBLE property)
+  {
+   double value = 0.0;
+   SymbolInfoDouble(symbol, property, value);
+   return value;
+  }
+
+bool SymbolInfoInteger(const string &symbol, ENUM_SYMBOL_INFO_INTEGER property, long &value)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().symbol_info_calls++;
+   mql::SymbolState *s = t.FindSymbol(symbol);
+   if(s == nullptr)
+     {
+      t.last_error = ERR_MARKET_UNKNOWN_SYMBOL;
+      return false;
+     }
+   const mql::SymbolSpec &spec = s->spec;
+   switch(property)
+     {
+      case SYMBOL_SPREAD:             value = std::lround((s->tick.ask - s->tick.bid) / spec.point); break;
+      case SYMBOL_DIGITS:             value = spec.digits; break;
+      case SYMBOL_TRADE_STOPS_LEVEL:  value = spec.stops_level; break;
+      case SYMBOL_TRADE_FREEZE_LEVEL: value = spec.freeze_level; break;
+      case SYMBOL_FILLING_MODE:       value = spec.filling_mode; break;
+      case SYMBOL_TRADE_EXEMODE:      value = spec.execution; break;
+      case SYMBOL_SPREAD_FLOAT:       value = 1; break;
+      case SYMBOL_TIME:               value = s->tick.time; break;
+      case SYMBOL_SELECT:
+      case SYMBOL_VISIBLE:            value = 1; break;
+      default:                        value = 0; break;
+     }
+   return true;
+  }
+
+long SymbolInfoInteger(const string &symbol, ENUM_SYMBOL_INFO_INTEGER property)
+  {
+   long value = 0;
+   SymbolInfoInteger(symbol, property, value);
+   return value;
+  }
+
+string SymbolInfoString(const string &symbol, ENUM_SYMBOL_INFO_STRING property)
+  {
+   mql::SymbolState *s = Current().FindSymbol(symbol);
+   if(s == nullptr)
+      return "";
+   switch(property)
+     {
+      case SYMBOL_DESCRIPTION:     return s->spec.description;
+      case SYMBOL_CURRENCY_BASE:   return s->spec.name.substr(0, 3);
+      case SYMBOL_CURRENCY_PROFIT:
+      case SYMBOL_CURRENCY_MARGIN: return s->spec.name.size() >= 6 ? s->spec.name.substr(3, 3) : Current().Config().currency;
+      default:                     return "";
+     }
+  }
+
+bool SymbolSelect(const string &symbol, bool)
+  {
+   return Current().FindSymbol(symbol) != nullptr;
+  }
+
+double AccountInfoDouble(ENUM_ACCOUNT_INFO_DOUBLE property)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().account_info_calls++;
+   switch(property)
+     {
+      case ACCOUNT_BALANCE:     return t.Balance();
+      case ACCOUNT_PROFIT:      return t.FloatingProfit();
+      case ACCOUNT_EQUITY:      return t.Equity();
+      case ACCOUNT_MARGIN:      return t.Margin();
+      case ACCOUNT_MARGIN_FREE: return t.Equity() - t.Margin();
+      case ACCOUNT_MARGIN_LEVEL:
+        {
+         double margin = t.Margin();
+         return margin > 0 ? t.Equity() / margin * 100.0 : 0.0;
+        }
+      default:                  return 0.0;
+     }
+  }
+
+long AccountInfoInteger(ENUM_ACCOUNT_INFO_INTEGER property)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().account_info_calls++;
+   switch(property)
+     {
+      case ACCOUNT_LOGIN:         return t.Config().login;
+      case ACCOUNT_LEVERAGE:      return t.Config().leverage;
+      case ACCOUNT_MARGIN_MODE:   return ACCOUNT_MARGIN_MODE_RETAIL_HEDGING;
+      case ACCOUNT_TRADE_ALLOWED:
+      case ACCOUNT_TRADE_EXPERT:  return 1;
+      default:                    return 0;
+     }
+  }
+
+string AccountInfoString(ENUM_ACCOUNT_INFO_STRING property)
+  {
+   mql::Terminal &t = Current();
+   switch(property)
+     {
+      case ACCOUNT_NAME:     return t.Config().name;
+      case ACCOUNT_SERVER:   return t.Config().server;
+      case ACCOUNT_CURRENCY: return t.Config().currency;
+      case ACCOUNT_COMPANY:  return t.Config().company;
+     }
+   return "";
+  }
+
+//+------------------------------------------------------------------+
+//| Trade functions                                                  |
+//+------------------------------------------------------------------+
+bool OrderSend(const MqlTradeRequest &request, MqlTradeResult &result)
+  {
+   return Current().Send(request, result);
+  }
+
+bool OrderSendAsync(const MqlTradeRequest &request, MqlTradeResult &result)
+  {
+   return Current().SendAsync(request, result);
+  }
+
+int PositionsTotal()
+  {
+   mql::Terminal &t = Current();
+   t.Stats().position_calls++;
+   return t.PositionCount();
+  }
+
+ulong PositionGetTicket(int index)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().position_calls++;
+   const mql::Position *p = t.PositionAt(index);
+   t.selected_position = p != nullptr ? p->ticket : 0;
+   return t.selected_position;
+  }
+
+string PositionGetSymbol(int index)
+  {
+   return PositionGetTicket(index) != 0 ? PositionGetString(POSITION_SYMBOL) : "";
+  }
+
+bool PositionSelect(const string &symbol)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().position_calls++;
+   const string &name = symbol.empty() ? t.ChartSymbol() : symbol;
+   for(int i = 0; i < t.PositionCount(); i++)
+      if(t.PositionAt(i)->symbol == name)
+        {
+         t.selected_position = t.PositionAt(i)->ticket;
+         return true;
+        }
+   t.last_error = ERR_TRADE_POSITION_NOT_FOUND;
+   return false;
+  }
+
+bool PositionSelectByTicket(ulong ticket)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().position_calls++;
+   if(t.PositionByTicket(ticket) == nullptr)
+     {
+      t.last_error = ERR_TRADE_POSITION_NOT_FOUND;
+      return false;
+     }
+   t.selected_position = ticket;
+   return true;
+  }
+
+static const mql::Position *SelectedPosition()
+  {
+   mql::Terminal &t = Current();
+   t.Stats().position_calls++;
+   const mql::Position *p = t.PositionByTicket(t.selected_position);
+   if(p == nullptr)
+      t.last_error = ERR_TRADE_POSITION_NOT_FOUND;
+   return p;
+  }
+
+double PositionGetDouble(ENUM_POSITION_PROPERTY_DOUBLE property)
+  {
+   const mql::Position *p = SelectedPosition();
+   if(p == nullptr)
+      return 0.0;
+   switch(property)
+     {
+      case POSITION_VOLUME:        return p->volume;
+      case POSITION_PRICE_OPEN:    return p->price_open;
+      case POSITION_SL:            return p->sl;
+      case POSITION_TP:            return p->tp;
+      case POSITION_PRICE_CURRENT: return Current().CurrentPrice(*p);
+      case POSITION_SWAP:          return p->swap;
+      case POSITION_PROFIT:        return Current().PositionProfit(*p);
+     }
+   return 0.0;
+  }
+
+long PositionGetInteger(ENUM_POSITION_PROPERTY_INTEGER property)
+  {
+   const mql::Position *p = SelectedPosition();
+   if(p == nullptr)
+      return 0;
+   switch(property)
+     {
+      case POSITION_TICKET:      return (long)p->ticket;
+      case POSITION_TIME:        return p->time;
+      case POSITION_TIME_MSC:    return p->time_msc;
+      case POSITION_TIME_UPDATE: return p->time_update;
+      case POSITION_TYPE:        return p->type;
+      case POSITION_MAGIC:       return p->magic;
+      case POSITION_IDENTIFIER:  return (long)p->identifier;
+      case POSITION_REASON:      return 3;
+     }
+   return 0;
+  }
+
+string PositionGetString(ENUM_POSITION_PROPERTY_STRING property)
+  {
+   const mql::Position *p = SelectedPosition();
+   if(p == nullptr)
+      return "";
+   return property == POSITION_SYMBOL ? p->symbol : p->comment;
+  }
+
+int OrdersTotal()
+  {
+   mql::Terminal &t = Current();
+   t.Stats().position_calls++;
+   return t.OrderCount();
+  }
+
+ulong OrderGetTicket(int index)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().position_calls++;
+   const mql::Order *o = t.OrderAt(index);
+   t.selected_order = o != nullptr ? o->ticket : 0;
+   return t.selected_order;
+  }
+
+bool OrderSelect(ulong ticket)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().position_calls++;
+   if(t.OrderByTicket(ticket) == nullptr)
+     {
+      t.last_error = ERR_TRADE_ORDER_NOT_FOUND;
+      return false;
+     }
+   t.selected_order = ticket;
+   return true;
+  }
+
+static double OrderDouble(const mql::Order *o, ENUM_ORDER_PROPERTY_DOUBLE property)
+  {
+   if(o == nullptr)
+      return 0.0;
+   switch(property)
+     {
+      case ORDER_VOLUME_INITIAL:  return o->volume_initial;
+      case ORDER_VOLUME_CURRENT:  return o->volume_current;
+      case ORDER_PRICE_OPEN:      return o->price_open;
+      case ORDER_SL:              return o->sl;
+      case ORDER_TP:              return o->tp;
+      case ORDER_PRICE_CURRENT:
+        {
+         mql::SymbolState *s = Current().FindSymbol(o->symbol);
+         if(s == nullptr)
+            return 0.0;
+         bool buy = o->type == ORDER_TYPE_BUY || o->type == ORDER_TYPE_BUY_LIMIT || o->type == ORDER_TYPE_BUY_STOP;
+         return buy ? s->tick.ask : s->tick.bid;
+        }
+      default:                    return 0.0;
+     }
+  }
+
+static long OrderInteger(const mql::Order *o, ENUM_ORDER_PROPERTY_INTEGER property)
+  {
+   if(o == nullptr)
+      return 0;
+   switch(property)
+     {
+      case ORDER_TICKET:          return (long)o->ticket;
+      case ORDER_TIME_SETUP:      return o->time_setup;
+      case ORDER_TYPE:            return o->type;
+      case ORDER_STATE:           return o->state;
+      case ORDER_TIME_EXPIRATION: return o->time_expiration;
+      case ORDER_TIME_DONE:       return o->time_done;
+      case ORDER_TYPE_FILLING:    return o->filling;
+      case ORDER_TYPE_TIME:       return o->type_time;
+      case ORDER_MAGIC:           return o->magic;
+      case ORDER_POSITION_ID:     return (long)o->position_id;
+     }
+   return 0;
+  }
+
+double OrderGetDouble(ENUM_ORDER_PROPERTY_DOUBLE property)
+  {
+   return OrderDouble(Current().OrderByTicket(Current().selected_order), property);
+  }
+
+long OrderGetInteger(ENUM_ORDER_PROPERTY_INTEGER property)
+  {
+   return OrderInteger(Current().OrderByTicket(Current().selected_order), property);
+  }
+
+string OrderGetString(ENUM_ORDER_PROPERTY_STRING property)
+  {
+   const mql::Order *o = Current().OrderByTicket(Current().selected_order);
+   if(o == nullptr)
+      return "";
+   return property == ORDER_SYMBOL ? o->symbol : o->comment;
+  }
+
+bool HistorySelect(datetime from_date, datetime to_date)
+  {
+   Current().SelectHistory(from_date, to_date);
+   return true;
+  }
+
+bool HistorySelectByPosition(long position_id)
+  {
+   Current().SelectHistoryByPosition((ulong)position_id);
+   return true;
+  }
+
+int HistoryDealsTotal()
+  {
+   return Current().SelectedDeals();
+  }
+
+ulong HistoryDealGetTicket(int index)
+  {
+   const mql::Deal *d = Current().SelectedDeal(index);
+   return d != nullptr ? d->ticket : 0;
+  }
+
+bool HistoryDealSelect(ulong ticket)
+  {
+   return Current().DealByTicket(ticket) != nullptr;
+  }
+
+static const mql::Deal *DealFor(ulong ticket)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().history_reads++;
+   const mql::Deal *d = t.DealByTicket(ticket);
+   if(d == nullptr)
+      t.last_error = ERR_TRADE_DEAL_NOT_FOUND;
+   return d;
+  }
+
+double HistoryDealGetDouble(ulong ticket, ENUM_DEAL_PROPERTY_DOUBLE property)
+  {
+   const mql::Deal *d = DealFor(ticket);
+   if(d == nullptr)
+      return 0.0;
+   switch(property)
+     {
+      case DEAL_VOLUME:     return d->volume;
+      case DEAL_PRICE:      return d->price;
+      case DEAL_COMMISSION: return d->commission;
+      case DEAL_SWAP:       return d->swap;
+      case DEAL_PROFIT:     return d->profit;
+      case DEAL_FEE:        return 0.0;
+     }
+   return 0.0;
+  }
+
+long HistoryDealGetInteger(ulong ticket, ENUM_DEAL_PROPERTY_INTEGER property)
+  {
+   const mql::Deal *d = DealFor(ticket);
+   if(d == nullptr)
+      return 0;
+   switch(property)
+     {
+      case DEAL_TICKET:      return (long)d->ticket;
+      case DEAL_ORDER:       return (long)d->order;
+      case DEAL_TIME:        return d->time;
+      case DEAL_TIME_MSC:    return d->time_msc;
+      case DEAL_TYPE:        return d->type;
+      case DEAL_ENTRY:       return d->entry;
+      case DEAL_MAGIC:       return d->magic;
+      case DEAL_REASON:      return d->reason;
+      case DEAL_POSITION_ID: return (long)d->position_id;
+     }
+   return 0;
+  }
+
+string HistoryDealGetString(ulong ticket, ENUM_DEAL_PROPERTY_STRING property)
+  {
+   const mql::Deal *d = DealFor(ticket);
+   if(d == nullptr)
+      return "";
+   return property == DEAL_SYMBOL ? d->symbol : d->comment;
+  }
+
+int HistoryOrdersTotal()
+  {
+   return Current().SelectedOrders();
+  }
+
+ulong HistoryOrderGetTicket(int index)
+  {
+   const mql::Order *o = Current().SelectedOrder(index);
+   return o != nullptr ? o->ticket : 0;
+  }
+
+double HistoryOrderGetDouble(ulong ticket, ENUM_ORDER_PROPERTY_DOUBLE property)
+  {
+   return OrderDouble(Current().HistoryOrderByTicket(ticket), property);
+  }
+
+long HistoryOrderGetInteger(ulong ticket, ENUM_ORDER_PROPERTY_INTEGER property)
+  {
+   return OrderInteger(Current().HistoryOrderByTicket(ticket), property);
+  }
+
+string HistoryOrderGetString(ulong ticket, ENUM_ORDER_PROPERTY_STRING property)
+  {
+   const mql::Order *o = Current().HistoryOrderByTicket(ticket);
+   if(o == nullptr)
+      return "";
+   return property == ORDER_SYMBOL ? o->symbol : o->comment;
+  }
+
+//+------------------------------------------------------------------+
+//| Global variables of the terminal                                 |
+//+------------------------------------------------------------------+
+bool GlobalVariableCheck(const string &name)
+  {
+   return Current().GlobalVariables().count(name) > 0;
+  }
+
+double GlobalVariableGet(const string &name)
+  {
+   mql::Terminal &t = Current();
+   auto it = t.GlobalVariables().find(name);
+   if(it == t.GlobalVariables().end())
+     {
+      t.last_error = ERR_GLOBALVARIABLE_NOT_FOUND;
+      return 0.0;
+     }
+   return it->second;
+  }
+
+datetime GlobalVariableSet(const string &name, double value)
+  {
+   mql::Terminal &t = Current();
+   t.GlobalVariables()[name] = value;
+   return t.Now();
+  }
+
+bool GlobalVariableDel(const string &name)
+  {
+   return Current().GlobalVariables().erase(name) > 0;
+  }
+
+//+------------------------------------------------------------------+
+//| Chart objects                                                    |
+//+------------------------------------------------------------------+
+static mql::ChartObject *FindObject(const string &name)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().object_calls++;
+   auto it = t.Objects().find(name);
+   if(it == t.Objects().end())
+     {
+      t.last_error = ERR_OBJECT_NOT_FOUND;
+      return nullptr;
+     }
+   return &it->second;
+  }
+
+bool ObjectCreate(long, const string &name, ENUM_OBJECT type, int, datetime, double)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().object_calls++;
+   auto result = t.Objects().emplace(name, mql::ChartObject());
+   result.first->second.type = type;
+   return result.second;
+  }
+
+int ObjectFind(long, const string &name)
+  {
+   return FindObject(name) != nullptr ? 0 : -1;
+  }
+
+bool ObjectDelete(long, const string &name)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().object_calls++;
+   return t.Objects().erase(name) > 0;
+  }
+
+int ObjectsDeleteAll(long, const string &prefix, int, int)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().object_calls++;
+   int removed = 0;
+   for(auto it = t.Objects().begin(); it != t.Objects().end();)
+     {
+      if(it->first.compare(0, prefix.size(), prefix) == 0)
+        {
+         it = t.Objects().erase(it);
+         removed++;
+        }
+      else
+         ++it;
+     }
+   return removed;
+  }
+
+int ObjectsTotal(long, int, int)
+  {
+   return (int)Current().Objects().size();
+  }
+
+bool ObjectSetInteger(long, const string &name, ENUM_OBJECT_PROPERTY_INTEGER property, long value)
+  {
+   mql::ChartObject *o = FindObject(name);
+   if(o == nullptr)
+      return false;
+   o->integers[property] = value;
+   return true;
+  }
+
+bool ObjectSetDouble(long, const string &name, ENUM_OBJECT_PROPERTY_DOUBLE property, double value)
+  {
+   mql::ChartObject *o = FindObject(name);
+   if(o == nullptr)
+      return false;
+   o->doubles[property] = value;
+   return true;
+  }
+
+bool ObjectSetString(long, const string &name, ENUM_OBJECT_PROPERTY_STRING property, const string &value)
+  {
+   mql::ChartObject *o = FindObject(name);
+   if(o == nullptr)
+      return false;
+   o->strings[property] = value;
+   return true;
+  }
+
+long ObjectGetInteger(long, const string &name, ENUM_OBJECT_PROPERTY_INTEGER property)
+  {
+   mql::ChartObject *o = FindObject(name);
+   if(o == nullptr)
+      return 0;
+   auto it = o->integers.find(property);
+   return it == o->integers.end() ? 0 : it->second;
+  }
+
+string ObjectGetString(long, const string &name, ENUM_OBJECT_PROPERTY_STRING property)
+  {
+   mql::ChartObject *o = FindObject(name);
+   if(o == nullptr)
+      return "";
+   auto it = o->strings.find(property);
+   return it == o->strings.end() ? "" : it->second;
+  }
+
+void ChartRedraw(long)
+  {
+   Current().Stats().object_calls++;
+  }
@@ -0,0 +1,186 @@
+//+------------------------------------------------------------------+
+//|                                                     backtest.cpp |
+//+------------------------------------------------------------------+
+#include "backtest.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace mql
+{
+namespace
+{
+const size_t TICK_BLOCK = 4096;
+}
+
+size_t SyntheticTickSource::Read(MqlTick *ticks, size_t capacity)
+  {
+   size_t n = 0;
+   while(n < capacity && m_market.Time() < m_until)
+      m_market.Next(ticks[n++]);
+   return n;
+  }
+
+size_t MemoryTickSource::Read(MqlTick *ticks, size_t capacity)
+  {
+   size_t n = std::min(capacity, m_count - m_pos);
+   std::memcpy(ticks, m_ticks + m_pos, n * sizeof(MqlTick));
+   m_pos += n;
+   return n;
+  }
+
+size_t StoreTickSource::Read(MqlTick *ticks, size_t capacity)
+  {
+   size_t n = std::min(capacity, m_end - m_pos);
+   for(size_t i = 0; i < n; i++)
+      m_store.Get(m_pos + i, ticks[i]);
+   m_pos += n;
+   return n;
+  }
+
+size_t BarTickSource::Read(MqlTick *ticks, size_t capacity)
+  {
+   static const int offset[4] = {0, 20, 40, 59};
+   size_t n = 0;
+   for(; n + 4 <= capacity && m_pos < m_end; m_pos++)
+     {
+      MqlRates bar;
+      m_store.Get(m_pos, bar);
+      bool   up = bar.close >= bar.open;
+      double price[4] = {bar.open, up ? bar.low : bar.high, up ? bar.high : bar.low, bar.close};
+      double spread = bar.spread * m_point;
+      for(int k = 0; k < 4; k++)
+        {
+         MqlTick &tick = ticks[n++];
+         tick = MqlTick();
+         tick.time = bar.time + offset[k];
+         tick.time_msc = (long)tick.time * 1000;
+         tick.bid = price[k];
+         tick.ask = price[k] + spread;
+         tick.last = price[k];
+         tick.volume = 1;
+         tick.flags = 6;
+        }
+     }
+   return n;
+  }
+
+Backtest::Backtest(Terminal &terminal, Expert &expert, TickSource &source)
+   : m_terminal(terminal), m_expert(&expert), m_source(source), m_restart_seconds(0)
+  {
+  }
+
+//--- deliver queued trade transactions in order; trades made from
+//--- OnTradeTransaction queue more events, delivered in the same call
+void Backtest::DispatchEvents()
+  {
+   while(m_terminal.HasEvents())
+     {
+      m_terminal.TakeEvents(m_events);
+      for(const TradeEvent &event : m_events)
+        {
+         m_terminal.Stats().transactions++;
+         m_expert->OnTradeTransaction(event.transaction, event.request, event.result);
+        }
+     }
+  }
+
+//--- swap in a fresh instance of the expert; false when its OnInit failed
+bool Backtest::Restart(BacktestReport &report)
+  {
+   m_expert->OnDeinit(REASON_PARAMETERS);
+   DispatchEvents();
+   m_restarted = m_factory();
+   m_expert = m_restarted.get();
+   report.restarts++;
+   report.init_result = m_expert->OnInit();
+   DispatchEvents();
+   if(report.init_result == INIT_SUCCEEDED)
+      return true;
+   report.failed = true;
+   report.error = "OnInit returned " + std::to_string(report.init_result) + " on restart " + std::to_string(report.restarts);
+   m_expert->OnDeinit(REASON_INITFAILED);
+   return false;
+  }
+
+BacktestReport Backtest::Run()
+  {
+   BacktestReport report;
+   Bind(&m_terminal);
+   SymbolState *symbol = m_terminal.FindSymbol("");
+   std::vector<MqlTick> block(TICK_BLOCK);
+   size_t count = symbol != nullptr ? m_source.Read(block.data(), block.size()) : 0;
+   if(count == 0)
+     {
+      report.failed = true;
+      report.error = symbol == nullptr ? "chart symbol is not defined" : "no ticks to replay";
+      return report;
+     }
+
+   //--- the first quote is known before OnInit, as in the terminal
+   symbol->tick = block[0];
+   symbol->has_tick = true;
+   report.first_tick = block[0].time;
+   if(m_on_start)
+      m_on_start(m_terminal);
+   //--- the expert does not see trades made before it was started
+   m_terminal.TakeEvents(m_events);
+
+   auto started = std::chrono::steady_clock::now();
+   try
+     {
+      report.init_result = m_expert->OnInit();
+      DispatchEvents();
+      if(report.init_result != INIT_SUCCEEDED)
+        {
+         report.failed = true;
+         report.error = "OnInit returned " + std::to_string(report.init_result);
+         m_expert->OnDeinit(REASON_INITFAILED);
+        }
+      else
+        {
+         bool     running = true;
+         datetime restart_at = m_restart_seconds > 0 && m_factory ? report.first_tick + m_restart_seconds : 0;
+         while(running && count > 0 && !m_terminal.stop_requested)
+           {
+            for(size_t i = 0; i < count && !m_terminal.stop_requested; i++)
+              {
+               m_terminal.ApplyTick(*symbol, block[i]);
+               if(restart_at > 0 && m_terminal.Now() >= restart_at)
+                 {
+                  //--- the new instance gets this tick as its first one
+                  restart_at += m_restart_seconds;
+                  if(m_terminal.HasEvents())
+                     DispatchEvents();
+                  if(!(running = Restart(report)))
+                     break;
+                 }
+               if(m_terminal.HasEvents())
+                  DispatchEvents();
+               m_expert->OnTick();
+               if(m_terminal.HasEvents())
+                  DispatchEvents();
+              }
+            if(running)
+               count = m_source.Read(block.data(), block.size());
+           }
+         if(running)
+            m_expert->OnDeinit(REASON_PROGRAM);
+        }
+     }
+   catch(const RuntimeError &e)
+     {
+      report.failed = true;
+      report.error = std::string("critical runtime error: ") + e.what();
+     }
+   report.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+   report.last_tick = m_terminal.Now();
+   report.ticks = m_terminal.Stats().ticks;
+   report.ticks_per_second = report.wall_seconds > 0 ? report.ticks / report.wall_seconds : 0.0;
+   report.balance = m_terminal.Balance();
+   report.equity = m_terminal.Equity();
+   report.open_positions = m_terminal.PositionCount();
+   return report;
+  }
+}
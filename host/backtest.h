@@ -0,0 +1,148 @@
+//+------------------------------------------------------------------+
+//|                                                       backtest.h |
+//|                   Tick replay: feeds recorded or synthetic ticks  |
+//+------------------------------------------------------------------+
+// The replay loop is deliberately thin: ticks are pulled from the source
+// in blocks (one virtual call per block, not per tick), the chart symbol
+// is resolved once, and per tick the engine only updates the quote, the
+// bar series and the server-side triggers before calling OnTick. The
+// simulated clock behind TimeCurrent() is the time of the last tick.
+#ifndef EA_HOST_BACKTEST_H
+#define EA_HOST_BACKTEST_H
+
+#include "expert.h"
+#include "store.h"
+#include "synthetic.h"
+
+#include <functional>
+
+namespace mql
+{
+//+------------------------------------------------------------------+
+//| Source of ticks in time order                                    |
+//+------------------------------------------------------------------+
+class TickSource
+  {
+public:
+   virtual          ~TickSource() {}
+   //--- fill up to "capacity" ticks, return how many; 0 = end of data
+   virtual size_t    Read(MqlTick *ticks, size_t capacity) = 0;
+  };
+
+//--- random walk from SyntheticMarket, up to (not including) "until"
+class SyntheticTickSource : public TickSource
+  {
+public:
+                     SyntheticTickSource(SyntheticMarket &market, datetime until)
+      : m_market(market), m_until(until) {}
+   size_t            Read(MqlTick *ticks, size_t capacity) override;
+
+private:
+   SyntheticMarket  &m_market;
+   datetime          m_until;
+  };
+
+//--- ticks already in memory
+class MemoryTickSource : public TickSource
+  {
+public:
+                     MemoryTickSource(const MqlTick *ticks, size_t count)
+      : m_ticks(ticks), m_count(count), m_pos(0) {}
+   size_t            Read(MqlTick *ticks, size_t capacity) override;
+
+private:
+   const MqlTick    *m_ticks;
+   size_t            m_count;
+   size_t            m_pos;
+  };
+
+//--- recorded ticks [begin, end) of a mapped tick store
+class StoreTickSource : public TickSource
+  {
+public:
+                     StoreTickSource(const TickStore &store, size_t begin, size_t end)
+      : m_store(store), m_pos(begin), m_end(end) {}
+   size_t            Read(MqlTick *ticks, size_t capacity) override;
+
+private:
+   const TickStore  &m_store;
+   size_t            m_pos;
+   size_t            m_end;
+  };
+
+//--- four ticks per M1 bar (open, low/high, high/low, close), as the
+//--- strategy tester's "1 minute OHLC" model; for stores without ticks
+class BarTickSource : public TickSource
+  {
+public:
+                     BarTickSource(const BarStore &store, size_t begin, size_t end, double point)
+      : m_store(store), m_pos(begin), m_end(end), m_point(point) {}
+   size_t            Read(MqlTick *ticks, size_t capacity) override;
+
+private:
+   const BarStore   &m_store;
+   size_t            m_pos;
+   size_t            m_end;
+   double            m_point;
+  };
+
+//+------------------------------------------------------------------+
+//| Result of one run                                                |
+//+------------------------------------------------------------------+
+struct BacktestReport
+  {
+   ulong             ticks = 0;
+   double            wall_seconds = 0.0;
+   double            ticks_per_second = 0.0;
+   datetime          first_tick = 0;
+   datetime          last_tick = 0;
+   int               init_result = INIT_SUCCEEDED;
+   bool              failed = false;          // OnInit failed or a critical runtime error
+   std::string       error;
+   double            balance = 0.0;
+   double            equity = 0.0;
+   int               open_positions = 0;
+   int               restarts = 0;            // see Backtest::RestartEvery
+  };
+
+//+------------------------------------------------------------------+
+//| Replay engine                                                    |
+//+------------------------------------------------------------------+
+class Backtest
+  {
+public:
+   //--- ticks from "source" are applied to the terminal's chart symbol
+                     Backtest(Terminal &terminal, Expert &expert, TickSource &source);
+
+   //--- OnInit, OnTick for every tick, OnDeinit; binds the terminal to
+   //--- the calling thread for the duration of the run
+   BacktestReport    Run();
+   //--- called once the first quote is known, before OnInit; used to set
+   //--- up account state the expert finds when it starts
+   void              OnStart(std::function<void(Terminal &)> hook) { m_on_start = std::move(hook); }
+   //--- reload the expert every "seconds" of market time, as a recompile
+   //--- or a change of inputs does: OnDeinit(REASON_PARAMETERS), then a new
+   //--- instance from "factory" and its OnInit; the terminal (positions,
+   //--- global variables, files) carries over, the expert's memory does not
+   void              RestartEvery(int seconds, std::function<std::unique_ptr<Expert>()> factory)
+     {
+      m_restart_seconds = seconds;
+      m_factory = std::move(factory);
+     }
+
+private:
+   void              DispatchEvents();
+   bool              Restart(BacktestReport &report);
+
+   Terminal         &m_terminal;
+   Expert           *m_expert;
+   std::unique_ptr<Expert> m_restarted;    // instance created by Restart()
+   TickSource       &m_source;
+   std::function<void(Terminal &)> m_on_start;
+   int               m_restart_seconds;
+   std::function<std::unique_ptr<Expert>()> m_factory;
+   std::vector<TradeEvent> m_events;       // transactions being delivered
+  };
+}
+
+#endif // EA_HOST_BACKTEST_H
@@ -0,0 +1,93 @@
+//+------------------------------------------------------------------+
+//|                                                  incremental.cpp |
+//|        Checks of IncrementalIndicators.mqh against brute force    |
+//+------------------------------------------------------------------+
+// Built into the host like an expert ("--ea check_incremental"). OnInit
+// feeds CIncExtreme monotone up and down runs, flat runs and random
+// values for a range of periods and skips, and compares every value with
+// the extreme recomputed over the window; any mismatch is printed and
+// fails OnInit, so the host exits with status 1. On success it stops on
+// the first tick.
+#property copyright "Native EA Host"
+#property version   "1.00"
+
+#include "../../IncrementalIndicators.mqh"
+
+input int CheckValues = 120;                // Values pushed per sequence
+
+int checkFailures = 0;
+
+//--- value "i" of sequence "kind": 0 up, 1 down, 2 flat, 3 random
+double CheckValue(int kind, int i, uint &seed)
+  {
+   if(kind == 0)
+      return 100.0 + i;
+   if(kind == 1)
+      return 100.0 - i;
+   if(kind == 2)
+      return 100.0;
+   seed = seed * 1103515245 + 12345;
+   return 100.0 + (double)((seed >> 16) % 21) - 10.0;
+  }
+
+void CheckExtreme(int kind, int period, int skip, bool highest)
+  {
+   CIncExtreme extreme;
+   extreme.Init(period, highest, skip);
+   double values[];
+   ArrayResize(values, CheckValues);
+   uint seed = 7;
+   for(int i = 0; i < CheckValues; i++)
+     {
+      values[i] = CheckValue(kind, i, seed);
+      extreme.Push(values[i]);
+      //--- window: the "period" values before the newest "skip" ones
+      int last = i - skip;
+      if(last - period + 1 < 0)
+        {
+         if(extreme.Ready())
+           {
+            PrintFormat("CIncExtreme kind %d period %d skip %d %s: ready after %d values", kind, period, skip,
+                        highest ? "highest" : "lowest", i + 1);
+            checkFailures++;
+            return;
+           }
+         continue;
+        }
+      double expected = values[last];
+      for(int k = last - period + 1; k < last; k++)
+         expected = highest ? MathMax(expected, values[k]) : MathMin(expected, values[k]);
+      if(!extreme.Ready() || extreme.Value() != expected)
+        {
+         PrintFormat("CIncExtreme kind %d period %d skip %d %s: value %d is %.1f, expected %.1f", kind, period, skip,
+                     highest ? "highest" : "lowest", i, extreme.Value(), expected);
+         checkFailures++;
+         return;
+        }
+     }
+  }
+
+int OnInit()
+  {
+   checkFailures = 0;
+   for(int kind = 0; kind < 4; kind++)
+      for(int period = 1; period <= 25; period++)
+         for(int skip = 0; skip <= 2; skip++)
+           {
+            CheckExtreme(kind, period, skip, true);
+            CheckExtreme(kind, period, skip, false);
+           }
+   if(checkFailures > 0)
+     {
+      Print("check_incremental: ", checkFailures, " failures");
+      return INIT_FAILED;
+     }
+   Print("check_incremental: ok");
+   return INIT_SUCCEEDED;
+  }
+
+void OnTick()
+  {
+   ExpertRemove();
+  }
+//+------------------------------------------------------------------+
@@ -0,0 +1,215 @@
+//+------------------------------------------------------------------+
+//|                                                   indicators.cpp |
+//|        Checks of IncrementalIndicators.mqh against the terminal   |
+//+------------------------------------------------------------------+
+// Built into the host like an expert ("--ea check_indicators"). On every
+// tick each incremental indicator is fed through its own CIncBarFeed,
+// on the chart timeframe and on M1, and every value it keeps, the
+// forming bar included, is compared with CopyBuffer() of the matching
+// iMA/iRSI/iATR/iADX/iBands/iMACD handle. Differences are relative to
+// the value (absolute below 1): the bands of a 60000 price differ from
+// the terminal's by a few units in the last place. One above
+// CheckTolerance is printed and stops the run with SetReturnError(1), so
+// the host exits with status 1. The largest difference of each
+// indicator is printed at the end.
+#property copyright "Native EA Host"
+#property version   "1.00"
+
+#include "../../IncrementalIndicators.mqh"
+
+input double CheckTolerance = 1e-10;        // Largest relative difference accepted
+
+#define CHECK_INDICATORS 6                  // EMA, RSI, ATR, ADX, Bands, MACD
+
+//+------------------------------------------------------------------+
+//| The six indicators on one timeframe and their terminal handles   |
+//+------------------------------------------------------------------+
+class CIndicatorCheck
+  {
+private:
+   ENUM_TIMEFRAMES   m_timeframe;
+   CIncBarFeed       m_feed;
+   CIncEMA           m_ema;
+   CIncRSI           m_rsi;
+   CIncATR           m_atr;
+   CIncADX           m_adx;
+   CIncBands         m_bands;
+   CIncMACD          m_macd;
+   int               m_handles[CHECK_INDICATORS];
+   double            m_maxDiff[CHECK_INDICATORS];
+   double            m_buffer[];
+   double            m_values[];            // the incremental values, shift 0 first
+
+   //--- the first "count" of m_values against "buffer" of indicator
+   //--- "which"; false on a difference above "tolerance"
+   bool              Compare(int which, int buffer, string name, int count, double tolerance)
+     {
+      if(CopyBuffer(m_handles[which], buffer, 0, count, m_buffer) != count)
+        {
+         PrintFormat("%s %s: CopyBuffer failed", EnumToString(m_timeframe), name);
+         return false;
+        }
+      for(int shift = 0; shift < count; shift++)
+        {
+         double diff = MathAbs(m_values[shift] - m_buffer[shift]) / MathMax(MathAbs(m_buffer[shift]), 1.0);
+         m_maxDiff[which] = MathMax(m_maxDiff[which], diff);
+         if(diff > tolerance)
+           {
+            PrintFormat("%s %s[%d] at %s is %.12f, the terminal has %.12f", EnumToString(m_timeframe), name, shift,
+                        TimeToString(TimeCurrent(), TIME_DATE | TIME_SECONDS), m_values[shift], m_buffer[shift]);
+            return false;
+           }
+        }
+      return true;
+     }
+
+public:
+   bool              Init(ENUM_TIMEFRAMES timeframe)
+     {
+      m_timeframe = timeframe;
+      m_feed.Init(_Symbol, timeframe);
+      m_ema.Init(20);
+      m_rsi.Init(14);
+      m_atr.Init(14);
+      m_adx.Init(14);
+      m_bands.Init(20, 2.0);
+      m_macd.Init(12, 26, 9);
+      m_handles[0] = iMA(_Symbol, timeframe, 20, 0, MODE_EMA, PRICE_CLOSE);
+      m_handles[1] = iRSI(_Symbol, timeframe, 14, PRICE_CLOSE);
+      m_handles[2] = iATR(_Symbol, timeframe, 14);
+      m_handles[3] = iADX(_Symbol, timeframe, 14);
+      m_handles[4] = iBands(_Symbol, timeframe, 20, 0, 2.0, PRICE_CLOSE);
+      m_handles[5] = iMACD(_Symbol, timeframe, 12, 26, 9, PRICE_CLOSE);
+      ArraySetAsSeries(m_buffer, true);
+      ArrayResize(m_values, INC_HISTORY + 1);
+      for(int i = 0; i < CHECK_INDICATORS; i++)
+        {
+         m_maxDiff[i] = 0;
+         if(m_handles[i] == INVALID_HANDLE)
+            return false;
+        }
+      return true;
+     }
+   void              Release()
+     {
+      for(int i = 0; i < CHECK_INDICATORS; i++)
+         IndicatorRelease(m_handles[i]);
+     }
+   //--- sync the bars and compare every value kept; false on a mismatch
+   bool              Check(double tolerance)
+     {
+      int added = m_feed.Sync();
+      if(added < 0)
+         return true;
+      if(m_feed.Restarted())
+        {
+         m_ema.Reset();
+         m_rsi.Reset();
+         m_atr.Reset();
+         m_adx.Reset();
+         m_bands.Reset();
+         m_macd.Reset();
+        }
+      for(int i = 0; i < added; i++)
+        {
+         MqlRates bar = m_feed.Bar(i);
+         m_ema.Push(bar);
+         m_rsi.Push(bar);
+         m_atr.Push(bar);
+         m_adx.Push(bar);
+         m_bands.Push(bar);
+         m_macd.Push(bar);
+        }
+      MqlRates forming = m_feed.Forming();
+      m_ema.Forming(forming);
+      m_rsi.Forming(forming);
+      m_atr.Forming(forming);
+      m_adx.Forming(forming);
+      m_bands.Forming(forming);
+      m_macd.Forming(forming);
+
+      int n = m_ema.Count();
+      for(int s = 0; s < n; s++)
+         m_values[s] = m_ema[s];
+      if(!Compare(0, 0, "EMA", n, tolerance))
+         return false;
+      n = m_rsi.Count();
+      for(int s = 0; s < n; s++)
+         m_values[s] = m_rsi[s];
+      if(!Compare(1, 0, "RSI", n, tolerance))
+         return false;
+      n = m_atr.Count();
+      for(int s = 0; s < n; s++)
+         m_values[s] = m_atr[s];
+      if(!Compare(2, 0, "ATR", n, tolerance))
+         return false;
+      n = m_adx.Count();
+      for(int s = 0; s < n; s++)
+         m_values[s] = m_adx[s];
+      if(!Compare(3, 0, "ADX", n, tolerance))
+         return false;
+      n = m_bands.Count();
+      for(int s = 0; s < n; s++)
+         m_values[s] = m_bands.Middle(s);
+      if(!Compare(4, 0, "Bands middle", n, tolerance))
+         return false;
+      for(int s = 0; s < n; s++)
+         m_values[s] = m_bands.Upper(s);
+      if(!Compare(4, 1, "Bands upper", n, tolerance))
+         return false;
+      for(int s = 0; s < n; s++)
+         m_values[s] = m_bands.Lower(s);
+      if(!Compare(4, 2, "Bands lower", n, tolerance))
+         return false;
+      n = m_macd.Count();
+      for(int s = 0; s < n; s++)
+         m_values[s] = m_macd.Main(s);
+      if(!Compare(5, 0, "MACD main", n, tolerance))
+         return false;
+      for(int s = 0; s < n; s++)
+         m_values[s] = m_macd.Signal(s);
+      return Compare(5, 1, "MACD signal", n, tolerance);
+     }
+   void              Report() const
+     {
+      PrintFormat("%s largest differences: EMA %.1e, RSI %.1e, ATR %.1e, ADX %.1e, Bands %.1e, MACD %.1e",
+                  EnumToString(m_timeframe), m_maxDiff[0], m_maxDiff[1], m_maxDiff[2], m_maxDiff[3], m_maxDiff[4],
+                  m_maxDiff[5]);
+     }
+  };
+
+CIndicatorCheck chartCheck, m1Check;
+ulong checkedTicks = 0;
+
+int OnInit()
+  {
+   checkedTicks = 0;
+   if(!chartCheck.Init(_Period) || !m1Check.Init(PERIOD_M1))
+     {
+      Print("check_indicators: indicator handles not created");
+      return INIT_FAILED;
+     }
+   return INIT_SUCCEEDED;
+  }
+
+void OnDeinit(const int reason)
+  {
+   chartCheck.Report();
+   m1Check.Report();
+   Print("check_indicators: ", checkedTicks, " ticks checked");
+   chartCheck.Release();
+   m1Check.Release();
+  }
+
+void OnTick()
+  {
+   if(!chartCheck.Check(CheckTolerance) || !m1Check.Check(CheckTolerance))
+     {
+      Print("check_indicators: mismatch");
+      SetReturnError(1);
+      ExpertRemove();
+      return;
+     }
+   checkedTicks++;
+  }
+//+------------------------------------------------------------------+
@@ -0,0 +1,52 @@
+//+------------------------------------------------------------------+
+//|                                                       expert.cpp |
+//+------------------------------------------------------------------+
+#include "expert.h"
+#include "terminal.h"
+
+#include <map>
+
+namespace mql
+{
+namespace
+{
+std::map<std::string, ExpertFactory> &Registry()
+  {
+   static std::map<std::string, ExpertFactory> registry;
+   return registry;
+  }
+}
+
+ExpertRegistration::ExpertRegistration(const char *name, ExpertFactory factory)
+  {
+   Registry()[name] = factory;
+  }
+
+std::unique_ptr<Expert> CreateExpert(const std::string &name)
+  {
+   auto it = Registry().find(name);
+   if(it == Registry().end())
+      return std::unique_ptr<Expert>();
+   return it->second();
+  }
+
+std::vector<std::string> ExpertNames()
+  {
+   std::vector<std::string> names;
+   for(const auto &entry : Registry())
+      names.push_back(entry.first);
+   return names;
+  }
+
+bool ParseTimeframeInput(ENUM_TIMEFRAMES &v, const std::string &s)
+  {
+   if(ParseTimeframe(s, v))
+      return true;
+   char *end = nullptr;
+   long  n = std::strtol(s.c_str(), &end, 10);
+   if(end == s.c_str() || *end != 0)
+      return false;
+   v = (ENUM_TIMEFRAMES)n;
+   return true;
+  }
+}
@@ -0,0 +1,104 @@
+//+------------------------------------------------------------------+
+//|                                                         expert.h |
+//|                  Base class and registry for translated experts   |
+//+------------------------------------------------------------------+
+// mq5pp wraps each EA source in a class derived from mql::Expert: the
+// EA's globals become members, its functions member functions (so the
+// MQL5 rule that functions may be called before their definition holds)
+// and OnInit/OnTick/... override the virtual event handlers below.
+#ifndef EA_HOST_EXPERT_H
+#define EA_HOST_EXPERT_H
+
+#include "mql5.h"
+
+#include <cstdlib>
+#include <memory>
+
+namespace mql
+{
+class Expert
+  {
+public:
+   virtual          ~Expert() {}
+
+   virtual int       OnInit() { return INIT_SUCCEEDED; }
+   virtual void      OnDeinit(const int reason) { (void)reason; }
+   virtual void      OnTick() {}
+   virtual void      OnTimer() {}
+   virtual void      OnTrade() {}
+   virtual void      OnTradeTransaction(const MqlTradeTransaction &trans, const MqlTradeRequest &request,
+                                        const MqlTradeResult &result)
+     {
+      (void)trans;
+      (void)request;
+      (void)result;
+     }
+
+   //--- input parameters, generated from the EA's "input" declarations
+   virtual bool      SetInput(const std::string &name, const std::string &value)
+     {
+      (void)name;
+      (void)value;
+      return false;
+     }
+   virtual void      ListInputs(std::vector<std::pair<std::string, std::string>> &inputs) const { (void)inputs; }
+  };
+
+typedef std::unique_ptr<Expert> (*ExpertFactory)();
+
+struct ExpertRegistration
+  {
+   ExpertRegistration(const char *name, ExpertFactory factory);
+  };
+
+std::unique_ptr<Expert> CreateExpert(const std::string &name);
+std::vector<std::string> ExpertNames();
+
+//+------------------------------------------------------------------+
+//| Input conversion                                                 |
+//+------------------------------------------------------------------+
+inline bool ParseInput(double &v, const std::string &s) { v = std::strtod(s.c_str(), nullptr); return true; }
+inline bool ParseInput(std::string &v, const std::string &s) { v = s; return true; }
+inline bool ParseInput(bool &v, const std::string &s)
+  {
+   v = (s == "true" || s == "1" || s == "TRUE" || s == "True");
+   return true;
+  }
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value, bool>::type ParseInput(T &v, const std::string &s)
+  {
+   v = (T)std::strtoll(s.c_str(), nullptr, 10);
+   return true;
+  }
+bool ParseTimeframeInput(ENUM_TIMEFRAMES &v, const std::string &s);
+inline bool ParseInput(ENUM_TIMEFRAMES &v, const std::string &s) { return ParseTimeframeInput(v, s); }
+template<typename E>
+typename std::enable_if<std::is_enum<E>::value, bool>::type ParseInput(E &v, const std::string &s)
+  {
+   char *end = nullptr;
+   long  n = std::strtol(s.c_str(), &end, 10);
+   if(end != s.c_str() && *end == 0)
+     {
+      v = (E)n;
+      return true;
+     }
+   //--- accept the enumerator name; EnumToString is found by ADL
+   for(int i = 0; i < 256; i++)
+      if(EnumToString((E)i) == s)
+        {
+         v = (E)i;
+         return true;
+        }
+   return false;
+  }
+
+inline std::string FormatInput(double v)             { return FormatDouble(v); }
+inline std::string FormatInput(const std::string &v) { return v; }
+inline std::string FormatInput(bool v)               { return v ? "true" : "false"; }
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value, std::string>::type FormatInput(T v) { return std::to_string(v); }
+template<typename E>
+typename std::enable_if<std::is_enum<E>::value, std::string>::type FormatInput(E v) { return EnumToString(v); }
+}
+
+#endif // EA_HOST_EXPERT_H
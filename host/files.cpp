@@ -0,0 +1,304 @@
+//+------------------------------------------------------------------+
+//|                                                        files.cpp |
+//|          File functions on the terminal's sandbox directory       |
+//+------------------------------------------------------------------+
+// Handles and the sandbox belong to the Terminal (see Terminal::OpenFile).
+// Strings are written as the bytes they hold: FILE_UNICODE/FILE_ANSI and
+// the codepage are accepted and ignored, CSV files read and write lines.
+#include "terminal.h"
+
+#include <filesystem>
+#include <unistd.h>
+
+using mql::Current;
+
+namespace
+{
+mql::FileHandle *Handle(int handle)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().file_calls++;
+   return t.GetFile(handle);
+  }
+
+mql::FileHandle *Writable(int handle)
+  {
+   mql::FileHandle *file = Handle(handle);
+   if(file != nullptr && (file->flags & FILE_WRITE) == 0)
+     {
+      Current().last_error = ERR_FILE_NOTTOWRITE;
+      return nullptr;
+     }
+   return file;
+  }
+
+mql::FileHandle *Readable(int handle)
+  {
+   mql::FileHandle *file = Handle(handle);
+   if(file != nullptr && (file->flags & FILE_READ) == 0)
+     {
+      Current().last_error = ERR_FILE_NOTTOREAD;
+      return nullptr;
+     }
+   return file;
+  }
+
+uint Write(int handle, const void *data, size_t size)
+  {
+   mql::FileHandle *file = Writable(handle);
+   if(file == nullptr)
+      return 0;
+   size_t n = std::fwrite(data, 1, size, file->stream);
+   if(n != size)
+      Current().last_error = ERR_FILE_WRITEERROR;
+   return (uint)n;
+  }
+
+bool Read(int handle, void *data, size_t size)
+  {
+   mql::FileHandle *file = Readable(handle);
+   if(file == nullptr)
+      return false;
+   if(std::fread(data, 1, size, file->stream) != size)
+     {
+      Current().last_error = ERR_FILE_READERROR;
+      return false;
+     }
+   return true;
+  }
+}
+
+namespace mql
+{
+uint FileWriteBytes(int handle, const void *data, size_t size)
+  {
+   return Write(handle, data, size);
+  }
+
+uint FileReadBytes(int handle, void *data, size_t size)
+  {
+   return Read(handle, data, size) ? (uint)size : 0;
+  }
+}
+
+int FileOpen(const string &name, int flags, short delimiter, uint codepage)
+  {
+   (void)delimiter;
+   (void)codepage;
+   mql::Terminal &t = Current();
+   t.Stats().file_calls++;
+   return t.OpenFile(name, flags);
+  }
+
+void FileClose(int handle)
+  {
+   mql::Terminal &t = Current();
+   t.Stats().file_calls++;
+   t.CloseFile(handle);
+  }
+
+//--- written through to the disk, not only to the OS cache
+void FileFlush(int handle)
+  {
+   mql::FileHandle *file = Handle(handle);
+   if(file == nullptr)
+      return;
+   Current().Stats().file_flushes++;
+   std::fflush(file->stream);
+   fsync(fileno(file->stream));
+  }
+
+bool FileIsExist(const string &name, int common_flag)
+  {
+   (void)common_flag;
+   mql::Terminal &t = Current();
+   t.Stats().file_calls++;
+   std::string path = t.FilePath(name);
+   std::error_code ec;
+   if(path.empty() || !std::filesystem::is_regular_file(path, ec))
+     {
+      t.last_error = ERR_FILE_NOT_EXIST;
+      return false;
+     }
+   return true;
+  }
+
+bool FileDelete(const string &name, int common_flag)
+  {
+   (void)common_flag;
+   mql::Terminal &t = Current();
+   t.Stats().file_calls++;
+   std::string path = t.FilePath(name);
+   std::error_code ec;
+   if(path.empty() || !std::filesystem::remove(path, ec))
+     {
+      t.last_error = ec ? ERR_CANNOT_DELETE_FILE : ERR_FILE_NOT_EXIST;
+      return false;
+     }
+   return true;
+  }
+
+//--- a rename: with FILE_REWRITE an existing target is replaced atomically
+bool FileMove(const string &src_name, int common_flag, const string &dst_name, int mode_flags)
+  {
+   (void)common_flag;
+   mql::Terminal &t = Current();
+   t.Stats().file_calls++;
+   std::string src = t.FilePath(src_name);
+   std::string dst = t.FilePath(dst_name);
+   std::error_code ec;
+   if(src.empty() || dst.empty())
+     {
+      t.last_error = ERR_WRONG_FILENAME;
+      return false;
+     }
+   if(!std::filesystem::is_regular_file(src, ec))
+     {
+      t.last_error = ERR_FILE_NOT_EXIST;
+      return false;
+     }
+   if((mode_flags & FILE_REWRITE) == 0 && std::filesystem::exists(dst, ec))
+     {
+      t.last_error = ERR_FILE_CANNOT_REWRITE;
+      return false;
+     }
+   if(std::rename(src.c_str(), dst.c_str()) != 0)
+     {
+      t.last_error = ERR_FILE_CANNOT_REWRITE;
+      return false;
+     }
+   return true;
+  }
+
+ulong FileSize(int handle)
+  {
+   mql::FileHandle *file = Handle(handle);
+   if(file == nullptr)
+      return 0;
+   std::fflush(file->stream);
+   long position = std::ftell(file->stream);
+   std::fseek(file->stream, 0, SEEK_END);
+   long size = std::ftell(file->stream);
+   std::fseek(file->stream, position, SEEK_SET);
+   return size > 0 ? (ulong)size : 0;
+  }
+
+ulong FileTell(int handle)
+  {
+   mql::FileHandle *file = Handle(handle);
+   if(file == nullptr)
+      return 0;
+   long position = std::ftell(file->stream);
+   return position > 0 ? (ulong)position : 0;
+  }
+
+bool FileSeek(int handle, long offset, int origin)
+  {
+   mql::FileHandle *file = Handle(handle);
+   return file != nullptr && std::fseek(file->stream, offset, origin) == 0;
+  }
+
+bool FileIsEnding(int handle)
+  {
+   mql::FileHandle *file = Handle(handle);
+   if(file == nullptr)
+      return true;
+   int c = std::fgetc(file->stream);
+   if(c == EOF)
+      return true;
+   std::ungetc(c, file->stream);
+   return false;
+  }
+
+//--- CHAR_VALUE, SHORT_VALUE or INT_VALUE low bytes of "value"
+uint FileWriteInteger(int handle, int value, int size)
+  {
+   if(size != CHAR_VALUE && size != SHORT_VALUE)
+      size = INT_VALUE;
+   return Write(handle, &value, (size_t)size);
+  }
+
+uint FileWriteLong(int handle, long value)
+  {
+   return Write(handle, &value, sizeof(value));
+  }
+
+uint FileWriteDouble(int handle, double value)
+  {
+   return Write(handle, &value, sizeof(value));
+  }
+
+//--- binary files: "length" characters (padded with zeros), or the whole
+//--- string without a terminator; text files: the string as it is
+uint FileWriteString(int handle, const string &text, int length)
+  {
+   if(length < 0 || (size_t)length <= text.size())
+      return Write(handle, text.data(), length < 0 ? text.size() : (size_t)length);
+   std::string padded = text;
+   padded.resize((size_t)length, '\0');
+   return Write(handle, padded.data(), padded.size());
+  }
+
+int FileReadInteger(int handle, int size)
+  {
+   if(size != CHAR_VALUE && size != SHORT_VALUE)
+      size = INT_VALUE;
+   if(size == CHAR_VALUE)
+     {
+      signed char v = 0;
+      return Read(handle, &v, sizeof(v)) ? v : 0;
+     }
+   if(size == SHORT_VALUE)
+     {
+      short v = 0;
+      return Read(handle, &v, sizeof(v)) ? v : 0;
+     }
+   int v = 0;
+   return Read(handle, &v, sizeof(v)) ? v : 0;
+  }
+
+long FileReadLong(int handle)
+  {
+   long v = 0;
+   return Read(handle, &v, sizeof(v)) ? v : 0;
+  }
+
+double FileReadDouble(int handle)
+  {
+   double v = 0;
+   return Read(handle, &v, sizeof(v)) ? v : 0.0;
+  }
+
+//--- binary files need the length (trailing zeros are dropped); text
+//--- files return the next line
+string FileReadString(int handle, int length)
+  {
+   mql::FileHandle *file = Readable(handle);
+   if(file == nullptr)
+      return "";
+   std::string text;
+   if((file->flags & FILE_BIN) != 0)
+     {
+      if(length < 0)
+        {
+         Current().last_error = ERR_FILE_BINSTRINGSIZE;
+         return "";
+        }
+      text.resize((size_t)length);
+      if(std::fread(&text[0], 1, text.size(), file->stream) != text.size())
+        {
+         Current().last_error = ERR_FILE_READERROR;
+         return "";
+        }
+      size_t end = text.find('\0');
+      if(end != std::string::npos)
+         text.resize(end);
+      return text;
+     }
+   int c;
+   while((c = std::fgetc(file->stream)) != EOF && c != '\n')
+      text.push_back((char)c);
+   if(!text.empty() && text.back() == '\r')
+      text.pop_back();
+   return text;
+  }
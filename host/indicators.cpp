@@ -0,0 +1,395 @@
+//+------------------------------------------------------------------+
+//|                                                   indicators.cpp |
+//+------------------------------------------------------------------+
+#include "indicators.h"
+
+namespace mql
+{
+//+------------------------------------------------------------------+
+//| Base                                                             |
+//+------------------------------------------------------------------+
+Indicator::Indicator(Series *series, int buffers)
+   : m_series(series), m_buffers((size_t)buffers), m_calculated(0), m_version(0)
+  {
+  }
+
+int Indicator::Calculate(HostStats &stats)
+  {
+   int total = m_series->Total();
+   if(m_calculated == total && m_version == m_series->Version())
+      return total;
+   //--- the previously forming bar may have changed or closed since
+   int from = (m_calculated > 0) ? m_calculated - 1 : 0;
+   if(from > total)
+      from = 0;
+   for(auto &buffer : m_buffers)
+      buffer.resize((size_t)total);
+   Compute(from, total);
+   stats.indicator_bars_computed += (ulong)(total - from);
+   m_calculated = total;
+   m_version = m_series->Version();
+   return total;
+  }
+
+double Indicator::Price(ENUM_APPLIED_PRICE type, int i) const
+  {
+   switch(type)
+     {
+      case PRICE_OPEN:     return m_series->Open()[i];
+      case PRICE_HIGH:     return m_series->High()[i];
+      case PRICE_LOW:      return m_series->Low()[i];
+      case PRICE_MEDIAN:   return (m_series->High()[i] + m_series->Low()[i]) / 2.0;
+      case PRICE_TYPICAL:  return (m_series->High()[i] + m_series->Low()[i] + m_series->Close()[i]) / 3.0;
+      case PRICE_WEIGHTED: return (m_series->High()[i] + m_series->Low()[i] + 2.0 * m_series->Close()[i]) / 4.0;
+      default:             return m_series->Close()[i];
+     }
+  }
+
+namespace
+{
+//+------------------------------------------------------------------+
+//| Moving Average                                                   |
+//+------------------------------------------------------------------+
+class MovingAverage : public Indicator
+  {
+public:
+   MovingAverage(Series *series, int period, ENUM_MA_METHOD method, ENUM_APPLIED_PRICE price)
+      : Indicator(series, 1), m_period(period < 1 ? 1 : period), m_method(method), m_price(price) {}
+
+protected:
+   void Compute(int from, int to) override
+     {
+      double *ma = m_buffers[0].data();
+      int     n = m_period;
+      for(int i = from; i < to; i++)
+        {
+         double p = Price(m_price, i);
+         switch(m_method)
+           {
+            case MODE_EMA:
+              {
+               double k = 2.0 / (n + 1.0);
+               ma[i] = (i == 0) ? p : p * k + ma[i - 1] * (1.0 - k);
+               break;
+              }
+            case MODE_SMMA:
+               if(i < n - 1)
+                  ma[i] = 0.0;
+               else if(i == n - 1)
+                  ma[i] = WindowAverage(i);
+               else
+                  ma[i] = (ma[i - 1] * (n - 1) + p) / n;
+               break;
+            case MODE_LWMA:
+              {
+               if(i < n - 1)
+                 {
+                  ma[i] = 0.0;
+                  break;
+                 }
+               double sum = 0.0;
+               for(int k = 0; k < n; k++)
+                  sum += Price(m_price, i - k) * (n - k);
+               ma[i] = sum / (n * (n + 1) / 2.0);
+               break;
+              }
+            default:
+               if(i < n - 1)
+                  ma[i] = 0.0;
+               else if(i == n - 1)
+                  ma[i] = WindowAverage(i);
+               else
+                  ma[i] = ma[i - 1] + (p - Price(m_price, i - n)) / n;
+               break;
+           }
+        }
+     }
+
+private:
+   double WindowAverage(int i) const
+     {
+      double sum = 0.0;
+      for(int k = 0; k < m_period; k++)
+         sum += Price(m_price, i - k);
+      return sum / m_period;
+     }
+
+   int                m_period;
+   ENUM_MA_METHOD     m_method;
+   ENUM_APPLIED_PRICE m_price;
+  };
+
+//+------------------------------------------------------------------+
+//| Relative Strength Index (Wilder smoothing)                       |
+//+------------------------------------------------------------------+
+class RSI : public Indicator
+  {
+public:
+   RSI(Series *series, int period, ENUM_APPLIED_PRICE price)
+      : Indicator(series, 1), m_period(period < 1 ? 1 : period), m_price(price) {}
+
+protected:
+   void Compute(int from, int to) override
+     {
+      m_pos.resize((size_t)to);
+      m_neg.resize((size_t)to);
+      double *rsi = m_buffers[0].data();
+      int     n = m_period;
+      if(from <= n)
+        {
+         for(int i = 0; i < std::min(to, n); i++)
+            rsi[i] = m_pos[i] = m_neg[i] = 0.0;
+         if(to <= n)
+            return;
+         double up = 0.0, down = 0.0;
+         for(int i = 1; i <= n; i++)
+           {
+            double diff = Price(m_price, i) - Price(m_price, i - 1);
+            up += diff > 0 ? diff : 0.0;
+            down += diff < 0 ? -diff : 0.0;
+           }
+         m_pos[n] = up / n;
+         m_neg[n] = down / n;
+         rsi[n] = Value(m_pos[n], m_neg[n]);
+         from = n + 1;
+        }
+      for(int i = from; i < to; i++)
+        {
+         double diff = Price(m_price, i) - Price(m_price, i - 1);
+         m_pos[i] = (m_pos[i - 1] * (n - 1) + (diff > 0 ? diff : 0.0)) / n;
+         m_neg[i] = (m_neg[i - 1] * (n - 1) + (diff < 0 ? -diff : 0.0)) / n;
+         rsi[i] = Value(m_pos[i], m_neg[i]);
+        }
+     }
+
+private:
+   static double Value(double pos, double neg)
+     {
+      if(neg != 0.0)
+         return 100.0 - 100.0 / (1.0 + pos / neg);
+      return pos != 0.0 ? 100.0 : 50.0;
+     }
+
+   int                m_period;
+   ENUM_APPLIED_PRICE m_price;
+   std::vector<double> m_pos;
+   std::vector<double> m_neg;
+  };
+
+//+------------------------------------------------------------------+
+//| Average True Range (simple average of TR, as the stock ATR)      |
+//+------------------------------------------------------------------+
+class ATR : public Indicator
+  {
+public:
+   ATR(Series *series, int period) : Indicator(series, 1), m_period(period < 1 ? 1 : period) {}
+
+protected:
+   void Compute(int from, int to) override
+     {
+      m_tr.resize((size_t)to);
+      const double *h = m_series->High();
+      const double *l = m_series->Low();
+      const double *c = m_series->Close();
+      double *atr = m_buffers[0].data();
+      int     n = m_period;
+      for(int i = from; i < to; i++)
+        {
+         m_tr[i] = (i == 0) ? 0.0 : std::max(h[i], c[i - 1]) - std::min(l[i], c[i - 1]);
+         if(i < n)
+            atr[i] = 0.0;
+         else if(i == n)
+           {
+            double sum = 0.0;
+            for(int k = 1; k <= n; k++)
+               sum += m_tr[k];
+            atr[i] = sum / n;
+           }
+         else
+            atr[i] = atr[i - 1] + (m_tr[i] - m_tr[i - n]) / n;
+        }
+     }
+
+private:
+   int                m_period;
+   std::vector<double> m_tr;
+  };
+
+//+------------------------------------------------------------------+
+//| Average Directional Index                                        |
+//+------------------------------------------------------------------+
+class ADX : public Indicator
+  {
+public:
+   ADX(Series *series, int period) : Indicator(series, 3), m_period(period < 1 ? 1 : period) {}
+
+protected:
+   void Compute(int from, int to) override
+     {
+      const double *h = m_series->High();
+      const double *l = m_series->Low();
+      const double *c = m_series->Close();
+      double *adx = m_buffers[0].data();
+      double *pdi = m_buffers[1].data();
+      double *ndi = m_buffers[2].data();
+      double  k = 2.0 / (m_period + 1.0);
+      for(int i = from; i < to; i++)
+        {
+         if(i == 0)
+           {
+            adx[0] = pdi[0] = ndi[0] = 0.0;
+            continue;
+           }
+         double up = h[i] - h[i - 1];
+         double down = l[i - 1] - l[i];
+         if(up < 0)
+            up = 0.0;
+         if(down < 0)
+            down = 0.0;
+         if(up > down)
+            down = 0.0;
+         else if(up < down)
+            up = 0.0;
+         else
+            up = down = 0.0;
+         double tr = std::max(std::max(std::fabs(h[i] - l[i]), std::fabs(h[i] - c[i - 1])), std::fabs(l[i] - c[i - 1]));
+         double pd = (tr != 0.0) ? 100.0 * up / tr : 0.0;
+         double nd = (tr != 0.0) ? 100.0 * down / tr : 0.0;
+         pdi[i] = pd * k + pdi[i - 1] * (1.0 - k);
+         ndi[i] = nd * k + ndi[i - 1] * (1.0 - k);
+         double sum = pdi[i] + ndi[i];
+         double dx = (sum != 0.0) ? 100.0 * std::fabs((pdi[i] - ndi[i]) / sum) : 0.0;
+         adx[i] = dx * k + adx[i - 1] * (1.0 - k);
+        }
+     }
+
+private:
+   int                m_period;
+  };
+
+//+------------------------------------------------------------------+
+//| Bollinger Bands                                                  |
+//+------------------------------------------------------------------+
+class Bands : public Indicator
+  {
+public:
+   Bands(Series *series, int period, double deviation, ENUM_APPLIED_PRICE price)
+      : Indicator(series, 3), m_period(period < 2 ? 2 : period), m_deviation(deviation), m_price(price) {}
+
+protected:
+   void Compute(int from, int to) override
+     {
+      double *mid = m_buffers[0].data();
+      double *upper = m_buffers[1].data();
+      double *lower = m_buffers[2].data();
+      int     n = m_period;
+      for(int i = from; i < to; i++)
+        {
+         if(i < n - 1)
+           {
+            mid[i] = upper[i] = lower[i] = 0.0;
+            continue;
+           }
+         double sum = 0.0;
+         for(int k = 0; k < n; k++)
+            sum += Price(m_price, i - k);
+         double ma = sum / n;
+         double var = 0.0;
+         for(int k = 0; k < n; k++)
+           {
+            double d = Price(m_price, i - k) - ma;
+            var += d * d;
+           }
+         double sd = std::sqrt(var / n);
+         mid[i] = ma;
+         upper[i] = ma + m_deviation * sd;
+         lower[i] = ma - m_deviation * sd;
+        }
+     }
+
+private:
+   int                m_period;
+   double             m_deviation;
+   ENUM_APPLIED_PRICE m_price;
+  };
+
+//+------------------------------------------------------------------+
+//| MACD (signal line is a simple average, as the stock MACD)        |
+//+------------------------------------------------------------------+
+class MACD : public Indicator
+  {
+public:
+   MACD(Series *series, int fast, int slow, int signal, ENUM_APPLIED_PRICE price)
+      : Indicator(series, 2), m_fast(fast < 1 ? 1 : fast), m_slow(slow < 1 ? 1 : slow),
+        m_signal(signal < 1 ? 1 : signal), m_price(price) {}
+
+protected:
+   void Compute(int from, int to) override
+     {
+      m_fast_ema.resize((size_t)to);
+      m_slow_ema.resize((size_t)to);
+      double *main = m_buffers[0].data();
+      double *signal = m_buffers[1].data();
+      double  kf = 2.0 / (m_fast + 1.0);
+      double  ks = 2.0 / (m_slow + 1.0);
+      int     n = m_signal;
+      for(int i = from; i < to; i++)
+        {
+         double p = Price(m_price, i);
+         m_fast_ema[i] = (i == 0) ? p : p * kf + m_fast_ema[i - 1] * (1.0 - kf);
+         m_slow_ema[i] = (i == 0) ? p : p * ks + m_slow_ema[i - 1] * (1.0 - ks);
+         main[i] = m_fast_ema[i] - m_slow_ema[i];
+         if(i < n - 1)
+            signal[i] = 0.0;
+         else if(i == n - 1)
+           {
+            double sum = 0.0;
+            for(int k = 0; k < n; k++)
+               sum += main[i - k];
+            signal[i] = sum / n;
+           }
+         else
+            signal[i] = signal[i - 1] + (main[i] - main[i - n]) / n;
+        }
+     }
+
+private:
+   int                m_fast;
+   int                m_slow;
+   int                m_signal;
+   ENUM_APPLIED_PRICE m_price;
+   std::vector<double> m_fast_ema;
+   std::vector<double> m_slow_ema;
+  };
+}
+
+Indicator *CreateMA(Series *series, int period, ENUM_MA_METHOD method, ENUM_APPLIED_PRICE price)
+  {
+   return new MovingAverage(series, period, method, price);
+  }
+
+Indicator *CreateRSI(Series *series, int period, ENUM_APPLIED_PRICE price)
+  {
+   return new RSI(series, period, price);
+  }
+
+Indicator *CreateATR(Series *series, int period)
+  {
+   return new ATR(series, period);
+  }
+
+Indicator *CreateADX(Series *series, int period)
+  {
+   return new ADX(series, period);
+  }
+
+Indicator *CreateBands(Series *series, int period, double deviation, ENUM_APPLIED_PRICE price)
+  {
+   return new Bands(series, period, deviation, price);
+  }
+
+Indicator *CreateMACD(Series *series, int fast, int slow, int signal, ENUM_APPLIED_PRICE price)
+  {
+   return new MACD(series, fast, slow, signal, price);
+  }
+}
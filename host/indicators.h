@@ -0,0 +1,48 @@
+//+------------------------------------------------------------------+
+//|                                                     indicators.h |
+//|             Built-in indicators computed over a host bar series   |
+//+------------------------------------------------------------------+
+// Each handle owns its buffers and recalculates like an MT5 indicator's
+// OnCalculate: everything on the first CopyBuffer, afterwards only from
+// the previously forming bar onwards. Formulas follow the terminal's
+// stock Moving Average, RSI, ATR, ADX, Bands and MACD indicators.
+#ifndef EA_HOST_INDICATORS_H
+#define EA_HOST_INDICATORS_H
+
+#include "terminal.h"
+
+namespace mql
+{
+class Indicator
+  {
+public:
+                     Indicator(Series *series, int buffers);
+   virtual          ~Indicator() {}
+
+   int               Buffers() const { return (int)m_buffers.size(); }
+   //--- bring buffers up to date with the series; returns bars calculated
+   int               Calculate(HostStats &stats);
+   const double     *Buffer(int index) const { return m_buffers[index].data(); }
+
+protected:
+   //--- compute bars [from, to); earlier bars are final
+   virtual void      Compute(int from, int to) = 0;
+   double            Price(ENUM_APPLIED_PRICE type, int i) const;
+
+   Series           *m_series;
+   std::vector<std::vector<double>> m_buffers;
+
+private:
+   int               m_calculated;
+   ulong             m_version;
+  };
+
+Indicator *CreateMA(Series *series, int period, ENUM_MA_METHOD method, ENUM_APPLIED_PRICE price);
+Indicator *CreateRSI(Series *series, int period, ENUM_APPLIED_PRICE price);
+Indicator *CreateATR(Series *series, int period);
+Indicator *CreateADX(Series *series, int period);
+Indicator *CreateBands(Series *series, int period, double deviation, ENUM_APPLIED_PRICE price);
+Indicator *CreateMACD(Series *series, int fast, int slow, int signal, ENUM_APPLIED_PRICE price);
+}
+
+#endif // EA_HOST_INDICATORS_H
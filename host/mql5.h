@@ -0,0 +1,1004 @@
+//+------------------------------------------------------------------+
+//|                                                           mql5.h |
+//|        MQL5 language surface and terminal API for the native host |
+//+------------------------------------------------------------------+
+// Everything an Expert Advisor in this repository can reference once it
+// has been passed through mq5pp: the MQL5 scalar types, dynamic arrays,
+// the built-in enums/structs and the terminal functions. Terminal calls
+// are free functions that act on the terminal bound to the calling
+// thread (see mql::Bind in terminal.h), so several experts can run in
+// parallel on separate threads.
+#ifndef EA_HOST_MQL5_H
+#define EA_HOST_MQL5_H
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//+------------------------------------------------------------------+
+//| Scalar types                                                     |
+//+------------------------------------------------------------------+
+typedef std::string    string;
+typedef unsigned char  uchar;
+typedef unsigned short ushort;
+typedef unsigned int   uint;
+typedef unsigned long  ulong;
+typedef long           datetime;
+typedef unsigned int   color;
+
+#define WHOLE_ARRAY     (-1)
+#define EMPTY_VALUE     DBL_MAX
+#define INVALID_HANDLE  (-1)
+#define CHARTS_MAX      100
+
+//+------------------------------------------------------------------+
+//| Dynamic arrays (T name[] in MQL5)                                |
+//+------------------------------------------------------------------+
+namespace mql
+{
+class RuntimeError : public std::runtime_error
+  {
+public:
+   explicit RuntimeError(const std::string &what) : std::runtime_error(what) {}
+  };
+
+[[noreturn]] void ArrayOutOfRange(long index, size_t size);
+
+template<typename T>
+class array
+  {
+public:
+                     array() : m_series(false) {}
+                     array(std::initializer_list<T> init) : m_data(init), m_series(false) {}
+
+   T                &operator[](long i)       { return m_data[Slot(i)]; }
+   const T          &operator[](long i) const { return m_data[Slot(i)]; }
+
+   int               Size() const   { return (int)m_data.size(); }
+   bool              Series() const { return m_series; }
+   void              Series(bool flag) { m_series = flag; }
+   int               Resize(int size, int reserve)
+     {
+      if(size < 0)
+         return -1;
+      if(reserve > 0 && m_data.capacity() < (size_t)size + (size_t)reserve)
+         m_data.reserve((size_t)size + (size_t)reserve);
+      m_data.resize((size_t)size);
+      return size;
+     }
+   //--- chronological storage, independent of the series flag
+   std::vector<T>   &Raw()       { return m_data; }
+   const std::vector<T> &Raw() const { return m_data; }
+
+private:
+   size_t            Slot(long i) const
+     {
+      size_t n = m_data.size();
+      if((size_t)i >= n)
+         ArrayOutOfRange(i, n);
+      return m_series ? n - 1 - (size_t)i : (size_t)i;
+     }
+
+   std::vector<T>    m_data;
+   bool              m_series;
+  };
+}
+
+//+------------------------------------------------------------------+
+//| Enumerations                                                     |
+//+------------------------------------------------------------------+
+enum ENUM_TIMEFRAMES
+  {
+   PERIOD_CURRENT = 0,
+   PERIOD_M1 = 1, PERIOD_M2 = 2, PERIOD_M3 = 3, PERIOD_M4 = 4, PERIOD_M5 = 5,
+   PERIOD_M6 = 6, PERIOD_M10 = 10, PERIOD_M12 = 12, PERIOD_M15 = 15,
+   PERIOD_M20 = 20, PERIOD_M30 = 30,
+   PERIOD_H1 = 16385, PERIOD_H2 = 16386, PERIOD_H3 = 16387, PERIOD_H4 = 16388,
+   PERIOD_H6 = 16390, PERIOD_H8 = 16392, PERIOD_H12 = 16396,
+   PERIOD_D1 = 16408, PERIOD_W1 = 32769, PERIOD_MN1 = 49153
+  };
+
+enum ENUM_MA_METHOD { MODE_SMA, MODE_EMA, MODE_SMMA, MODE_LWMA };
+
+enum ENUM_APPLIED_PRICE
+  {
+   PRICE_CLOSE = 1, PRICE_OPEN, PRICE_HIGH, PRICE_LOW,
+   PRICE_MEDIAN, PRICE_TYPICAL, PRICE_WEIGHTED
+  };
+
+enum ENUM_INDICATOR_LINES
+  {
+   MAIN_LINE = 0, SIGNAL_LINE = 1,
+   BASE_LINE = 0, UPPER_BAND = 1, LOWER_BAND = 2,
+   PLUSDI_LINE = 1, MINUSDI_LINE = 2
+  };
+
+enum ENUM_ORDER_TYPE
+  {
+   ORDER_TYPE_BUY, ORDER_TYPE_SELL,
+   ORDER_TYPE_BUY_LIMIT, ORDER_TYPE_SELL_LIMIT,
+   ORDER_TYPE_BUY_STOP, ORDER_TYPE_SELL_STOP,
+   ORDER_TYPE_BUY_STOP_LIMIT, ORDER_TYPE_SELL_STOP_LIMIT,
+   ORDER_TYPE_CLOSE_BY
+  };
+
+enum ENUM_ORDER_STATE
+  {
+   ORDER_STATE_STARTED, ORDER_STATE_PLACED, ORDER_STATE_CANCELED,
+   ORDER_STATE_PARTIAL, ORDER_STATE_FILLED, ORDER_STATE_REJECTED,
+   ORDER_STATE_EXPIRED, ORDER_STATE_REQUEST_ADD, ORDER_STATE_REQUEST_MODIFY,
+   ORDER_STATE_REQUEST_CANCEL
+  };
+
+enum ENUM_ORDER_TYPE_FILLING
+  {
+   ORDER_FILLING_FOK, ORDER_FILLING_IOC, ORDER_FILLING_RETURN, ORDER_FILLING_BOC
+  };
+
+enum ENUM_ORDER_TYPE_TIME
+  {
+   ORDER_TIME_GTC, ORDER_TIME_DAY, ORDER_TIME_SPECIFIED, ORDER_TIME_SPECIFIED_DAY
+  };
+
+enum ENUM_POSITION_TYPE { POSITION_TYPE_BUY, POSITION_TYPE_SELL };
+
+enum ENUM_TRADE_REQUEST_ACTIONS
+  {
+   TRADE_ACTION_DEAL = 1, TRADE_ACTION_PENDING = 5, TRADE_ACTION_SLTP = 6,
+   TRADE_ACTION_MODIFY = 7, TRADE_ACTION_REMOVE = 8, TRADE_ACTION_CLOSE_BY = 10
+  };
+
+enum ENUM_DEAL_TYPE
+  {
+   DEAL_TYPE_BUY, DEAL_TYPE_SELL, DEAL_TYPE_BALANCE, DEAL_TYPE_CREDIT,
+   DEAL_TYPE_CHARGE, DEAL_TYPE_CORRECTION, DEAL_TYPE_BONUS, DEAL_TYPE_COMMISSION
+  };
+
+enum ENUM_DEAL_ENTRY { DEAL_ENTRY_IN, DEAL_ENTRY_OUT, DEAL_ENTRY_INOUT, DEAL_ENTRY_OUT_BY };
+
+enum ENUM_DEAL_REASON
+  {
+   DEAL_REASON_CLIENT, DEAL_REASON_MOBILE, DEAL_REASON_WEB, DEAL_REASON_EXPERT,
+   DEAL_REASON_SL, DEAL_REASON_TP, DEAL_REASON_SO
+  };
+
+enum ENUM_TRADE_TRANSACTION_TYPE
+  {
+   TRADE_TRANSACTION_ORDER_ADD, TRADE_TRANSACTION_ORDER_UPDATE,
+   TRADE_TRANSACTION_ORDER_DELETE, TRADE_TRANSACTION_HISTORY_ADD,
+   TRADE_TRANSACTION_HISTORY_UPDATE, TRADE_TRANSACTION_HISTORY_DELETE,
+   TRADE_TRANSACTION_DEAL_ADD, TRADE_TRANSACTION_DEAL_UPDATE,
+   TRADE_TRANSACTION_DEAL_DELETE, TRADE_TRANSACTION_POSITION,
+   TRADE_TRANSACTION_REQUEST
+  };
+
+enum ENUM_SYMBOL_INFO_DOUBLE
+  {
+   SYMBOL_BID, SYMBOL_ASK, SYMBOL_LAST, SYMBOL_POINT,
+   SYMBOL_TRADE_TICK_VALUE, SYMBOL_TRADE_TICK_SIZE, SYMBOL_TRADE_CONTRACT_SIZE,
+   SYMBOL_VOLUME_MIN, SYMBOL_VOLUME_MAX, SYMBOL_VOLUME_STEP, SYMBOL_VOLUME_LIMIT,
+   SYMBOL_SWAP_LONG, SYMBOL_SWAP_SHORT, SYMBOL_MARGIN_INITIAL
+  };
+
+enum ENUM_SYMBOL_INFO_INTEGER
+  {
+   SYMBOL_SPREAD, SYMBOL_DIGITS, SYMBOL_TRADE_STOPS_LEVEL, SYMBOL_TRADE_FREEZE_LEVEL,
+   SYMBOL_FILLING_MODE, SYMBOL_EXPIRATION_MODE, SYMBOL_TRADE_MODE,
+   SYMBOL_TRADE_EXEMODE, SYMBOL_SPREAD_FLOAT, SYMBOL_TIME, SYMBOL_SELECT,
+   SYMBOL_VISIBLE
+  };
+
+enum ENUM_SYMBOL_INFO_STRING
+  {
+   SYMBOL_DESCRIPTION, SYMBOL_CURRENCY_BASE, SYMBOL_CURRENCY_PROFIT,
+   SYMBOL_CURRENCY_MARGIN, SYMBOL_PATH
+  };
+
+#define SYMBOL_FILLING_FOK 1
+#define SYMBOL_FILLING_IOC 2
+#define SYMBOL_FILLING_BOC 4
+
+enum ENUM_SYMBOL_TRADE_EXECUTION
+  {
+   SYMBOL_TRADE_EXECUTION_REQUEST, SYMBOL_TRADE_EXECUTION_INSTANT,
+   SYMBOL_TRADE_EXECUTION_MARKET, SYMBOL_TRADE_EXECUTION_EXCHANGE
+  };
+
+enum ENUM_ACCOUNT_INFO_DOUBLE
+  {
+   ACCOUNT_BALANCE, ACCOUNT_CREDIT, ACCOUNT_PROFIT, ACCOUNT_EQUITY,
+   ACCOUNT_MARGIN, ACCOUNT_MARGIN_FREE, ACCOUNT_MARGIN_LEVEL
+  };
+
+enum ENUM_ACCOUNT_INFO_INTEGER
+  {
+   ACCOUNT_LOGIN, ACCOUNT_TRADE_MODE, ACCOUNT_LEVERAGE, ACCOUNT_LIMIT_ORDERS,
+   ACCOUNT_MARGIN_MODE, ACCOUNT_TRADE_ALLOWED, ACCOUNT_TRADE_EXPERT
+  };
+
+enum ENUM_ACCOUNT_INFO_STRING
+  {
+   ACCOUNT_NAME, ACCOUNT_SERVER, ACCOUNT_CURRENCY, ACCOUNT_COMPANY
+  };
+
+enum ENUM_ACCOUNT_MARGIN_MODE
+  {
+   ACCOUNT_MARGIN_MODE_RETAIL_NETTING, ACCOUNT_MARGIN_MODE_EXCHANGE,
+   ACCOUNT_MARGIN_MODE_RETAIL_HEDGING
+  };
+
+enum ENUM_POSITION_PROPERTY_INTEGER
+  {
+   POSITION_TICKET, POSITION_TIME, POSITION_TIME_MSC, POSITION_TIME_UPDATE,
+   POSITION_TYPE, POSITION_MAGIC, POSITION_IDENTIFIER, POSITION_REASON
+  };
+
+enum ENUM_POSITION_PROPERTY_DOUBLE
+  {
+   POSITION_VOLUME, POSITION_PRICE_OPEN, POSITION_SL, POSITION_TP,
+   POSITION_PRICE_CURRENT, POSITION_SWAP, POSITION_PROFIT
+  };
+
+enum ENUM_POSITION_PROPERTY_STRING { POSITION_SYMBOL, POSITION_COMMENT };
+
+enum ENUM_ORDER_PROPERTY_INTEGER
+  {
+   ORDER_TICKET, ORDER_TIME_SETUP, ORDER_TYPE, ORDER_STATE, ORDER_TIME_EXPIRATION,
+   ORDER_TIME_DONE, ORDER_TYPE_FILLING, ORDER_TYPE_TIME, ORDER_MAGIC,
+   ORDER_POSITION_ID
+  };
+
+enum ENUM_ORDER_PROPERTY_DOUBLE
+  {
+   ORDER_VOLUME_INITIAL, ORDER_VOLUME_CURRENT, ORDER_PRICE_OPEN, ORDER_SL,
+   ORDER_TP, ORDER_PRICE_CURRENT, ORDER_PRICE_STOPLIMIT
+  };
+
+enum ENUM_ORDER_PROPERTY_STRING { ORDER_SYMBOL, ORDER_COMMENT };
+
+enum ENUM_DEAL_PROPERTY_INTEGER
+  {
+   DEAL_TICKET, DEAL_ORDER, DEAL_TIME, DEAL_TIME_MSC, DEAL_TYPE, DEAL_ENTRY,
+   DEAL_MAGIC, DEAL_REASON, DEAL_POSITION_ID
+  };
+
+enum ENUM_DEAL_PROPERTY_DOUBLE
+  {
+   DEAL_VOLUME, DEAL_PRICE, DEAL_COMMISSION, DEAL_SWAP, DEAL_PROFIT, DEAL_FEE
+  };
+
+enum ENUM_DEAL_PROPERTY_STRING { DEAL_SYMBOL, DEAL_COMMENT };
+
+enum ENUM_OBJECT { OBJ_LABEL, OBJ_RECTANGLE_LABEL, OBJ_BUTTON, OBJ_EDIT, OBJ_HLINE, OBJ_VLINE, OBJ_TEXT };
+
+enum ENUM_OBJECT_PROPERTY_INTEGER
+  {
+   OBJPROP_COLOR, OBJPROP_CORNER, OBJPROP_ANCHOR, OBJPROP_XDISTANCE,
+   OBJPROP_YDISTANCE, OBJPROP_XSIZE, OBJPROP_YSIZE, OBJPROP_FONTSIZE,
+   OBJPROP_BGCOLOR, OBJPROP_BORDER_TYPE, OBJPROP_BACK, OBJPROP_SELECTABLE,
+   OBJPROP_HIDDEN, OBJPROP_ZORDER, OBJPROP_STYLE, OBJPROP_WIDTH
+  };
+
+enum ENUM_OBJECT_PROPERTY_DOUBLE { OBJPROP_PRICE, OBJPROP_ANGLE };
+
+enum ENUM_OBJECT_PROPERTY_STRING { OBJPROP_TEXT, OBJPROP_FONT, OBJPROP_TOOLTIP, OBJPROP_NAME };
+
+enum ENUM_BASE_CORNER
+  {
+   CORNER_LEFT_UPPER, CORNER_LEFT_LOWER, CORNER_RIGHT_LOWER, CORNER_RIGHT_UPPER
+  };
+
+enum ENUM_ANCHOR_POINT
+  {
+   ANCHOR_LEFT_UPPER, ANCHOR_LEFT, ANCHOR_LEFT_LOWER, ANCHOR_LOWER,
+   ANCHOR_RIGHT_LOWER, ANCHOR_RIGHT, ANCHOR_RIGHT_UPPER, ANCHOR_UPPER, ANCHOR_CENTER
+  };
+
+enum ENUM_INIT_RETCODE
+  {
+   INIT_SUCCEEDED = 0, INIT_FAILED = 1,
+   INIT_PARAMETERS_INCORRECT = 32767, INIT_AGENT_NOT_SUITABLE = 32768
+  };
+
+enum ENUM_DEINIT_REASON
+  {
+   REASON_PROGRAM, REASON_REMOVE, REASON_RECOMPILE, REASON_CHARTCHANGE,
+   REASON_CHARTCLOSE, REASON_PARAMETERS, REASON_ACCOUNT, REASON_TEMPLATE,
+   REASON_INITFAILED, REASON_CLOSE
+  };
+
+enum ENUM_MQL_INFO_INTEGER { MQL_TESTER, MQL_OPTIMIZATION, MQL_VISUAL_MODE, MQL_DEBUG, MQL_TRADE_ALLOWED };
+
+#define TIME_DATE     1
+#define TIME_MINUTES  2
+#define TIME_SECONDS  4
+
+//--- trade server return codes
+#define TRADE_RETCODE_REQUOTE            10004
+#define TRADE_RETCODE_REJECT             10006
+#define TRADE_RETCODE_CANCEL             10007
+#define TRADE_RETCODE_PLACED             10008
+#define TRADE_RETCODE_DONE               10009
+#define TRADE_RETCODE_DONE_PARTIAL       10010
+#define TRADE_RETCODE_ERROR              10011
+#define TRADE_RETCODE_TIMEOUT            10012
+#define TRADE_RETCODE_INVALID            10013
+#define TRADE_RETCODE_INVALID_VOLUME     10014
+#define TRADE_RETCODE_INVALID_PRICE      10015
+#define TRADE_RETCODE_INVALID_STOPS      10016
+#define TRADE_RETCODE_TRADE_DISABLED     10017
+#define TRADE_RETCODE_MARKET_CLOSED      10018
+#define TRADE_RETCODE_NO_MONEY           10019
+#define TRADE_RETCODE_PRICE_CHANGED      10020
+#define TRADE_RETCODE_PRICE_OFF          10021
+#define TRADE_RETCODE_INVALID_EXPIRATION 10022
+#define TRADE_RETCODE_ORDER_CHANGED      10023
+#define TRADE_RETCODE_TOO_MANY_REQUESTS  10024
+#define TRADE_RETCODE_NO_CHANGES         10025
+#define TRADE_RETCODE_LOCKED             10028
+#define TRADE_RETCODE_FROZEN             10029
+#define TRADE_RETCODE_INVALID_FILL       10030
+#define TRADE_RETCODE_CONNECTION         10031
+#define TRADE_RETCODE_LIMIT_ORDERS       10033
+#define TRADE_RETCODE_LIMIT_VOLUME       10034
+#define TRADE_RETCODE_INVALID_ORDER      10035
+#define TRADE_RETCODE_POSITION_CLOSED    10036
+
+//--- runtime error codes
+#define ERR_SUCCESS                      0
+#define ERR_INTERNAL_ERROR               4001
+#define ERR_INVALID_PARAMETER            4003
+#define ERR_NOT_ENOUGH_MEMORY            4004
+#define ERR_ARRAY_BAD_SIZE               4011
+#define ERR_OBJECT_NOT_FOUND             4202
+#define ERR_MARKET_UNKNOWN_SYMBOL        4301
+#define ERR_HISTORY_NOT_FOUND            4401
+#define ERR_GLOBALVARIABLE_NOT_FOUND     4501
+#define ERR_TOO_MANY_FILES               5001
+#define ERR_WRONG_FILENAME               5002
+#define ERR_CANNOT_OPEN_FILE             5004
+#define ERR_CANNOT_DELETE_FILE           5006
+#define ERR_INVALID_FILEHANDLE           5007
+#define ERR_FILE_NOTTOWRITE              5009
+#define ERR_FILE_NOTTOREAD               5010
+#define ERR_FILE_READERROR               5015
+#define ERR_FILE_BINSTRINGSIZE           5016
+#define ERR_FILE_NOT_EXIST               5019
+#define ERR_FILE_CANNOT_REWRITE          5020
+#define ERR_FILE_WRITEERROR              5026
+#define ERR_TRADE_POSITION_NOT_FOUND     4753
+#define ERR_TRADE_ORDER_NOT_FOUND        4754
+#define ERR_TRADE_DEAL_NOT_FOUND         4755
+#define ERR_TRADE_SEND_FAILED            4756
+#define ERR_INDICATOR_DATA_NOT_FOUND     4806
+#define ERR_INDICATOR_WRONG_HANDLE       4807
+#define ERR_USER_ERROR_FIRST             65536
+
+//--- web colours used by the experts (0x00BBGGRR like the terminal)
+#define clrNONE          0xFFFFFFFF
+#define clrBlack         0x000000
+#define clrWhite         0xFFFFFF
+#define clrRed           0x0000FF
+#define clrLime          0x00FF00
+#define clrBlue          0xFF0000
+#define clrYellow        0x00FFFF
+#define clrAqua          0xFFFF00
+#define clrMagenta       0xFF00FF
+#define clrGray          0x808080
+#define clrSilver        0xC0C0C0
+#define clrGold          0x00D7FF
+#define clrOrange        0x00A5FF
+#define clrGreen         0x008000
+#define clrDodgerBlue    0xFF901E
+#define clrDarkGray      0xA9A9A9
+#define clrLightGray     0xD3D3D3
+#define clrOrangeRed     0x0045FF
+#define clrTomato        0x4763FF
+#define clrCyan          0xFFFF00
+#define clrDarkOrange    0x008CFF
+#define clrLightBlue     0xE6D8AD
+#define clrNavy          0x800000
+#define clrDarkBlue      0x8B0000
+#define clrDarkGreen     0x006400
+#define clrLimeGreen     0x32CD32
+
+//+------------------------------------------------------------------+
+//| Built-in structures                                              |
+//+------------------------------------------------------------------+
+struct MqlDateTime
+  {
+   int               year;
+   int               mon;
+   int               day;
+   int               hour;
+   int               min;
+   int               sec;
+   int               day_of_week;
+   int               day_of_year;
+  };
+
+struct MqlRates
+  {
+   datetime          time;
+   double            open;
+   double            high;
+   double            low;
+   double            close;
+   long              tick_volume;
+   int               spread;
+   long              real_volume;
+  };
+
+struct MqlTick
+  {
+   datetime          time;
+   double            bid;
+   double            ask;
+   double            last;
+   ulong             volume;
+   long              time_msc;
+   uint              flags;
+   double            volume_real;
+  };
+
+struct MqlTradeRequest
+  {
+   ENUM_TRADE_REQUEST_ACTIONS action;
+   ulong             magic;
+   ulong             order;
+   string            symbol;
+   double            volume;
+   double            price;
+   double            stoplimit;
+   double            sl;
+   double            tp;
+   ulong             deviation;
+   ENUM_ORDER_TYPE   type;
+   ENUM_ORDER_TYPE_FILLING type_filling;
+   ENUM_ORDER_TYPE_TIME type_time;
+   datetime          expiration;
+   string            comment;
+   ulong             position;
+   ulong             position_by;
+  };
+
+struct MqlTradeResult
+  {
+   uint              retcode;
+   ulong             deal;
+   ulong             order;
+   double            volume;
+   double            price;
+   double            bid;
+   double            ask;
+   string            comment;
+   uint              request_id;
+   int               retcode_external;
+  };
+
+struct MqlTradeTransaction
+  {
+   ulong             deal;
+   ulong             order;
+   string            symbol;
+   ENUM_TRADE_TRANSACTION_TYPE type;
+   ENUM_ORDER_TYPE   order_type;
+   ENUM_ORDER_STATE  order_state;
+   ENUM_DEAL_TYPE    deal_type;
+   ENUM_ORDER_TYPE_TIME time_type;
+   datetime          time_expiration;
+   double            price;
+   double            price_trigger;
+   double            price_sl;
+   double            price_tp;
+   double            volume;
+   ulong             position;
+   ulong             position_by;
+  };
+
+//+------------------------------------------------------------------+
+//| Output helpers (implemented in runtime.cpp)                      |
+//+------------------------------------------------------------------+
+namespace mql
+{
+bool        LogEnabled();
+void        LogLine(const std::string &line);
+void        SetComment(const std::string &text);
+std::string FormatDouble(double value);
+std::string EnumName(ENUM_TIMEFRAMES value);
+
+inline void Append(std::string &s, const std::string &v) { s += v; }
+inline void Append(std::string &s, const char *v)        { s += v; }
+inline void Append(std::string &s, char *v)              { s += v; }
+inline void Append(std::string &s, bool v)               { s += v ? "true" : "false"; }
+inline void Append(std::string &s, double v)             { s += FormatDouble(v); }
+inline void Append(std::string &s, float v)              { s += FormatDouble(v); }
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+Append(std::string &s, T v)
+  {
+   if(std::is_signed<T>::value || std::is_enum<T>::value)
+      s += std::to_string((long long)v);
+   else
+      s += std::to_string((unsigned long long)v);
+  }
+
+//--- one StringFormat argument, already classified
+struct FormatArg
+  {
+   enum Kind { SIGNED, UNSIGNED, REAL, TEXT } kind;
+   long long          i;
+   unsigned long long u;
+   double             d;
+   const char        *s;
+  };
+
+inline FormatArg MakeArg(const std::string &v) { FormatArg a = {FormatArg::TEXT, 0, 0, 0, v.c_str()}; return a; }
+inline FormatArg MakeArg(const char *v)        { FormatArg a = {FormatArg::TEXT, 0, 0, 0, v}; return a; }
+inline FormatArg MakeArg(double v)             { FormatArg a = {FormatArg::REAL, 0, 0, v, nullptr}; return a; }
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, FormatArg>::type
+MakeArg(T v)
+  {
+   if(std::is_signed<T>::value || std::is_enum<T>::value)
+     {
+      FormatArg a = {FormatArg::SIGNED, (long long)v, 0, 0, nullptr};
+      return a;
+     }
+   FormatArg a = {FormatArg::UNSIGNED, 0, (unsigned long long)v, 0, nullptr};
+   return a;
+  }
+
+std::string Format(const char *fmt, const FormatArg *args, size_t count);
+}
+
+//+------------------------------------------------------------------+
+//| Common functions                                                 |
+//+------------------------------------------------------------------+
+template<typename... A>
+void Print(const A &... args)
+  {
+   if(!mql::LogEnabled())
+      return;
+   std::string s;
+   (void)std::initializer_list<int>{(mql::Append(s, args), 0)...};
+   mql::LogLine(s);
+  }
+
+template<typename... A>
+void Alert(const A &... args)
+  {
+   if(!mql::LogEnabled())
+      return;
+   std::string s = "Alert: ";
+   (void)std::initializer_list<int>{(mql::Append(s, args), 0)...};
+   mql::LogLine(s);
+  }
+
+template<typename... A>
+void Comment(const A &... args)
+  {
+   std::string s;
+   (void)std::initializer_list<int>{(mql::Append(s, args), 0)...};
+   mql::SetComment(s);
+  }
+
+template<typename... A>
+string StringFormat(const string &fmt, const A &... args)
+  {
+   const mql::FormatArg list[] = {mql::MakeArg(args)..., mql::MakeArg("")};
+   return mql::Format(fmt.c_str(), list, sizeof...(args));
+  }
+
+template<typename... A>
+void PrintFormat(const string &fmt, const A &... args)
+  {
+   if(!mql::LogEnabled())
+      return;
+   mql::LogLine(StringFormat(fmt, args...));
+  }
+
+bool   SendNotification(const string &text);
+bool   PlaySound(const string &file);
+void   Sleep(int milliseconds);
+uint   GetTickCount();
+ulong  GetTickCount64();
+ulong  GetMicrosecondCount();
+int    GetLastError();
+void   ResetLastError();
+void   SetUserError(ushort code);
+int    MQLInfoInteger(ENUM_MQL_INFO_INTEGER property);
+bool   IsStopped();
+void   ExpertRemove();
+void   SetReturnError(int ret_code);
+int    PeriodSeconds(ENUM_TIMEFRAMES period = PERIOD_CURRENT);
+ENUM_TIMEFRAMES Period();
+const string &Symbol();
+double Point();
+int    Digits();
+
+template<typename T>
+void ZeroMemory(T &value) { value = T(); }
+template<typename T, size_t N>
+void ZeroMemory(T (&value)[N]) { std::fill(value, value + N, T()); }
+template<typename T>
+void ZeroMemory(mql::array<T> &value) { std::fill(value.Raw().begin(), value.Raw().end(), T()); }
+
+//+------------------------------------------------------------------+
+//| Math                                                             |
+//+------------------------------------------------------------------+
+template<typename T> T MathAbs(T v) { return v < 0 ? -v : v; }
+template<typename A, typename B>
+typename std::common_type<A, B>::type MathMax(A a, B b) { return a > b ? a : b; }
+template<typename A, typename B>
+typename std::common_type<A, B>::type MathMin(A a, B b) { return a < b ? a : b; }
+inline double MathFloor(double v)           { return std::floor(v); }
+inline double MathCeil(double v)            { return std::ceil(v); }
+inline double MathRound(double v)           { return std::round(v); }
+inline double MathSqrt(double v)            { return std::sqrt(v); }
+inline double MathPow(double b, double e)   { return std::pow(b, e); }
+inline double MathLog(double v)             { return std::log(v); }
+inline double MathLog10(double v)           { return std::log10(v); }
+inline double MathExp(double v)             { return std::exp(v); }
+inline double MathMod(double a, double b)   { return std::fmod(a, b); }
+inline double MathArctan(double v)          { return std::atan(v); }
+inline bool   MathIsValidNumber(double v)   { return std::isfinite(v); }
+int    MathRand();
+void   MathSrand(uint seed);
+double NormalizeDouble(double value, int digits);
+
+//+------------------------------------------------------------------+
+//| Conversion and strings                                           |
+//+------------------------------------------------------------------+
+string DoubleToString(double value, int digits = 8);
+string IntegerToString(long value, int str_len = 0, ushort fill_symbol = ' ');
+string TimeToString(datetime value, int mode = TIME_DATE | TIME_MINUTES);
+double StringToDouble(const string &value);
+long   StringToInteger(const string &value);
+datetime StringToTime(const string &value);
+int    StringLen(const string &s);
+int    StringFind(const string &s, const string &match, int start = 0);
+string StringSubstr(const string &s, int start, int length = -1);
+int    StringReplace(string &s, const string &find, const string &replacement);
+bool   StringToUpper(string &s);
+bool   StringToLower(string &s);
+int    StringTrimLeft(string &s);
+int    StringTrimRight(string &s);
+int    StringCompare(const string &a, const string &b, bool case_sensitive = true);
+int    StringSplit(const string &s, ushort separator, mql::array<string> &result);
+string EnumToString(ENUM_TIMEFRAMES value);
+template<typename E>
+typename std::enable_if<std::is_enum<E>::value, string>::type EnumToString(E value)
+  {
+   return std::to_string((long long)value);
+  }
+
+//+------------------------------------------------------------------+
+//| Date and time                                                    |
+//+------------------------------------------------------------------+
+datetime TimeCurrent();
+datetime TimeCurrent(MqlDateTime &dt);
+datetime TimeTradeServer();
+datetime TimeLocal();
+datetime TimeGMT();
+bool     TimeToStruct(datetime value, MqlDateTime &dt);
+datetime StructToTime(MqlDateTime &dt);
+
+//+------------------------------------------------------------------+
+//| Array functions                                                  |
+//+------------------------------------------------------------------+
+template<typename T> int  ArraySize(const mql::array<T> &a) { return a.Size(); }
+template<typename T, size_t N> int ArraySize(const T (&)[N]) { return (int)N; }
+template<typename T> int  ArrayResize(mql::array<T> &a, int size, int reserve = 0) { return a.Resize(size, reserve); }
+template<typename T> bool ArraySetAsSeries(mql::array<T> &a, bool flag) { a.Series(flag); return true; }
+template<typename T, size_t N> bool ArraySetAsSeries(T (&)[N], bool) { return false; }
+template<typename T> bool ArrayGetAsSeries(const mql::array<T> &a) { return a.Series(); }
+template<typename T> bool ArrayIsSeries(const mql::array<T> &) { return false; }
+template<typename T> bool ArrayIsDynamic(const mql::array<T> &) { return true; }
+template<typename T> void ArrayFree(mql::array<T> &a) { std::vector<T>().swap(a.Raw()); }
+
+template<typename T, typename V>
+int ArrayInitialize(mql::array<T> &a, V value)
+  {
+   std::fill(a.Raw().begin(), a.Raw().end(), (T)value);
+   return a.Size();
+  }
+
+template<typename T, size_t N, typename V>
+int ArrayInitialize(T (&a)[N], V value)
+  {
+   std::fill(a, a + N, (T)value);
+   return (int)N;
+  }
+
+template<typename T, typename V>
+void ArrayFill(mql::array<T> &a, int start, int count, V value)
+  {
+   if(start + count > a.Size())
+      a.Resize(start + count, 0);
+   for(int i = 0; i < count; i++)
+      a[start + i] = (T)value;
+  }
+
+template<typename T>
+int ArrayCopy(mql::array<T> &dst, const mql::array<T> &src, int dst_start = 0, int src_start = 0, int count = WHOLE_ARRAY)
+  {
+   int available = src.Size() - src_start;
+   if(count < 0 || count > available)
+      count = available;
+   if(count <= 0)
+      return 0;
+   if(dst.Size() < dst_start + count)
+      dst.Resize(dst_start + count, 0);
+   for(int i = 0; i < count; i++)
+      dst[dst_start + i] = src[src_start + i];
+   return count;
+  }
+
+template<typename A>
+bool ArrayRemove(A &a, uint start, uint count = (uint)WHOLE_ARRAY)
+  {
+   int size = ArraySize(a);
+   if((int)start >= size)
+      return false;
+   if(count == (uint)WHOLE_ARRAY || (int)(start + count) > size)
+      count = (uint)(size - (int)start);
+   for(int i = (int)start; i + (int)count < size; i++)
+      a[i] = a[i + count];
+   ArrayResize(a, size - (int)count);
+   return true;
+  }
+
+template<typename T>
+int ArrayMaximum(const mql::array<T> &a, int start = 0, int count = WHOLE_ARRAY)
+  {
+   int end = (count < 0) ? a.Size() : std::min(a.Size(), start + count);
+   int best = -1;
+   for(int i = start; i < end; i++)
+      if(best < 0 || a[i] > a[best])
+         best = i;
+   return best;
+  }
+
+template<typename T>
+int ArrayMinimum(const mql::array<T> &a, int start = 0, int count = WHOLE_ARRAY)
+  {
+   int end = (count < 0) ? a.Size() : std::min(a.Size(), start + count);
+   int best = -1;
+   for(int i = start; i < end; i++)
+      if(best < 0 || a[i] < a[best])
+         best = i;
+   return best;
+  }
+
+template<typename T>
+bool ArraySort(mql::array<T> &a)
+  {
+   std::sort(a.Raw().begin(), a.Raw().end());
+   return true;
+  }
+
+//+------------------------------------------------------------------+
+//| Timeseries access                                                |
+//+------------------------------------------------------------------+
+int      Bars(const string &symbol, ENUM_TIMEFRAMES timeframe);
+int      iBars(const string &symbol, ENUM_TIMEFRAMES timeframe);
+datetime iTime(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift);
+double   iOpen(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift);
+double   iHigh(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift);
+double   iLow(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift);
+double   iClose(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift);
+long     iVolume(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift);
+long     iTickVolume(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift);
+long     iRealVolume(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift);
+int      iSpread(const string &symbol, ENUM_TIMEFRAMES timeframe, int shift);
+int      iHighest(const string &symbol, ENUM_TIMEFRAMES timeframe, int type, int count = WHOLE_ARRAY, int start = 0);
+int      iLowest(const string &symbol, ENUM_TIMEFRAMES timeframe, int type, int count = WHOLE_ARRAY, int start = 0);
+int      iBarShift(const string &symbol, ENUM_TIMEFRAMES timeframe, datetime time, bool exact = false);
+bool     SymbolInfoTick(const string &symbol, MqlTick &tick);
+
+#define MODE_OPEN    0
+#define MODE_LOW     1
+#define MODE_HIGH    2
+#define MODE_CLOSE   3
+#define MODE_VOLUME  4
+
+//--- series copies: columns are copied in chronological order
+namespace mql
+{
+enum SeriesColumn { COL_TIME, COL_OPEN, COL_HIGH, COL_LOW, COL_CLOSE, COL_TICK_VOLUME, COL_REAL_VOLUME, COL_SPREAD };
+int CopySeries(const string &symbol, ENUM_TIMEFRAMES tf, SeriesColumn col, int start, int count, std::vector<double> &dst);
+int CopySeries(const string &symbol, ENUM_TIMEFRAMES tf, SeriesColumn col, int start, int count, std::vector<long> &dst);
+int CopySeries(const string &symbol, ENUM_TIMEFRAMES tf, SeriesColumn col, int start, int count, std::vector<int> &dst);
+int CopySeries(const string &symbol, ENUM_TIMEFRAMES tf, SeriesColumn col, int start, int count, void *dst, size_t capacity);
+int CopyIndicator(int handle, int buffer, int start, int count, std::vector<double> &dst);
+int CopyIndicator(int handle, int buffer, int start, int count, double *dst, size_t capacity);
+}
+
+#define MQL_SERIES_COPY(NAME, T, COL)                                                         \
+inline int NAME(const string &symbol, ENUM_TIMEFRAMES tf, int start, int count, mql::array<T> &dst) \
+  {                                                                                            \
+   return mql::CopySeries(symbol, tf, COL, start, count, dst.Raw());                          \
+  }                                                                                            \
+template<size_t N>                                                                             \
+inline int NAME(const string &symbol, ENUM_TIMEFRAMES tf, int start, int count, T (&dst)[N])   \
+  {                                                                                            \
+   return mql::CopySeries(symbol, tf, COL, start, count, dst, N);                             \
+  }
+
+MQL_SERIES_COPY(CopyTime, datetime, mql::COL_TIME)
+MQL_SERIES_COPY(CopyOpen, double, mql::COL_OPEN)
+MQL_SERIES_COPY(CopyHigh, double, mql::COL_HIGH)
+MQL_SERIES_COPY(CopyLow, double, mql::COL_LOW)
+MQL_SERIES_COPY(CopyClose, double, mql::COL_CLOSE)
+MQL_SERIES_COPY(CopyTickVolume, long, mql::COL_TICK_VOLUME)
+MQL_SERIES_COPY(CopyRealVolume, long, mql::COL_REAL_VOLUME)
+MQL_SERIES_COPY(CopySpread, int, mql::COL_SPREAD)
+
+int CopyRates(const string &symbol, ENUM_TIMEFRAMES tf, int start, int count, mql::array<MqlRates> &rates);
+
+//+------------------------------------------------------------------+
+//| Technical indicators                                             |
+//+------------------------------------------------------------------+
+int  iMA(const string &symbol, ENUM_TIMEFRAMES period, int ma_period, int ma_shift, ENUM_MA_METHOD method, ENUM_APPLIED_PRICE applied_price);
+int  iRSI(const string &symbol, ENUM_TIMEFRAMES period, int ma_period, ENUM_APPLIED_PRICE applied_price);
+int  iATR(const string &symbol, ENUM_TIMEFRAMES period, int ma_period);
+int  iADX(const string &symbol, ENUM_TIMEFRAMES period, int adx_period);
+int  iBands(const string &symbol, ENUM_TIMEFRAMES period, int bands_period, int bands_shift, double deviation, ENUM_APPLIED_PRICE applied_price);
+int  iMACD(const string &symbol, ENUM_TIMEFRAMES period, int fast_ema_period, int slow_ema_period, int signal_period, ENUM_APPLIED_PRICE applied_price);
+bool IndicatorRelease(int handle);
+int  BarsCalculated(int handle);
+
+inline int CopyBuffer(int handle, int buffer, int start, int count, mql::array<double> &dst)
+  {
+   return mql::CopyIndicator(handle, buffer, start, count, dst.Raw());
+  }
+
+template<size_t N>
+inline int CopyBuffer(int handle, int buffer, int start, int count, double (&dst)[N])
+  {
+   return mql::CopyIndicator(handle, buffer, start, count, dst, N);
+  }
+
+//+------------------------------------------------------------------+
+//| Market and account information                                  |
+//+------------------------------------------------------------------+
+double SymbolInfoDouble(const string &symbol, ENUM_SYMBOL_INFO_DOUBLE property);
+bool   SymbolInfoDouble(const string &symbol, ENUM_SYMBOL_INFO_DOUBLE property, double &value);
+long   SymbolInfoInteger(const string &symbol, ENUM_SYMBOL_INFO_INTEGER property);
+bool   SymbolInfoInteger(const string &symbol, ENUM_SYMBOL_INFO_INTEGER property, long &value);
+string SymbolInfoString(const string &symbol, ENUM_SYMBOL_INFO_STRING property);
+bool   SymbolSelect(const string &symbol, bool select);
+
+double AccountInfoDouble(ENUM_ACCOUNT_INFO_DOUBLE property);
+long   AccountInfoInteger(ENUM_ACCOUNT_INFO_INTEGER property);
+string AccountInfoString(ENUM_ACCOUNT_INFO_STRING property);
+
+//+------------------------------------------------------------------+
+//| Trade functions                                                  |
+//+------------------------------------------------------------------+
+bool   OrderSend(const MqlTradeRequest &request, MqlTradeResult &result);
+bool   OrderSendAsync(const MqlTradeRequest &request, MqlTradeResult &result);
+
+int    PositionsTotal();
+ulong  PositionGetTicket(int index);
+string PositionGetSymbol(int index);
+bool   PositionSelect(const string &symbol);
+bool   PositionSelectByTicket(ulong ticket);
+double PositionGetDouble(ENUM_POSITION_PROPERTY_DOUBLE property);
+long   PositionGetInteger(ENUM_POSITION_PROPERTY_INTEGER property);
+string PositionGetString(ENUM_POSITION_PROPERTY_STRING property);
+
+int    OrdersTotal();
+ulong  OrderGetTicket(int index);
+bool   OrderSelect(ulong ticket);
+double OrderGetDouble(ENUM_ORDER_PROPERTY_DOUBLE property);
+long   OrderGetInteger(ENUM_ORDER_PROPERTY_INTEGER property);
+string OrderGetString(ENUM_ORDER_PROPERTY_STRING property);
+
+bool   HistorySelect(datetime from_date, datetime to_date);
+bool   HistorySelectByPosition(long position_id);
+int    HistoryDealsTotal();
+ulong  HistoryDealGetTicket(int index);
+bool   HistoryDealSelect(ulong ticket);
+double HistoryDealGetDouble(ulong ticket, ENUM_DEAL_PROPERTY_DOUBLE property);
+long   HistoryDealGetInteger(ulong ticket, ENUM_DEAL_PROPERTY_INTEGER property);
+string HistoryDealGetString(ulong ticket, ENUM_DEAL_PROPERTY_STRING property);
+int    HistoryOrdersTotal();
+ulong  HistoryOrderGetTicket(int index);
+double HistoryOrderGetDouble(ulong ticket, ENUM_ORDER_PROPERTY_DOUBLE property);
+long   HistoryOrderGetInteger(ulong ticket, ENUM_ORDER_PROPERTY_INTEGER property);
+string HistoryOrderGetString(ulong ticket, ENUM_ORDER_PROPERTY_STRING property);
+
+//+------------------------------------------------------------------+
+//| Global variables of the terminal                                 |
+//+------------------------------------------------------------------+
+bool     GlobalVariableCheck(const string &name);
+double   GlobalVariableGet(const string &name);
+datetime GlobalVariableSet(const string &name, double value);
+bool     GlobalVariableDel(const string &name);
+
+//+------------------------------------------------------------------+
+//| File operations (implemented in files.cpp)                       |
+//+------------------------------------------------------------------+
+#define FILE_READ          1
+#define FILE_WRITE         2
+#define FILE_BIN           4
+#define FILE_CSV           8
+#define FILE_TXT           16
+#define FILE_ANSI          32
+#define FILE_UNICODE       64
+#define FILE_SHARE_READ    128
+#define FILE_SHARE_WRITE   256
+#define FILE_REWRITE       512
+#define FILE_COMMON        4096
+
+#define CHAR_VALUE         1
+#define SHORT_VALUE        2
+#define INT_VALUE          4
+
+//--- FileSeek origins are SEEK_SET/SEEK_CUR/SEEK_END from <cstdio>
+int    FileOpen(const string &name, int flags, short delimiter = '\t', uint codepage = 0);
+void   FileClose(int handle);
+void   FileFlush(int handle);
+bool   FileIsExist(const string &name, int common_flag = 0);
+bool   FileDelete(const string &name, int common_flag = 0);
+bool   FileMove(const string &src_name, int common_flag, const string &dst_name, int mode_flags);
+ulong  FileSize(int handle);
+ulong  FileTell(int handle);
+bool   FileSeek(int handle, long offset, int origin);
+bool   FileIsEnding(int handle);
+uint   FileWriteInteger(int handle, int value, int size = INT_VALUE);
+uint   FileWriteLong(int handle, long value);
+uint   FileWriteDouble(int handle, double value);
+uint   FileWriteString(int handle, const string &text, int length = -1);
+int    FileReadInteger(int handle, int size = INT_VALUE);
+long   FileReadLong(int handle);
+double FileReadDouble(int handle);
+string FileReadString(int handle, int length = -1);
+
+namespace mql
+{
+uint   FileWriteBytes(int handle, const void *data, size_t size);
+uint   FileReadBytes(int handle, void *data, size_t size);
+}
+
+//--- plain structures only (no strings or dynamic arrays), as in MQL5
+template<typename T>
+uint   FileWriteStruct(int handle, const T &value, int size = -1)
+  {
+   static_assert(std::is_trivially_copyable<T>::value, "FileWriteStruct needs a simple structure");
+   return mql::FileWriteBytes(handle, &value, size < 0 || size > (int)sizeof(T) ? sizeof(T) : (size_t)size);
+  }
+template<typename T>
+uint   FileReadStruct(int handle, T &value, int size = -1)
+  {
+   static_assert(std::is_trivially_copyable<T>::value, "FileReadStruct needs a simple structure");
+   return mql::FileReadBytes(handle, &value, size < 0 || size > (int)sizeof(T) ? sizeof(T) : (size_t)size);
+  }
+
+//+------------------------------------------------------------------+
+//| Chart objects                                                    |
+//+------------------------------------------------------------------+
+bool   ObjectCreate(long chart_id, const string &name, ENUM_OBJECT type, int sub_window, datetime time1, double price1);
+int    ObjectFind(long chart_id, const string &name);
+bool   ObjectDelete(long chart_id, const string &name);
+int    ObjectsDeleteAll(long chart_id, const string &prefix, int sub_window = -1, int type = -1);
+int    ObjectsTotal(long chart_id, int sub_window = -1, int type = -1);
+bool   ObjectSetInteger(long chart_id, const string &name, ENUM_OBJECT_PROPERTY_INTEGER property, long value);
+bool   ObjectSetDouble(long chart_id, const string &name, ENUM_OBJECT_PROPERTY_DOUBLE property, double value);
+bool   ObjectSetString(long chart_id, const string &name, ENUM_OBJECT_PROPERTY_STRING property, const string &value);
+long   ObjectGetInteger(long chart_id, const string &name, ENUM_OBJECT_PROPERTY_INTEGER property);
+string ObjectGetString(long chart_id, const string &name, ENUM_OBJECT_PROPERTY_STRING property);
+void   ChartRedraw(long chart_id = 0);
+
+#endif // EA_HOST_MQL5_H
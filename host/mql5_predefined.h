@@ -0,0 +1,19 @@
+//+------------------------------------------------------------------+
+//|                                                mql5_predefined.h |
+//|                    MQL5 predefined variables for translated code |
+//+------------------------------------------------------------------+
+// Kept out of mql5.h because names like _Period are also used inside
+// the standard library headers; mq5pp includes this after every other
+// header of a translated expert.
+#ifndef EA_HOST_MQL5_PREDEFINED_H
+#define EA_HOST_MQL5_PREDEFINED_H
+
+#include "mql5.h"
+
+#define _Symbol    Symbol()
+#define _Point     Point()
+#define _Digits    Digits()
+#define _Period    Period()
+#define _LastError GetLastError()
+
+#endif // EA_HOST_MQL5_PREDEFINED_H
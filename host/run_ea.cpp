@@ -0,0 +1,301 @@
+//+------------------------------------------------------------------+
+//|                                                       run_ea.cpp |
+//|           Drive a translated expert headless on a simulated market|
+//+------------------------------------------------------------------+
+#include "backtest.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+//--- does nothing on ticks; "--ea idle" measures the replay engine alone
+class IdleExpert : public mql::Expert
+  {
+  };
+
+std::unique_ptr<mql::Expert> CreateIdle()
+  {
+   return std::unique_ptr<mql::Expert>(new IdleExpert());
+  }
+
+mql::ExpertRegistration idle_registration("idle", CreateIdle);
+
+void Usage()
+  {
+   std::fprintf(stderr,
+                "usage: ea_host --ea NAME [options]\n"
+                "  --list                 list the experts linked into this binary\n"
+                "  --inputs               print the expert's inputs and exit\n"
+                "  --symbol NAME          chart symbol (default BTCUSD)\n"
+                "  --period TF            chart timeframe, e.g. H1 (default H1)\n"
+                "  --days N               days of ticks to run (default 5)\n"
+                "  --history-days N       M1 warm-up history before the first tick (default 30)\n"
+                "  --store DIR            replay history from a columnar store instead of a random walk\n"
+                "  --from DATE, --to DATE replay window in a store, YYYY.MM.DD[ HH:MM]\n"
+                "  --tpm N                synthetic ticks per minute (default 30)\n"
+                "  --seed N               random walk seed (default 1)\n"
+                "  --balance X            initial deposit (default 10000)\n"
+                "  --set NAME=VALUE       override an input parameter (repeatable)\n"
+                "  --positions N          open N positions with the expert's magic before OnInit\n"
+                "  --restart-every H      reload the expert every H hours of market time\n"
+                "  --files DIR            directory of the expert's files (default: a scratch directory)\n"
+                "  --quiet                suppress the expert's log output\n"
+                "  --visual               run as a visual test (experts draw their panels)\n");
+  }
+
+//--- "count" minimum-volume positions, alternately buy and sell so the
+//--- book stays about flat; they load the expert's position bookkeeping
+void OpenPositions(mql::Terminal &terminal, const mql::Expert &expert, int count)
+  {
+   std::vector<std::pair<std::string, std::string>> inputs;
+   expert.ListInputs(inputs);
+   long magic = 0;
+   for(const auto &kv : inputs)
+      if(kv.first == "MagicNumber")
+         magic = std::atol(kv.second.c_str());
+   mql::SymbolState *symbol = terminal.FindSymbol("");
+   for(int i = 0; i < count; i++)
+     {
+      MqlTradeRequest request = MqlTradeRequest();
+      MqlTradeResult  result;
+      request.action = TRADE_ACTION_DEAL;
+      request.symbol = symbol->spec.name;
+      request.type = i % 2 == 0 ? ORDER_TYPE_BUY : ORDER_TYPE_SELL;
+      request.volume = symbol->spec.volume_min;
+      request.type_filling = ORDER_FILLING_IOC;
+      request.magic = (ulong)magic;
+      request.comment = "preset";
+      if(!terminal.Send(request, result))
+        {
+         std::fprintf(stderr, "preset position %d: %s\n", i, result.comment.c_str());
+         return;
+        }
+     }
+  }
+
+void PrintStats(const mql::HostStats &s)
+  {
+   //--- per tick figures make runs of different lengths comparable
+   double ticks = s.ticks > 0 ? (double)s.ticks : 1.0;
+   std::printf("  series calls      %lu (%.2f per tick)\n", s.series_calls, s.series_calls / ticks);
+   std::printf("  CopyBuffer calls  %lu (%.2f per tick)\n", s.copy_buffer_calls, s.copy_buffer_calls / ticks);
+   std::printf("  indicator handles %lu created, %lu released, %lu bars computed\n",
+               s.indicator_creates, s.indicator_releases, s.indicator_bars_computed);
+   std::printf("  symbol/account    %lu / %lu\n", s.symbol_info_calls, s.account_info_calls);
+   std::printf("  position/order    %lu\n", s.position_calls);
+   std::printf("  history           %lu selects, %lu deal reads\n", s.history_selects, s.history_reads);
+   std::printf("  OrderSend         %lu (%lu failed, %lu async), %lu SL/TP modifications\n",
+               s.order_sends, s.order_send_failures, s.async_sends, s.sltp_modifications);
+   std::printf("  deals             %lu (%lu server-side triggers)\n", s.deals, s.stop_outs);
+   std::printf("  transactions      %lu\n", s.transactions);
+   std::printf("  files             %lu calls, %lu flushes\n", s.file_calls, s.file_flushes);
+   std::printf("  chart objects     %lu calls, Sleep %lu ms\n", s.object_calls, s.sleep_ms);
+  }
+}
+
+int main(int argc, char **argv)
+  {
+   std::string ea;
+   std::string symbol = "BTCUSD";
+   std::string period = "H1";
+   double      days = 5;
+   int         history_days = 30;
+   bool        quiet = false;
+   bool        show_inputs = false;
+   int         positions = 0;
+   double      restart_hours = 0;
+   std::string store_root;
+   datetime    from = 0;
+   datetime    to = 0;
+   mql::SyntheticConfig market;
+   mql::TerminalConfig config;
+   std::vector<std::pair<std::string, std::string>> overrides;
+
+   for(int i = 1; i < argc; i++)
+     {
+      std::string arg = argv[i];
+      auto value = [&]() -> std::string
+        {
+         if(i + 1 >= argc)
+           {
+            Usage();
+            std::exit(2);
+           }
+         return argv[++i];
+        };
+      if(arg == "--ea")
+         ea = value();
+      else if(arg == "--list")
+        {
+         for(const std::string &name : mql::ExpertNames())
+            std::printf("%s\n", name.c_str());
+         return 0;
+        }
+      else if(arg == "--inputs")
+         show_inputs = true;
+      else if(arg == "--symbol")
+         symbol = value();
+      else if(arg == "--period")
+         period = value();
+      else if(arg == "--days")
+         days = std::atof(value().c_str());
+      else if(arg == "--history-days")
+         history_days = std::atoi(value().c_str());
+      else if(arg == "--store")
+         store_root = value();
+      else if(arg == "--from")
+         from = StringToTime(value());
+      else if(arg == "--to")
+         to = StringToTime(value());
+      else if(arg == "--tpm")
+         market.ticks_per_minute = std::atoi(value().c_str());
+      else if(arg == "--seed")
+         market.seed = (uint)std::strtoul(value().c_str(), nullptr, 10);
+      else if(arg == "--balance")
+         config.balance = std::atof(value().c_str());
+      else if(arg == "--set")
+        {
+         std::string kv = value();
+         size_t eq = kv.find('=');
+         if(eq == std::string::npos)
+           {
+            Usage();
+            return 2;
+           }
+         overrides.emplace_back(kv.substr(0, eq), kv.substr(eq + 1));
+        }
+      else if(arg == "--positions")
+         positions = std::atoi(value().c_str());
+      else if(arg == "--restart-every")
+         restart_hours = std::atof(value().c_str());
+      else if(arg == "--files")
+         config.files_dir = value();
+      else if(arg == "--quiet")
+         quiet = true;
+      else if(arg == "--visual")
+         config.visual = true;
+      else
+        {
+         Usage();
+         return 2;
+        }
+     }
+   if(ea.empty())
+     {
+      Usage();
+      return 2;
+     }
+   if(!mql::ParseTimeframe(period, config.chart_period))
+     {
+      std::fprintf(stderr, "unknown timeframe %s\n", period.c_str());
+      return 2;
+     }
+
+   config.chart_symbol = symbol;
+   config.log = !quiet;
+   mql::Terminal terminal(config);
+   mql::SymbolSpec spec = mql::PresetSymbol(symbol);
+   terminal.AddSymbol(spec);
+
+   mql::SyntheticMarket feed(spec, market);
+   mql::BarStore bars;
+   mql::TickStore ticks;
+   std::unique_ptr<mql::TickSource> source;
+   auto started = std::chrono::steady_clock::now();
+   if(store_root.empty())
+     {
+      std::vector<MqlRates> history = feed.History(history_days * 1440);
+      terminal.LoadHistory(symbol, history.data(), history.size());
+      source.reset(new mql::SyntheticTickSource(feed, feed.Time() + (datetime)(days * 86400)));
+     }
+   else
+     {
+      std::string bar_error, tick_error;
+      bool have_bars = bars.Open(store_root, symbol, bar_error);
+      bool have_ticks = ticks.Open(store_root, symbol, tick_error);
+      if(!have_bars && !have_ticks)
+        {
+         std::fprintf(stderr, "%s\n%s\n", bar_error.c_str(), tick_error.c_str());
+         return 2;
+        }
+      have_ticks = have_ticks && ticks.Count() > 0;
+      if(from == 0)
+         from = have_ticks ? ticks.TimeMsc()[0] / 1000 :
+                bars.Count() > 0 ? bars.Time()[0] + history_days * 86400 : 0;
+      if(to == 0)
+         to = from + (datetime)(days * 86400);
+      if(have_bars)
+        {
+         size_t begin, end;
+         bars.Range(from - history_days * 86400, from, begin, end);
+         terminal.LoadHistory(symbol, bars, begin, end);
+        }
+      size_t first_tick = have_ticks ? ticks.Seek((long)from * 1000) : 0;
+      size_t last_tick = have_ticks ? ticks.Seek((long)to * 1000) : 0;
+      if(first_tick < last_tick || !have_bars)
+         source.reset(new mql::StoreTickSource(ticks, first_tick, last_tick));
+      else
+        {
+         size_t begin, end;
+         bars.Range(from, to, begin, end);
+         source.reset(new mql::BarTickSource(bars, begin, end, spec.point));
+        }
+     }
+   double load = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+   //--- a new instance with the --set inputs, also used for restarts
+   auto create = [&]() -> std::unique_ptr<mql::Expert>
+     {
+      std::unique_ptr<mql::Expert> instance = mql::CreateExpert(ea);
+      if(instance)
+         for(const auto &kv : overrides)
+            instance->SetInput(kv.first, kv.second);
+      return instance;
+     };
+   std::unique_ptr<mql::Expert> expert = mql::CreateExpert(ea);
+   if(!expert)
+     {
+      std::fprintf(stderr, "unknown expert %s (try --list)\n", ea.c_str());
+      return 2;
+     }
+   for(const auto &kv : overrides)
+      if(!expert->SetInput(kv.first, kv.second))
+        {
+         std::fprintf(stderr, "unknown input %s\n", kv.first.c_str());
+         return 2;
+        }
+   if(show_inputs)
+     {
+      std::vector<std::pair<std::string, std::string>> inputs;
+      expert->ListInputs(inputs);
+      for(const auto &kv : inputs)
+         std::printf("%s=%s\n", kv.first.c_str(), kv.second.c_str());
+      return 0;
+     }
+
+   mql::Backtest backtest(terminal, *expert, *source);
+   if(positions > 0)
+      backtest.OnStart([&](mql::Terminal &t) { OpenPositions(t, *expert, positions); });
+   if(restart_hours > 0)
+      backtest.RestartEvery((int)(restart_hours * 3600), create);
+   mql::BacktestReport report = backtest.Run();
+   if(report.failed)
+      std::fprintf(stderr, "%s: %s\n", ea.c_str(), report.error.c_str());
+   if(report.ticks == 0)
+      return 1;
+
+   std::printf("\n%s on %s %s: %lu ticks in %.3f s (%.0f ticks/s)\n", ea.c_str(), symbol.c_str(),
+               mql::EnumName(config.chart_period).c_str(), report.ticks, report.wall_seconds,
+               report.ticks_per_second);
+   std::printf("  history loaded in %.3f s\n", load);
+   std::printf("  %s - %s, balance %.2f, equity %.2f, open positions %d\n",
+               TimeToString(report.first_tick).c_str(), TimeToString(report.last_tick).c_str(),
+               report.balance, report.equity, report.open_positions);
+   if(report.restarts > 0)
+      std::printf("  expert restarted %d times\n", report.restarts);
+   PrintStats(terminal.Stats());
+   if(report.failed)
+      return 1;
+   return terminal.return_error;
+  }
@@ -0,0 +1,525 @@
+//+------------------------------------------------------------------+
+//|                                                      runtime.cpp |
+//|        Language built-ins: output, formatting, strings, time      |
+//+------------------------------------------------------------------+
+#include "terminal.h"
+
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace mql
+{
+void ArrayOutOfRange(long index, size_t size)
+  {
+   throw RuntimeError("array out of range (index " + std::to_string(index) +
+                      ", size " + std::to_string(size) + ")");
+  }
+
+bool LogEnabled()
+  {
+   return Current().Config().log;
+  }
+
+void LogLine(const std::string &line)
+  {
+   Current().Log(line);
+  }
+
+void SetComment(const std::string &text)
+  {
+   Current().SetComment(text);
+  }
+
+std::string FormatDouble(double value)
+  {
+   char buf[64];
+   std::snprintf(buf, sizeof(buf), "%.16g", value);
+   return buf;
+  }
+
+std::string EnumName(ENUM_TIMEFRAMES value)
+  {
+   switch(value)
+     {
+      case PERIOD_CURRENT: return "PERIOD_CURRENT";
+      case PERIOD_M1:  return "PERIOD_M1";
+      case PERIOD_M2:  return "PERIOD_M2";
+      case PERIOD_M3:  return "PERIOD_M3";
+      case PERIOD_M4:  return "PERIOD_M4";
+      case PERIOD_M5:  return "PERIOD_M5";
+      case PERIOD_M6:  return "PERIOD_M6";
+      case PERIOD_M10: return "PERIOD_M10";
+      case PERIOD_M12: return "PERIOD_M12";
+      case PERIOD_M15: return "PERIOD_M15";
+      case PERIOD_M20: return "PERIOD_M20";
+      case PERIOD_M30: return "PERIOD_M30";
+      case PERIOD_H1:  return "PERIOD_H1";
+      case PERIOD_H2:  return "PERIOD_H2";
+      case PERIOD_H3:  return "PERIOD_H3";
+      case PERIOD_H4:  return "PERIOD_H4";
+      case PERIOD_H6:  return "PERIOD_H6";
+      case PERIOD_H8:  return "PERIOD_H8";
+      case PERIOD_H12: return "PERIOD_H12";
+      case PERIOD_D1:  return "PERIOD_D1";
+      case PERIOD_W1:  return "PERIOD_W1";
+      case PERIOD_MN1: return "PERIOD_MN1";
+     }
+   return std::to_string((int)value);
+  }
+
+//+------------------------------------------------------------------+
+//| printf-style formatting with MQL5 argument rules                 |
+//+------------------------------------------------------------------+
+std::string Format(const char *fmt, const FormatArg *args, size_t count)
+  {
+   std::string out;
+   size_t      next = 0;
+   char        spec[32];
+   char        buf[512];
+   for(const char *p = fmt; *p != 0; p++)
+     {
+      if(*p != '%')
+        {
+         out += *p;
+         continue;
+        }
+      if(p[1] == '%')
+        {
+         out += '%';
+         p++;
+         continue;
+        }
+      //--- collect flags, width and precision; drop length modifiers
+      size_t n = 0;
+      spec[n++] = '%';
+      const char *q = p + 1;
+      while(*q != 0 && std::strchr("-+ #0123456789.", *q) != nullptr && n < sizeof(spec) - 4)
+         spec[n++] = *q++;
+      while(*q == 'l' || *q == 'h' || *q == 'I' || *q == '6' || *q == '4' || *q == 'z')
+         q++;
+      char conv = *q;
+      if(conv == 0)
+         break;
+      p = q;
+      if(next >= count)
+         continue;
+      const FormatArg &a = args[next++];
+      switch(conv)
+        {
+         case 'd':
+         case 'i':
+            spec[n++] = 'l';
+            spec[n++] = 'l';
+            spec[n++] = 'd';
+            spec[n] = 0;
+            std::snprintf(buf, sizeof(buf), spec,
+                          a.kind == FormatArg::REAL ? (long long)a.d :
+                          a.kind == FormatArg::UNSIGNED ? (long long)a.u : a.i);
+            out += buf;
+            break;
+         case 'u':
+         case 'x':
+         case 'X':
+         case 'o':
+            spec[n++] = 'l';
+            spec[n++] = 'l';
+            spec[n++] = conv;
+            spec[n] = 0;
+            std::snprintf(buf, sizeof(buf), spec,
+                          a.kind == FormatArg::UNSIGNED ? a.u :
+                          a.kind == FormatArg::REAL ? (unsigned long long)a.d : (unsigned long long)a.i);
+            out += buf;
+            break;
+         case 'f':
+         case 'F':
+         case 'e':
+         case 'E':
+         case 'g':
+         case 'G':
+            spec[n++] = conv;
+            spec[n] = 0;
+            std::snprintf(buf, sizeof(buf), spec,
+                          a.kind == FormatArg::REAL ? a.d :
+                          a.kind == FormatArg::UNSIGNED ? (double)a.u : (double)a.i);
+            out += buf;
+            break;
+         case 'c':
+            out += (char)(a.kind == FormatArg::UNSIGNED ? a.u : a.i);
+            break;
+         default:
+           {
+            std::string text;
+            switch(a.kind)
+              {
+               case FormatArg::TEXT:     text = a.s; break;
+               case FormatArg::REAL:     text = FormatDouble(a.d); break;
+               case FormatArg::UNSIGNED: text = std::to_string(a.u); break;
+               default:                  text = std::to_string(a.i); break;
+              }
+            spec[n++] = 's';
+            spec[n] = 0;
+            if(n == 2)
+               out += text;
+            else
+              {
+               std::snprintf(buf, sizeof(buf), spec, text.c_str());
+               out += buf;
+              }
+            break;
+           }
+        }
+     }
+   return out;
+  }
+}
+
+using mql::Current;
+
+//+------------------------------------------------------------------+
+//| Common functions                                                 |
+//+------------------------------------------------------------------+
+bool SendNotification(const string &text)
+  {
+   Print("Notification: ", text);
+   return true;
+  }
+
+bool PlaySound(const string &)
+  {
+   return true;
+  }
+
+void Sleep(int milliseconds)
+  {
+   if(milliseconds <= 0)
+      return;
+   mql::Terminal &t = Current();
+   t.clock_ms += (ulong)milliseconds;
+   t.Stats().sleep_ms += (ulong)milliseconds;
+  }
+
+uint GetTickCount()
+  {
+   return (uint)Current().clock_ms;
+  }
+
+ulong GetTickCount64()
+  {
+   return Current().clock_ms;
+  }
+
+ulong GetMicrosecondCount()
+  {
+   using namespace std::chrono;
+   static const steady_clock::time_point start = steady_clock::now();
+   return (ulong)duration_cast<microseconds>(steady_clock::now() - start).count();
+  }
+
+int GetLastError()
+  {
+   return Current().last_error;
+  }
+
+void ResetLastError()
+  {
+   Current().last_error = 0;
+  }
+
+void SetUserError(ushort code)
+  {
+   Current().last_error = ERR_USER_ERROR_FIRST + code;
+  }
+
+int MQLInfoInteger(ENUM_MQL_INFO_INTEGER property)
+  {
+   switch(property)
+     {
+      case MQL_TESTER:        return 1;
+      case MQL_VISUAL_MODE:   return Current().Config().visual ? 1 : 0;
+      case MQL_TRADE_ALLOWED: return 1;
+      default:                return 0;
+     }
+  }
+
+bool IsStopped()
+  {
+   return Current().stop_requested;
+  }
+
+void ExpertRemove()
+  {
+   Current().stop_requested = true;
+  }
+
+void SetReturnError(int ret_code)
+  {
+   Current().return_error = ret_code;
+  }
+
+int PeriodSeconds(ENUM_TIMEFRAMES period)
+  {
+   return mql::TimeframeSeconds(Current().Resolve(period));
+  }
+
+ENUM_TIMEFRAMES Period()
+  {
+   return Current().ChartPeriod();
+  }
+
+const string &Symbol()
+  {
+   return Current().ChartSymbol();
+  }
+
+double Point()
+  {
+   mql::SymbolState *s = Current().FindSymbol("");
+   return s != nullptr ? s->spec.point : 0.0;
+  }
+
+int Digits()
+  {
+   mql::SymbolState *s = Current().FindSymbol("");
+   return s != nullptr ? s->spec.digits : 0;
+  }
+
+//+------------------------------------------------------------------+
+//| Math                                                             |
+//+------------------------------------------------------------------+
+namespace
+{
+thread_local uint t_rand_state = 1;
+}
+
+int MathRand()
+  {
+   t_rand_state = t_rand_state * 214013u + 2531011u;
+   return (int)((t_rand_state >> 16) & 0x7FFF);
+  }
+
+void MathSrand(uint seed)
+  {
+   t_rand_state = seed;
+  }
+
+double NormalizeDouble(double value, int digits)
+  {
+   static const double scale[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8};
+   if(digits < 0)
+      digits = 0;
+   if(digits > 8)
+      digits = 8;
+   return std::round(value * scale[digits]) / scale[digits];
+  }
+
+//+------------------------------------------------------------------+
+//| Conversion and strings                                           |
+//+------------------------------------------------------------------+
+string DoubleToString(double value, int digits)
+  {
+   char buf[128];
+   if(digits < 0 || digits > 16)
+      std::snprintf(buf, sizeof(buf), "%.8e", value);
+   else
+      std::snprintf(buf, sizeof(buf), "%.*f", digits, value);
+   return buf;
+  }
+
+string IntegerToString(long value, int str_len, ushort fill_symbol)
+  {
+   string s = std::to_string(value);
+   if(str_len > (int)s.size())
+      s.insert(0, (size_t)(str_len - (int)s.size()), (char)fill_symbol);
+   return s;
+  }
+
+string TimeToString(datetime value, int mode)
+  {
+   MqlDateTime dt;
+   TimeToStruct(value, dt);
+   char buf[64];
+   string out;
+   if(mode & TIME_DATE)
+     {
+      std::snprintf(buf, sizeof(buf), "%04d.%02d.%02d", dt.year, dt.mon, dt.day);
+      out += buf;
+     }
+   if(mode & (TIME_MINUTES | TIME_SECONDS))
+     {
+      if(!out.empty())
+         out += ' ';
+      if(mode & TIME_SECONDS)
+         std::snprintf(buf, sizeof(buf), "%02d:%02d:%02d", dt.hour, dt.min, dt.sec);
+      else
+         std::snprintf(buf, sizeof(buf), "%02d:%02d", dt.hour, dt.min);
+      out += buf;
+     }
+   return out;
+  }
+
+double StringToDouble(const string &value)
+  {
+   return std::strtod(value.c_str(), nullptr);
+  }
+
+long StringToInteger(const string &value)
+  {
+   return std::strtol(value.c_str(), nullptr, 10);
+  }
+
+datetime StringToTime(const string &value)
+  {
+   MqlDateTime dt = MqlDateTime();
+   std::sscanf(value.c_str(), "%d.%d.%d %d:%d:%d", &dt.year, &dt.mon, &dt.day, &dt.hour, &dt.min, &dt.sec);
+   return StructToTime(dt);
+  }
+
+int StringLen(const string &s)
+  {
+   return (int)s.size();
+  }
+
+int StringFind(const string &s, const string &match, int start)
+  {
+   if(start < 0)
+      start = 0;
+   size_t pos = s.find(match, (size_t)start);
+   return pos == string::npos ? -1 : (int)pos;
+  }
+
+string StringSubstr(const string &s, int start, int length)
+  {
+   if(start < 0 || start >= (int)s.size())
+      return "";
+   return s.substr((size_t)start, length < 0 ? string::npos : (size_t)length);
+  }
+
+int StringReplace(string &s, const string &find, const string &replacement)
+  {
+   if(find.empty())
+      return 0;
+   int    count = 0;
+   size_t pos = 0;
+   while((pos = s.find(find, pos)) != string::npos)
+     {
+      s.replace(pos, find.size(), replacement);
+      pos += replacement.size();
+      count++;
+     }
+   return count;
+  }
+
+bool StringToUpper(string &s)
+  {
+   for(char &c : s)
+      c = (char)std::toupper((unsigned char)c);
+   return true;
+  }
+
+bool StringToLower(string &s)
+  {
+   for(char &c : s)
+      c = (char)std::tolower((unsigned char)c);
+   return true;
+  }
+
+int StringTrimLeft(string &s)
+  {
+   size_t n = 0;
+   while(n < s.size() && std::isspace((unsigned char)s[n]))
+      n++;
+   s.erase(0, n);
+   return (int)n;
+  }
+
+int StringTrimRight(string &s)
+  {
+   size_t n = s.size();
+   while(n > 0 && std::isspace((unsigned char)s[n - 1]))
+      n--;
+   int removed = (int)(s.size() - n);
+   s.resize(n);
+   return removed;
+  }
+
+int StringCompare(const string &a, const string &b, bool case_sensitive)
+  {
+   if(case_sensitive)
+      return a.compare(b) < 0 ? -1 : (a == b ? 0 : 1);
+   string x = a, y = b;
+   StringToLower(x);
+   StringToLower(y);
+   return x.compare(y) < 0 ? -1 : (x == y ? 0 : 1);
+  }
+
+int StringSplit(const string &s, ushort separator, mql::array<string> &result)
+  {
+   std::vector<string> &out = result.Raw();
+   out.clear();
+   size_t start = 0;
+   for(;;)
+     {
+      size_t pos = s.find((char)separator, start);
+      out.push_back(s.substr(start, pos == string::npos ? string::npos : pos - start));
+      if(pos == string::npos)
+         break;
+      start = pos + 1;
+     }
+   return (int)out.size();
+  }
+
+string EnumToString(ENUM_TIMEFRAMES value)
+  {
+   return mql::EnumName(value);
+  }
+
+//+------------------------------------------------------------------+
+//| Date and time                                                    |
+//+------------------------------------------------------------------+
+datetime TimeCurrent()
+  {
+   return Current().Now();
+  }
+
+datetime TimeCurrent(MqlDateTime &dt)
+  {
+   datetime now = Current().Now();
+   TimeToStruct(now, dt);
+   return now;
+  }
+
+datetime TimeTradeServer()
+  {
+   return Current().Now();
+  }
+
+datetime TimeLocal()
+  {
+   return Current().Now();
+  }
+
+datetime TimeGMT()
+  {
+   return Current().Now();
+  }
+
+bool TimeToStruct(datetime value, MqlDateTime &dt)
+  {
+   long days = value >= 0 ? value / 86400 : (value - 86399) / 86400;
+   long secs = value - days * 86400;
+   mql::CivilFromDays(days, dt.year, dt.mon, dt.day);
+   dt.hour = (int)(secs / 3600);
+   dt.min = (int)(secs / 60 % 60);
+   dt.sec = (int)(secs % 60);
+   dt.day_of_week = (int)(((days % 7) + 11) % 7);
+   dt.day_of_year = (int)(days - mql::DaysFromCivil(dt.year, 1, 1));
+   return true;
+  }
+
+datetime StructToTime(MqlDateTime &dt)
+  {
+   long days = mql::DaysFromCivil(dt.year, dt.mon, dt.day);
+   return days * 86400 + dt.hour * 3600 + dt.min * 60 + dt.sec;
+  }
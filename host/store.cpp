@@ -0,0 +1,398 @@
+//+------------------------------------------------------------------+
+//|                                                        store.cpp |
+//+------------------------------------------------------------------+
+#include "store.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mql
+{
+namespace
+{
+const char   COLUMN_MAGIC[8] = {'E', 'A', 'C', 'O', 'L', '0', '0', '1'};
+const size_t HEADER_SIZE = 16;
+const size_t WRITE_BUFFER = 1 << 16;
+
+struct ColumnHeader
+  {
+   char              magic[8];
+   uint              element_size;
+   uint              reserved;
+  };
+
+std::string ColumnPath(const std::string &root, const std::string &symbol, const char *column)
+  {
+   return root + "/" + symbol + "/" + column;
+  }
+
+bool MakeDir(const std::string &path, std::string &error)
+  {
+   if(::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST)
+      return true;
+   error = path + ": " + std::strerror(errno);
+   return false;
+  }
+
+//--- all columns of one table must hold the same number of rows
+bool SameCount(size_t count, const MappedColumn &column, const std::string &symbol, std::string &error)
+  {
+   if(column.Count() == count)
+      return true;
+   error = symbol + ": store columns have different lengths";
+   return false;
+  }
+}
+
+//+------------------------------------------------------------------+
+//| MappedColumn                                                     |
+//+------------------------------------------------------------------+
+MappedColumn::~MappedColumn()
+  {
+   if(m_base != nullptr)
+      ::munmap(m_base, m_size);
+  }
+
+bool MappedColumn::Open(const std::string &path, size_t element_size, std::string &error)
+  {
+   int fd = ::open(path.c_str(), O_RDONLY);
+   if(fd < 0)
+     {
+      error = path + ": " + std::strerror(errno);
+      return false;
+     }
+   struct stat st;
+   if(::fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_SIZE)
+     {
+      ::close(fd);
+      error = path + ": not a store column";
+      return false;
+     }
+   m_size = (size_t)st.st_size;
+   m_base = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+   ::close(fd);
+   if(m_base == MAP_FAILED)
+     {
+      m_base = nullptr;
+      error = path + ": " + std::strerror(errno);
+      return false;
+     }
+   const ColumnHeader *header = (const ColumnHeader *)m_base;
+   if(std::memcmp(header->magic, COLUMN_MAGIC, sizeof(COLUMN_MAGIC)) != 0 ||
+      header->element_size != element_size)
+     {
+      error = path + ": not a store column";
+      return false;
+     }
+   m_count = (m_size - HEADER_SIZE) / element_size;
+   return true;
+  }
+
+const void *MappedColumn::Data() const
+  {
+   return m_base == nullptr ? nullptr : (const char *)m_base + HEADER_SIZE;
+  }
+
+//+------------------------------------------------------------------+
+//| TickStore                                                        |
+//+------------------------------------------------------------------+
+bool TickStore::Open(const std::string &root, const std::string &symbol, std::string &error)
+  {
+   if(!m_time_msc.Open(ColumnPath(root, symbol, "ticks.time_msc"), sizeof(long), error) ||
+      !m_bid.Open(ColumnPath(root, symbol, "ticks.bid"), sizeof(double), error) ||
+      !m_ask.Open(ColumnPath(root, symbol, "ticks.ask"), sizeof(double), error) ||
+      !m_last.Open(ColumnPath(root, symbol, "ticks.last"), sizeof(double), error) ||
+      !m_volume.Open(ColumnPath(root, symbol, "ticks.volume"), sizeof(double), error) ||
+      !m_flags.Open(ColumnPath(root, symbol, "ticks.flags"), sizeof(uint), error))
+      return false;
+   m_count = m_time_msc.Count();
+   return SameCount(m_count, m_bid, symbol, error) && SameCount(m_count, m_ask, symbol, error) &&
+          SameCount(m_count, m_last, symbol, error) && SameCount(m_count, m_volume, symbol, error) &&
+          SameCount(m_count, m_flags, symbol, error);
+  }
+
+size_t TickStore::Seek(long time_msc) const
+  {
+   return (size_t)(std::lower_bound(TimeMsc(), TimeMsc() + m_count, time_msc) - TimeMsc());
+  }
+
+void TickStore::Get(size_t index, MqlTick &tick) const
+  {
+   tick.time_msc = TimeMsc()[index];
+   tick.time = (datetime)(tick.time_msc / 1000);
+   tick.bid = Bid()[index];
+   tick.ask = Ask()[index];
+   tick.last = Last()[index];
+   tick.volume_real = Volume()[index];
+   tick.volume = (ulong)tick.volume_real;
+   tick.flags = Flags()[index];
+  }
+
+//+------------------------------------------------------------------+
+//| BarStore                                                         |
+//+------------------------------------------------------------------+
+bool BarStore::Open(const std::string &root, const std::string &symbol, std::string &error)
+  {
+   if(!m_time.Open(ColumnPath(root, symbol, "m1.time"), sizeof(datetime), error) ||
+      !m_open.Open(ColumnPath(root, symbol, "m1.open"), sizeof(double), error) ||
+      !m_high.Open(ColumnPath(root, symbol, "m1.high"), sizeof(double), error) ||
+      !m_low.Open(ColumnPath(root, symbol, "m1.low"), sizeof(double), error) ||
+      !m_close.Open(ColumnPath(root, symbol, "m1.close"), sizeof(double), error) ||
+      !m_tick_volume.Open(ColumnPath(root, symbol, "m1.tick_volume"), sizeof(long), error) ||
+      !m_real_volume.Open(ColumnPath(root, symbol, "m1.real_volume"), sizeof(long), error) ||
+      !m_spread.Open(ColumnPath(root, symbol, "m1.spread"), sizeof(int), error))
+      return false;
+   m_count = m_time.Count();
+   return SameCount(m_count, m_open, symbol, error) && SameCount(m_count, m_high, symbol, error) &&
+          SameCount(m_count, m_low, symbol, error) && SameCount(m_count, m_close, symbol, error) &&
+          SameCount(m_count, m_tick_volume, symbol, error) && SameCount(m_count, m_real_volume, symbol, error) &&
+          SameCount(m_count, m_spread, symbol, error);
+  }
+
+size_t BarStore::Seek(datetime time) const
+  {
+   return (size_t)(std::lower_bound(Time(), Time() + m_count, time) - Time());
+  }
+
+void BarStore::Range(datetime from, datetime to, size_t &begin, size_t &end) const
+  {
+   begin = Seek(from);
+   end = std::max(begin, Seek(to));
+  }
+
+size_t BarStore::Window(datetime time, int &count) const
+  {
+   //--- one past the last bar that opened at or before "time"
+   size_t end = (size_t)(std::upper_bound(Time(), Time() + m_count, time) - Time());
+   if(count < 0)
+      count = 0;
+   if((size_t)count > end)
+      count = (int)end;
+   return end - (size_t)count;
+  }
+
+int BarStore::CopyRates(datetime time, int count, MqlRates *rates) const
+  {
+   size_t begin = Window(time, count);
+   for(int i = 0; i < count; i++)
+      Get(begin + (size_t)i, rates[i]);
+   return count;
+  }
+
+int BarStore::CopyClose(datetime time, int count, double *close) const
+  {
+   size_t begin = Window(time, count);
+   std::memcpy(close, Close() + begin, (size_t)count * sizeof(double));
+   return count;
+  }
+
+int BarStore::CopyHigh(datetime time, int count, double *high) const
+  {
+   size_t begin = Window(time, count);
+   std::memcpy(high, High() + begin, (size_t)count * sizeof(double));
+   return count;
+  }
+
+int BarStore::CopyLow(datetime time, int count, double *low) const
+  {
+   size_t begin = Window(time, count);
+   std::memcpy(low, Low() + begin, (size_t)count * sizeof(double));
+   return count;
+  }
+
+void BarStore::Get(size_t index, MqlRates &bar) const
+  {
+   bar.time = Time()[index];
+   bar.open = Open()[index];
+   bar.high = High()[index];
+   bar.low = Low()[index];
+   bar.close = Close()[index];
+   bar.tick_volume = TickVolume()[index];
+   bar.real_volume = RealVolume()[index];
+   bar.spread = Spread()[index];
+  }
+
+//+------------------------------------------------------------------+
+//| ColumnWriter                                                     |
+//+------------------------------------------------------------------+
+bool ColumnWriter::Open(const std::string &path, size_t element_size, std::string &error)
+  {
+   Close();
+   m_element = element_size;
+   m_used = 0;
+   m_existing = 0;
+   m_buffer.assign(WRITE_BUFFER * element_size, 0);
+   m_file = std::fopen(path.c_str(), "r+b");
+   if(m_file != nullptr)
+     {
+      ColumnHeader header;
+      if(std::fread(&header, sizeof(header), 1, m_file) != 1 ||
+         std::memcmp(header.magic, COLUMN_MAGIC, sizeof(COLUMN_MAGIC)) != 0 ||
+         header.element_size != element_size)
+        {
+         Close();
+         error = path + ": not a store column";
+         return false;
+        }
+      std::fseek(m_file, 0, SEEK_END);
+      long size = std::ftell(m_file);
+      m_existing = (size_t)(size - (long)HEADER_SIZE) / element_size;
+      //--- drop a torn trailing element left by an interrupted write
+      std::fseek(m_file, (long)(HEADER_SIZE + m_existing * element_size), SEEK_SET);
+      return true;
+     }
+   m_file = std::fopen(path.c_str(), "w+b");
+   if(m_file == nullptr)
+     {
+      error = path + ": " + std::strerror(errno);
+      return false;
+     }
+   ColumnHeader header = ColumnHeader();
+   std::memcpy(header.magic, COLUMN_MAGIC, sizeof(COLUMN_MAGIC));
+   header.element_size = (uint)element_size;
+   if(std::fwrite(&header, sizeof(header), 1, m_file) != 1)
+     {
+      Close();
+      error = path + ": " + std::strerror(errno);
+      return false;
+     }
+   return true;
+  }
+
+bool ColumnWriter::ReadLast(void *value)
+  {
+   if(m_file == nullptr || m_existing == 0)
+      return false;
+   long end = (long)(HEADER_SIZE + m_existing * m_element);
+   std::fseek(m_file, end - (long)m_element, SEEK_SET);
+   bool ok = std::fread(value, m_element, 1, m_file) == 1;
+   std::fseek(m_file, end, SEEK_SET);
+   return ok;
+  }
+
+bool ColumnWriter::Flush()
+  {
+   if(m_file == nullptr || m_used == 0)
+      return m_file != nullptr;
+   bool ok = std::fwrite(m_buffer.data(), 1, m_used, m_file) == m_used;
+   m_used = 0;
+   return ok;
+  }
+
+bool ColumnWriter::Close()
+  {
+   if(m_file == nullptr)
+      return true;
+   bool ok = Flush();
+   ok = std::fclose(m_file) == 0 && ok;
+   m_file = nullptr;
+   return ok;
+  }
+
+//+------------------------------------------------------------------+
+//| TickWriter / BarWriter                                           |
+//+------------------------------------------------------------------+
+bool TickWriter::Open(const std::string &root, const std::string &symbol, std::string &error)
+  {
+   if(!MakeDir(root, error) || !MakeDir(root + "/" + symbol, error))
+      return false;
+   if(!m_time_msc.Open(ColumnPath(root, symbol, "ticks.time_msc"), sizeof(long), error) ||
+      !m_bid.Open(ColumnPath(root, symbol, "ticks.bid"), sizeof(double), error) ||
+      !m_ask.Open(ColumnPath(root, symbol, "ticks.ask"), sizeof(double), error) ||
+      !m_last.Open(ColumnPath(root, symbol, "ticks.last"), sizeof(double), error) ||
+      !m_volume.Open(ColumnPath(root, symbol, "ticks.volume"), sizeof(double), error) ||
+      !m_flags.Open(ColumnPath(root, symbol, "ticks.flags"), sizeof(uint), error))
+      return false;
+   size_t n = m_time_msc.Existing();
+   if(m_bid.Existing() != n || m_ask.Existing() != n || m_last.Existing() != n ||
+      m_volume.Existing() != n || m_flags.Existing() != n)
+     {
+      error = symbol + ": store columns have different lengths";
+      return false;
+     }
+   m_last_msc = 0;
+   m_time_msc.ReadLast(&m_last_msc);
+   m_written = 0;
+   return true;
+  }
+
+void TickWriter::Append(const MqlTick &tick)
+  {
+   long   msc = tick.time_msc != 0 ? tick.time_msc : (long)tick.time * 1000;
+   double volume = tick.volume_real != 0.0 ? tick.volume_real : (double)tick.volume;
+   m_time_msc.Put(&msc);
+   m_bid.Put(&tick.bid);
+   m_ask.Put(&tick.ask);
+   m_last.Put(&tick.last);
+   m_volume.Put(&volume);
+   m_flags.Put(&tick.flags);
+   m_last_msc = msc;
+   m_written++;
+  }
+
+bool TickWriter::Close()
+  {
+   bool ok = m_time_msc.Close();
+   ok = m_bid.Close() && ok;
+   ok = m_ask.Close() && ok;
+   ok = m_last.Close() && ok;
+   ok = m_volume.Close() && ok;
+   return m_flags.Close() && ok;
+  }
+
+bool BarWriter::Open(const std::string &root, const std::string &symbol, std::string &error)
+  {
+   if(!MakeDir(root, error) || !MakeDir(root + "/" + symbol, error))
+      return false;
+   if(!m_time.Open(ColumnPath(root, symbol, "m1.time"), sizeof(datetime), error) ||
+      !m_open.Open(ColumnPath(root, symbol, "m1.open"), sizeof(double), error) ||
+      !m_high.Open(ColumnPath(root, symbol, "m1.high"), sizeof(double), error) ||
+      !m_low.Open(ColumnPath(root, symbol, "m1.low"), sizeof(double), error) ||
+      !m_close.Open(ColumnPath(root, symbol, "m1.close"), sizeof(double), error) ||
+      !m_tick_volume.Open(ColumnPath(root, symbol, "m1.tick_volume"), sizeof(long), error) ||
+      !m_real_volume.Open(ColumnPath(root, symbol, "m1.real_volume"), sizeof(long), error) ||
+      !m_spread.Open(ColumnPath(root, symbol, "m1.spread"), sizeof(int), error))
+      return false;
+   size_t n = m_time.Existing();
+   if(m_open.Existing() != n || m_high.Existing() != n || m_low.Existing() != n ||
+      m_close.Existing() != n || m_tick_volume.Existing() != n || m_real_volume.Existing() != n ||
+      m_spread.Existing() != n)
+     {
+      error = symbol + ": store columns have different lengths";
+      return false;
+     }
+   m_last_time = 0;
+   m_time.ReadLast(&m_last_time);
+   m_written = 0;
+   return true;
+  }
+
+void BarWriter::Append(const MqlRates &bar)
+  {
+   m_time.Put(&bar.time);
+   m_open.Put(&bar.open);
+   m_high.Put(&bar.high);
+   m_low.Put(&bar.low);
+   m_close.Put(&bar.close);
+   m_tick_volume.Put(&bar.tick_volume);
+   m_real_volume.Put(&bar.real_volume);
+   m_spread.Put(&bar.spread);
+   m_last_time = bar.time;
+   m_written++;
+  }
+
+bool BarWriter::Close()
+  {
+   bool ok = m_time.Close();
+   ok = m_open.Close() && ok;
+   ok = m_high.Close() && ok;
+   ok = m_low.Close() && ok;
+   ok = m_close.Close() && ok;
+   ok = m_tick_volume.Close() && ok;
+   ok = m_real_volume.Close() && ok;
+   return m_spread.Close() && ok;
+  }
+}
@@ -0,0 +1,201 @@
+//+------------------------------------------------------------------+
+//|                                                          store.h |
+//|                  Columnar on-disk tick and M1 bar history (mmap)  |
+//+------------------------------------------------------------------+
+// Layout, one directory per symbol under the store root:
+//
+//   <root>/<SYMBOL>/ticks.time_msc  ticks.bid  ticks.ask  ticks.last
+//                   ticks.volume    ticks.flags
+//   <root>/<SYMBOL>/m1.time  m1.open  m1.high  m1.low  m1.close
+//                   m1.tick_volume  m1.real_volume  m1.spread
+//
+// Every column file is a 16 byte header (magic, element size) followed
+// by the raw little-endian values, oldest first. Readers map the files
+// and use the columns in place: opening a store parses nothing, seeking
+// by time is a binary search on the time column, and bar lookups are
+// slices of the mapped columns. Writers append column by column through
+// fixed-size buffers, so memory stays bounded whatever the input size.
+#ifndef EA_HOST_STORE_H
+#define EA_HOST_STORE_H
+
+#include "mql5.h"
+
+#include <cstring>
+
+namespace mql
+{
+//+------------------------------------------------------------------+
+//| Read-only memory mapping of one column file                      |
+//+------------------------------------------------------------------+
+class MappedColumn
+  {
+public:
+                     MappedColumn() : m_base(nullptr), m_size(0), m_count(0) {}
+                    ~MappedColumn();
+                     MappedColumn(const MappedColumn &) = delete;
+   MappedColumn     &operator=(const MappedColumn &) = delete;
+
+   bool              Open(const std::string &path, size_t element_size, std::string &error);
+   size_t            Count() const { return m_count; }
+   const void       *Data() const;
+
+private:
+   void             *m_base;
+   size_t            m_size;
+   size_t            m_count;
+  };
+
+//+------------------------------------------------------------------+
+//| Ticks of one symbol                                              |
+//+------------------------------------------------------------------+
+class TickStore
+  {
+public:
+   bool              Open(const std::string &root, const std::string &symbol, std::string &error);
+   size_t            Count() const { return m_count; }
+
+   const long       *TimeMsc() const { return (const long *)m_time_msc.Data(); }
+   const double     *Bid() const     { return (const double *)m_bid.Data(); }
+   const double     *Ask() const     { return (const double *)m_ask.Data(); }
+   const double     *Last() const    { return (const double *)m_last.Data(); }
+   const double     *Volume() const  { return (const double *)m_volume.Data(); }
+   const uint       *Flags() const   { return (const uint *)m_flags.Data(); }
+
+   //--- index of the first tick at or after time_msc (Count() if none)
+   size_t            Seek(long time_msc) const;
+   void              Get(size_t index, MqlTick &tick) const;
+
+private:
+   size_t            m_count = 0;
+   MappedColumn      m_time_msc;
+   MappedColumn      m_bid;
+   MappedColumn      m_ask;
+   MappedColumn      m_last;
+   MappedColumn      m_volume;
+   MappedColumn      m_flags;
+  };
+
+//+------------------------------------------------------------------+
+//| M1 bars of one symbol                                            |
+//+------------------------------------------------------------------+
+class BarStore
+  {
+public:
+   bool              Open(const std::string &root, const std::string &symbol, std::string &error);
+   size_t            Count() const { return m_count; }
+
+   const datetime   *Time() const       { return (const datetime *)m_time.Data(); }
+   const double     *Open() const       { return (const double *)m_open.Data(); }
+   const double     *High() const       { return (const double *)m_high.Data(); }
+   const double     *Low() const        { return (const double *)m_low.Data(); }
+   const double     *Close() const      { return (const double *)m_close.Data(); }
+   const long       *TickVolume() const { return (const long *)m_tick_volume.Data(); }
+   const long       *RealVolume() const { return (const long *)m_real_volume.Data(); }
+   const int        *Spread() const     { return (const int *)m_spread.Data(); }
+
+   //--- index of the first bar opening at or after "time" (Count() if none)
+   size_t            Seek(datetime time) const;
+   //--- bars opening in [from, to): the slice [begin, end) of every column
+   void              Range(datetime from, datetime to, size_t &begin, size_t &end) const;
+   //--- CopyRates/CopyClose-style reads: "count" bars ending at the last
+   //--- bar that opened at or before "time", oldest first
+   int               CopyRates(datetime time, int count, MqlRates *rates) const;
+   int               CopyClose(datetime time, int count, double *close) const;
+   int               CopyHigh(datetime time, int count, double *high) const;
+   int               CopyLow(datetime time, int count, double *low) const;
+   void              Get(size_t index, MqlRates &bar) const;
+
+private:
+   size_t            Window(datetime time, int &count) const;
+
+   size_t            m_count = 0;
+   MappedColumn      m_time;
+   MappedColumn      m_open;
+   MappedColumn      m_high;
+   MappedColumn      m_low;
+   MappedColumn      m_close;
+   MappedColumn      m_tick_volume;
+   MappedColumn      m_real_volume;
+   MappedColumn      m_spread;
+  };
+
+//+------------------------------------------------------------------+
+//| Buffered append-only writers                                     |
+//+------------------------------------------------------------------+
+class ColumnWriter
+  {
+public:
+                     ColumnWriter() : m_file(nullptr), m_element(0), m_used(0) {}
+                    ~ColumnWriter() { Close(); }
+                     ColumnWriter(const ColumnWriter &) = delete;
+   ColumnWriter     &operator=(const ColumnWriter &) = delete;
+
+   //--- appends to an existing column, creates it otherwise
+   bool              Open(const std::string &path, size_t element_size, std::string &error);
+   void              Put(const void *value)
+     {
+      std::memcpy(&m_buffer[m_used], value, m_element);
+      m_used += m_element;
+      if(m_used == m_buffer.size())
+         Flush();
+     }
+   bool              Flush();
+   bool              Close();
+   //--- elements already in the file when it was opened, and the last one
+   size_t            Existing() const { return m_existing; }
+   bool              ReadLast(void *value);
+
+private:
+   FILE             *m_file;
+   size_t            m_element;
+   size_t            m_used;
+   size_t            m_existing = 0;
+   std::vector<char> m_buffer;
+  };
+
+class TickWriter
+  {
+public:
+   //--- opens (or creates) <root>/<symbol>/ticks.*; LastTime() is the
+   //--- time of the last stored tick, 0 for a new store
+   bool              Open(const std::string &root, const std::string &symbol, std::string &error);
+   void              Append(const MqlTick &tick);
+   bool              Close();
+   long              LastTime() const { return m_last_msc; }
+   size_t            Written() const  { return m_written; }
+
+private:
+   ColumnWriter      m_time_msc;
+   ColumnWriter      m_bid;
+   ColumnWriter      m_ask;
+   ColumnWriter      m_last;
+   ColumnWriter      m_volume;
+   ColumnWriter      m_flags;
+   long              m_last_msc = 0;
+   size_t            m_written = 0;
+  };
+
+class BarWriter
+  {
+public:
+   bool              Open(const std::string &root, const std::string &symbol, std::string &error);
+   void              Append(const MqlRates &bar);
+   bool              Close();
+   datetime          LastTime() const { return m_last_time; }
+   size_t            Written() const  { return m_written; }
+
+private:
+   ColumnWriter      m_time;
+   ColumnWriter      m_open;
+   ColumnWriter      m_high;
+   ColumnWriter      m_low;
+   ColumnWriter      m_close;
+   ColumnWriter      m_tick_volume;
+   ColumnWriter      m_real_volume;
+   ColumnWriter      m_spread;
+   datetime          m_last_time = 0;
+   size_t            m_written = 0;
+  };
+}
+
+#endif // EA_HOST_STORE_H
@@ -0,0 +1,66 @@
+//+------------------------------------------------------------------+
+//|                                                    synthetic.cpp |
+//+------------------------------------------------------------------+
+#include "synthetic.h"
+
+namespace mql
+{
+SyntheticMarket::SyntheticMarket(const SymbolSpec &spec, const SyntheticConfig &config)
+   : m_spec(spec), m_config(config), m_rng(config.seed), m_normal(0.0, 1.0)
+  {
+   bool crypto = spec.name.compare(0, 3, "BTC") == 0 || spec.name.compare(0, 3, "ETH") == 0;
+   m_price = config.start_price > 0 ? config.start_price :
+             crypto ? 60000.0 : spec.name.compare(0, 3, "XAU") == 0 ? 2000.0 :
+             spec.digits == 3 ? 150.0 : 1.1;
+   double per_minute = config.volatility > 0 ? config.volatility : (crypto ? 0.0012 : 0.0003);
+   int    tpm = config.ticks_per_minute > 0 ? config.ticks_per_minute : 30;
+   m_sigma = per_minute / std::sqrt((double)tpm);
+   m_spread = (config.spread_points > 0 ? config.spread_points : (crypto ? 1500.0 : 12.0)) * spec.point;
+   m_time_msc = (long)config.start * 1000;
+   m_step_msc = 60000 / tpm;
+  }
+
+double SyntheticMarket::Step()
+  {
+   m_price *= std::exp(m_sigma * m_normal(m_rng));
+   m_time_msc += m_step_msc;
+   return NormalizeDouble(m_price, m_spec.digits);
+  }
+
+std::vector<MqlRates> SyntheticMarket::History(int minutes)
+  {
+   std::vector<MqlRates> bars;
+   bars.reserve((size_t)std::max(0, minutes));
+   long ticks = 60000 / m_step_msc;
+   for(int i = 0; i < minutes; i++)
+     {
+      MqlRates bar = MqlRates();
+      bar.time = (datetime)(m_time_msc / 1000);
+      bar.open = bar.high = bar.low = bar.close = NormalizeDouble(m_price, m_spec.digits);
+      for(long k = 0; k < ticks; k++)
+        {
+         double p = Step();
+         bar.high = std::max(bar.high, p);
+         bar.low = std::min(bar.low, p);
+         bar.close = p;
+        }
+      bar.tick_volume = ticks;
+      bar.spread = (int)std::lround(m_spread / m_spec.point);
+      bars.push_back(bar);
+     }
+   return bars;
+  }
+
+void SyntheticMarket::Next(MqlTick &tick)
+  {
+   double bid = Step();
+   tick = MqlTick();
+   tick.time_msc = m_time_msc;
+   tick.time = (datetime)(m_time_msc / 1000);
+   tick.bid = bid;
+   tick.ask = NormalizeDouble(bid + m_spread, m_spec.digits);
+   tick.last = bid;
+   tick.volume = 1;
+   tick.flags = 6;
+  }
+}
@@ -0,0 +1,50 @@
+//+------------------------------------------------------------------+
+//|                                                      synthetic.h |
+//|            Random-walk market used when no recorded data is given |
+//+------------------------------------------------------------------+
+#ifndef EA_HOST_SYNTHETIC_H
+#define EA_HOST_SYNTHETIC_H
+
+#include "terminal.h"
+
+#include <random>
+
+namespace mql
+{
+struct SyntheticConfig
+  {
+   double            start_price = 0.0;     // 0 = pick from the symbol name
+   double            volatility = 0.0;      // per-minute relative sigma, 0 = default
+   double            spread_points = 0.0;   // 0 = default for the symbol
+   int               ticks_per_minute = 30;
+   datetime          start = 1704067200;    // 2024.01.01 00:00
+   uint              seed = 1;
+  };
+
+class SyntheticMarket
+  {
+public:
+                     SyntheticMarket(const SymbolSpec &spec, const SyntheticConfig &config);
+
+   //--- M1 bars for the next "minutes" minutes (used as warm-up history)
+   std::vector<MqlRates> History(int minutes);
+   //--- next tick of the walk; never runs dry
+   void              Next(MqlTick &tick);
+   datetime          Time() const { return (datetime)(m_time_msc / 1000); }
+
+private:
+   double            Step();
+
+   SymbolSpec        m_spec;
+   SyntheticConfig   m_config;
+   std::mt19937_64   m_rng;
+   std::normal_distribution<double> m_normal;
+   double            m_price;
+   double            m_sigma;
+   double            m_spread;
+   long              m_time_msc;
+   long              m_step_msc;
+  };
+}
+
+#endif // EA_HOST_SYNTHETIC_H
@@ -0,0 +1,1228 @@
+//+------------------------------------------------------------------+
+//|                                                     terminal.cpp |
+//+------------------------------------------------------------------+
+#include "terminal.h"
+#include "indicators.h"
+#include "store.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+namespace mql
+{
+namespace
+{
+thread_local Terminal *t_current = nullptr;
+
+const double VOLUME_EPSILON = 1e-8;
+
+bool IsBuy(ENUM_ORDER_TYPE type)
+  {
+   return type == ORDER_TYPE_BUY || type == ORDER_TYPE_BUY_LIMIT || type == ORDER_TYPE_BUY_STOP;
+  }
+}
+
+Terminal &Current()
+  {
+   if(t_current == nullptr)
+      throw RuntimeError("no terminal bound to this thread");
+   return *t_current;
+  }
+
+void Bind(Terminal *terminal)
+  {
+   t_current = terminal;
+  }
+
+//+------------------------------------------------------------------+
+//| Symbol presets                                                   |
+//+------------------------------------------------------------------+
+SymbolSpec PresetSymbol(const std::string &name)
+  {
+   SymbolSpec spec;
+   spec.name = name;
+   spec.description = name;
+   if(name.compare(0, 3, "BTC") == 0 || name.compare(0, 3, "ETH") == 0)
+     {
+      spec.digits = 2;
+      spec.point = spec.tick_size = 0.01;
+      spec.tick_value = 0.01;
+      spec.contract_size = 1.0;
+      spec.volume_min = 0.01;
+      spec.volume_step = 0.01;
+      spec.volume_max = 100.0;
+     }
+   else if(name.compare(0, 3, "XAU") == 0)
+     {
+      spec.digits = 2;
+      spec.point = spec.tick_size = 0.01;
+      spec.tick_value = 1.0;
+      spec.contract_size = 100.0;
+     }
+   else if(name.find("JPY") != std::string::npos)
+     {
+      spec.digits = 3;
+      spec.point = spec.tick_size = 0.001;
+      spec.tick_value = 0.67;
+     }
+   return spec;
+  }
+
+//+------------------------------------------------------------------+
+//| Calendar                                                         |
+//+------------------------------------------------------------------+
+long DaysFromCivil(int year, int month, int day)
+  {
+   year -= month <= 2;
+   long era = (year >= 0 ? year : year - 399) / 400;
+   unsigned yoe = (unsigned)(year - era * 400);
+   unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+   unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+   return era * 146097 + (long)doe - 719468;
+  }
+
+void CivilFromDays(long days, int &year, int &month, int &day)
+  {
+   days += 719468;
+   long era = (days >= 0 ? days : days - 146096) / 146097;
+   unsigned doe = (unsigned)(days - era * 146097);
+   unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+   unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+   unsigned mp = (5 * doy + 2) / 153;
+   day = (int)(doy - (153 * mp + 2) / 5 + 1);
+   month = (int)(mp < 10 ? mp + 3 : mp - 9);
+   year = (int)(yoe + era * 400 + (month <= 2));
+  }
+
+int TimeframeSeconds(ENUM_TIMEFRAMES tf)
+  {
+   switch(tf)
+     {
+      case PERIOD_D1:  return 86400;
+      case PERIOD_W1:  return 604800;
+      case PERIOD_MN1: return 2592000;
+      default:
+         break;
+     }
+   int v = (int)tf;
+   if(v >= 16385)
+      return (v - 16384) * 3600;
+   return v * 60;
+  }
+
+datetime BarStart(datetime time, ENUM_TIMEFRAMES tf)
+  {
+   if(tf == PERIOD_W1)
+     {
+      //--- weeks open on Sunday; 1970-01-04 was one
+      const long sunday = 3 * 86400;
+      long offset = (time - sunday) % 604800;
+      if(offset < 0)
+         offset += 604800;
+      return time - offset;
+     }
+   if(tf == PERIOD_MN1)
+     {
+      int y, m, d;
+      long days = time >= 0 ? time / 86400 : (time - 86399) / 86400;
+      CivilFromDays(days, y, m, d);
+      return DaysFromCivil(y, m, 1) * 86400;
+     }
+   long secs = TimeframeSeconds(tf);
+   long offset = time % secs;
+   if(offset < 0)
+      offset += secs;
+   return time - offset;
+  }
+
+datetime BarEnd(datetime start, ENUM_TIMEFRAMES tf)
+  {
+   if(tf == PERIOD_MN1)
+     {
+      int y, m, d;
+      CivilFromDays(start / 86400, y, m, d);
+      if(++m > 12)
+        {
+         m = 1;
+         y++;
+        }
+      return DaysFromCivil(y, m, 1) * 86400;
+     }
+   return start + TimeframeSeconds(tf);
+  }
+
+bool ParseTimeframe(const std::string &text, ENUM_TIMEFRAMES &tf)
+  {
+   static const ENUM_TIMEFRAMES all[] =
+     {
+      PERIOD_M1, PERIOD_M2, PERIOD_M3, PERIOD_M4, PERIOD_M5, PERIOD_M6, PERIOD_M10,
+      PERIOD_M12, PERIOD_M15, PERIOD_M20, PERIOD_M30, PERIOD_H1, PERIOD_H2, PERIOD_H3,
+      PERIOD_H4, PERIOD_H6, PERIOD_H8, PERIOD_H12, PERIOD_D1, PERIOD_W1, PERIOD_MN1
+     };
+   std::string name = text.compare(0, 7, "PERIOD_") == 0 ? text : "PERIOD_" + text;
+   for(ENUM_TIMEFRAMES candidate : all)
+      if(EnumName(candidate) == name)
+        {
+         tf = candidate;
+         return true;
+        }
+   return false;
+  }
+
+//+------------------------------------------------------------------+
+//| Series                                                           |
+//+------------------------------------------------------------------+
+Series::Series(ENUM_TIMEFRAMES tf) : m_tf(tf), m_version(0), m_bar_end(0)
+  {
+  }
+
+void Series::Reserve(size_t bars)
+  {
+   m_time.reserve(bars);
+   m_open.reserve(bars);
+   m_high.reserve(bars);
+   m_low.reserve(bars);
+   m_close.reserve(bars);
+   m_tick_volume.reserve(bars);
+   m_real_volume.reserve(bars);
+   m_spread.reserve(bars);
+  }
+
+void Series::OpenBar(datetime start, double price, long tick_volume, long real_volume, int spread)
+  {
+   m_time.push_back(start);
+   m_open.push_back(price);
+   m_high.push_back(price);
+   m_low.push_back(price);
+   m_close.push_back(price);
+   m_tick_volume.push_back(tick_volume);
+   m_real_volume.push_back(real_volume);
+   m_spread.push_back(spread);
+   m_bar_end = BarEnd(start, m_tf);
+  }
+
+void Series::Merge(const MqlRates &bar)
+  {
+   m_version++;
+   if(m_time.empty() || bar.time >= m_bar_end)
+     {
+      OpenBar(BarStart(bar.time, m_tf), bar.open, bar.tick_volume, bar.real_volume, bar.spread);
+      size_t last = m_time.size() - 1;
+      m_high[last] = bar.high;
+      m_low[last] = bar.low;
+      m_close[last] = bar.close;
+      return;
+     }
+   size_t last = m_time.size() - 1;
+   if(bar.high > m_high[last])
+      m_high[last] = bar.high;
+   if(bar.low < m_low[last])
+      m_low[last] = bar.low;
+   m_close[last] = bar.close;
+   m_tick_volume[last] += bar.tick_volume;
+   m_real_volume[last] += bar.real_volume;
+   if(bar.spread < m_spread[last])
+      m_spread[last] = bar.spread;
+  }
+
+void Series::Append(const datetime *time, const double *open, const double *high, const double *low,
+                    const double *close, const long *tick_volume, const long *real_volume,
+                    const int *spread, size_t count)
+  {
+   if(count == 0)
+      return;
+   if(m_tf != PERIOD_M1 || (!m_time.empty() && time[0] < m_bar_end))
+     {
+      //--- not a plain continuation, aggregate bar by bar
+      MqlRates bar;
+      for(size_t i = 0; i < count; i++)
+        {
+         bar.time = time[i];
+         bar.open = open[i];
+         bar.high = high[i];
+         bar.low = low[i];
+         bar.close = close[i];
+         bar.tick_volume = tick_volume[i];
+         bar.real_volume = real_volume[i];
+         bar.spread = spread[i];
+         Merge(bar);
+        }
+      return;
+     }
+   m_version++;
+   m_time.insert(m_time.end(), time, time + count);
+   m_open.insert(m_open.end(), open, open + count);
+   m_high.insert(m_high.end(), high, high + count);
+   m_low.insert(m_low.end(), low, low + count);
+   m_close.insert(m_close.end(), close, close + count);
+   m_tick_volume.insert(m_tick_volume.end(), tick_volume, tick_volume + count);
+   m_real_volume.insert(m_real_volume.end(), real_volume, real_volume + count);
+   m_spread.insert(m_spread.end(), spread, spread + count);
+   m_bar_end = BarEnd(m_time.back(), m_tf);
+  }
+
+void Series::Tick(datetime time, double price, long volume, int spread)
+  {
+   m_version++;
+   if(m_time.empty() || time >= m_bar_end)
+     {
+      OpenBar(BarStart(time, m_tf), price, 1, volume, spread);
+      return;
+     }
+   size_t last = m_time.size() - 1;
+   if(price > m_high[last])
+      m_high[last] = price;
+   if(price < m_low[last])
+      m_low[last] = price;
+   m_close[last] = price;
+   m_tick_volume[last]++;
+   m_real_volume[last] += volume;
+   if(spread < m_spread[last])
+      m_spread[last] = spread;
+  }
+
+bool Series::Rates(int index, MqlRates &bar) const
+  {
+   if(index < 0 || index >= Total())
+      return false;
+   bar.time = m_time[index];
+   bar.open = m_open[index];
+   bar.high = m_high[index];
+   bar.low = m_low[index];
+   bar.close = m_close[index];
+   bar.tick_volume = m_tick_volume[index];
+   bar.spread = m_spread[index];
+   bar.real_volume = m_real_volume[index];
+   return true;
+  }
+
+//+------------------------------------------------------------------+
+//| Terminal                                                         |
+//+------------------------------------------------------------------+
+Terminal::Terminal(const TerminalConfig &config)
+   : last_error(0), selected_position(0), selected_order(0), clock_ms(0), stop_requested(false), return_error(0),
+     m_config(config), m_now(0), m_balance(0.0), m_next_order(2), m_next_deal(2), m_next_request(1), m_chart(nullptr),
+     m_files_dir(config.files_dir), m_files_scratch(false)
+  {
+   std::memset(&m_stats, 0, sizeof(m_stats));
+  }
+
+Terminal::~Terminal()
+  {
+   for(FileHandle &file : m_files)
+      if(file.stream != nullptr)
+         std::fclose(file.stream);
+   if(m_files_scratch)
+     {
+      std::error_code ec;
+      std::filesystem::remove_all(m_files_dir, ec);
+     }
+  }
+
+SymbolState &Terminal::AddSymbol(const SymbolSpec &spec)
+  {
+   std::unique_ptr<SymbolState> &slot = m_symbols[spec.name];
+   if(!slot)
+     {
+      slot.reset(new SymbolState());
+      std::memset(&slot->tick, 0, sizeof(slot->tick));
+      slot->has_tick = false;
+      slot->series.emplace_back(new Series(PERIOD_M1));
+     }
+   slot->spec = spec;
+   if(m_config.chart_symbol.empty())
+      m_config.chart_symbol = spec.name;
+   if(spec.name == m_config.chart_symbol)
+      m_chart = slot.get();
+   return *slot;
+  }
+
+SymbolState *Terminal::FindSymbol(const std::string &name)
+  {
+   if(name.empty() || (m_chart != nullptr && name == m_chart->spec.name))
+      return m_chart;
+   auto it = m_symbols.find(name);
+   return it == m_symbols.end() ? nullptr : it->second.get();
+  }
+
+Series *Terminal::GetSeries(const std::string &symbol, ENUM_TIMEFRAMES tf)
+  {
+   SymbolState *s = FindSymbol(symbol);
+   if(s == nullptr)
+      return nullptr;
+   tf = Resolve(tf);
+   for(auto &series : s->series)
+      if(series->Timeframe() == tf)
+         return series.get();
+   //--- first use of this timeframe: aggregate the M1 history
+   const Series &base = *s->series[0];
+   std::unique_ptr<Series> series(new Series(tf));
+   MqlRates bar;
+   for(int i = 0; i < base.Total(); i++)
+     {
+      base.Rates(i, bar);
+      series->Merge(bar);
+     }
+   s->series.push_back(std::move(series));
+   return s->series.back().get();
+  }
+
+void Terminal::LoadHistory(const std::string &symbol, const MqlRates *m1, size_t count)
+  {
+   SymbolState *s = FindSymbol(symbol);
+   if(s == nullptr || count == 0)
+      return;
+   for(auto &series : s->series)
+      series->Reserve((size_t)series->Total() + count / std::max<size_t>(1, (size_t)TimeframeSeconds(series->Timeframe()) / 60) + 1);
+   for(size_t i = 0; i < count; i++)
+      for(auto &series : s->series)
+         series->Merge(m1[i]);
+   if(m1[count - 1].time > m_now)
+      m_now = m1[count - 1].time;
+  }
+
+void Terminal::LoadHistory(const std::string &symbol, const BarStore &m1, size_t begin, size_t end)
+  {
+   SymbolState *s = FindSymbol(symbol);
+   if(s == nullptr || end <= begin)
+      return;
+   for(auto &series : s->series)
+      series->Append(m1.Time() + begin, m1.Open() + begin, m1.High() + begin, m1.Low() + begin,
+                     m1.Close() + begin, m1.TickVolume() + begin, m1.RealVolume() + begin,
+                     m1.Spread() + begin, end - begin);
+   if(m1.Time()[end - 1] > m_now)
+      m_now = m1.Time()[end - 1];
+  }
+
+void Terminal::ApplyTick(const std::string &symbol, const MqlTick &tick)
+  {
+   SymbolState *s = FindSymbol(symbol);
+   if(s != nullptr)
+      ApplyTick(*s, tick);
+  }
+
+void Terminal::ApplyTick(SymbolState &s, const MqlTick &tick)
+  {
+   m_stats.ticks++;
+   s.tick = tick;
+   s.has_tick = true;
+   if(tick.time > m_now)
+      m_now = tick.time;
+   ulong ms = tick.time_msc > 0 ? (ulong)tick.time_msc : (ulong)tick.time * 1000;
+   if(ms > clock_ms)
+      clock_ms = ms;
+   if(m_deals.empty())
+      BookDeposit();
+   int spread = (int)std::lround((tick.ask - tick.bid) / s.spec.point);
+   for(auto &series : s.series)
+      series->Tick(tick.time, tick.bid, (long)tick.volume, spread);
+   if(!m_positions.empty() || !m_orders.empty())
+      CheckTriggers(s);
+  }
+
+//+------------------------------------------------------------------+
+//| Indicators                                                       |
+//+------------------------------------------------------------------+
+int Terminal::AddIndicator(Indicator *indicator)
+  {
+   m_indicators.emplace_back(indicator);
+   m_stats.indicator_creates++;
+   return (int)m_indicators.size() - 1 + 10;
+  }
+
+Indicator *Terminal::GetIndicator(int handle)
+  {
+   int index = handle - 10;
+   if(index < 0 || index >= (int)m_indicators.size())
+      return nullptr;
+   return m_indicators[index].get();
+  }
+
+bool Terminal::ReleaseIndicator(int handle)
+  {
+   int index = handle - 10;
+   if(index < 0 || index >= (int)m_indicators.size() || !m_indicators[index])
+      return false;
+   m_indicators[index].reset();
+   m_stats.indicator_releases++;
+   return true;
+  }
+
+//+------------------------------------------------------------------+
+//| Position book                                                    |
+//+------------------------------------------------------------------+
+const Position *Terminal::PositionAt(int index) const
+  {
+   if(index < 0 || index >= (int)m_positions.size())
+      return nullptr;
+   return &m_positions[index];
+  }
+
+const Position *Terminal::PositionByTicket(ulong ticket) const
+  {
+   auto it = m_position_index.find(ticket);
+   return it == m_position_index.end() ? nullptr : &m_positions[it->second];
+  }
+
+const Order *Terminal::OrderAt(int index) const
+  {
+   if(index < 0 || index >= (int)m_orders.size())
+      return nullptr;
+   return &m_orders[index];
+  }
+
+const Order *Terminal::OrderByTicket(ulong ticket) const
+  {
+   auto it = m_order_index.find(ticket);
+   return it == m_order_index.end() ? nullptr : &m_orders[it->second];
+  }
+
+double Terminal::CurrentPrice(const Position &position) const
+  {
+   auto it = m_symbols.find(position.symbol);
+   if(it == m_symbols.end())
+      return 0.0;
+   return position.type == POSITION_TYPE_BUY ? it->second->tick.bid : it->second->tick.ask;
+  }
+
+double Terminal::PositionProfit(const Position &position) const
+  {
+   auto it = m_symbols.find(position.symbol);
+   if(it == m_symbols.end())
+      return 0.0;
+   const SymbolSpec &spec = it->second->spec;
+   double close = position.type == POSITION_TYPE_BUY ? it->second->tick.bid : it->second->tick.ask;
+   double diff = position.type == POSITION_TYPE_BUY ? close - position.price_open : position.price_open - close;
+   return diff / spec.tick_size * spec.tick_value * position.volume;
+  }
+
+double Terminal::FloatingProfit() const
+  {
+   double total = 0.0;
+   for(const Position &p : m_positions)
+      total += PositionProfit(p) + p.swap;
+   return total;
+  }
+
+double Terminal::Margin() const
+  {
+   double total = 0.0;
+   for(const Position &p : m_positions)
+     {
+      auto it = m_symbols.find(p.symbol);
+      if(it != m_symbols.end())
+         total += p.volume * it->second->spec.contract_size * p.price_open / (double)m_config.leverage;
+     }
+   return total;
+  }
+
+void Terminal::ReindexPositions()
+  {
+   m_position_index.clear();
+   for(size_t i = 0; i < m_positions.size(); i++)
+      m_position_index[m_positions[i].ticket] = i;
+  }
+
+void Terminal::ReindexOrders()
+  {
+   m_order_index.clear();
+   for(size_t i = 0; i < m_orders.size(); i++)
+      m_order_index[m_orders[i].ticket] = i;
+  }
+
+//+------------------------------------------------------------------+
+//| History                                                          |
+//+------------------------------------------------------------------+
+void Terminal::BookDeposit()
+  {
+   //--- as the strategy tester books it
+   Deal deposit = Deal();
+   deposit.type = DEAL_TYPE_BALANCE;
+   deposit.profit = m_config.balance;
+   deposit.time = m_now;
+   deposit.time_msc = (long)clock_ms;
+   deposit.comment = "Initial deposit";
+   AddDeal(deposit);
+   m_balance = m_config.balance;
+  }
+
+ulong Terminal::AddDeal(const Deal &deal)
+  {
+   Deal copy = deal;
+   copy.ticket = m_next_deal++;
+   m_deal_index[copy.ticket] = m_deals.size();
+   if(copy.position_id != 0)
+      m_deals_by_position[copy.position_id].push_back(m_deals.size());
+   m_deals.push_back(copy);
+   m_stats.deals++;
+   if(copy.type != DEAL_TYPE_BALANCE)
+      Emit(copy);
+   return copy.ticket;
+  }
+
+void Terminal::ArchiveOrder(const Order &order)
+  {
+   m_history_order_index[order.ticket] = m_history_orders.size();
+   m_history_orders.push_back(order);
+   m_history_orders.back().time_done = m_now;
+   Emit(TRADE_TRANSACTION_ORDER_DELETE, order);
+   Emit(TRADE_TRANSACTION_HISTORY_ADD, m_history_orders.back());
+  }
+
+void Terminal::SelectHistory(datetime from, datetime to)
+  {
+   m_stats.history_selects++;
+   m_selected_deals.clear();
+   m_selected_orders.clear();
+   //--- deals and archived orders are appended in time order
+   auto first = std::lower_bound(m_deals.begin(), m_deals.end(), from,
+                                 [](const Deal &d, datetime t) { return d.time < t; });
+   for(auto it = first; it != m_deals.end() && it->time <= to; ++it)
+      m_selected_deals.push_back((size_t)(it - m_deals.begin()));
+   auto ofirst = std::lower_bound(m_history_orders.begin(), m_history_orders.end(), from,
+                                  [](const Order &o, datetime t) { return o.time_done < t; });
+   for(auto it = ofirst; it != m_history_orders.end() && it->time_done <= to; ++it)
+      m_selected_orders.push_back((size_t)(it - m_history_orders.begin()));
+  }
+
+void Terminal::SelectHistoryByPosition(ulong position_id)
+  {
+   m_stats.history_selects++;
+   m_selected_deals.clear();
+   m_selected_orders.clear();
+   auto it = m_deals_by_position.find(position_id);
+   if(it != m_deals_by_position.end())
+      m_selected_deals = it->second;
+   for(size_t i = 0; i < m_history_orders.size(); i++)
+      if(m_history_orders[i].position_id == position_id)
+         m_selected_orders.push_back(i);
+  }
+
+const Deal *Terminal::SelectedDeal(int index) const
+  {
+   if(index < 0 || index >= (int)m_selected_deals.size())
+      return nullptr;
+   return &m_deals[m_selected_deals[index]];
+  }
+
+const Order *Terminal::SelectedOrder(int index) const
+  {
+   if(index < 0 || index >= (int)m_selected_orders.size())
+      return nullptr;
+   return &m_history_orders[m_selected_orders[index]];
+  }
+
+const Deal *Terminal::DealByTicket(ulong ticket) const
+  {
+   auto it = m_deal_index.find(ticket);
+   return it == m_deal_index.end() ? nullptr : &m_deals[it->second];
+  }
+
+const Order *Terminal::HistoryOrderByTicket(ulong ticket) const
+  {
+   auto it = m_history_order_index.find(ticket);
+   return it == m_history_order_index.end() ? nullptr : &m_history_orders[it->second];
+  }
+
+//+------------------------------------------------------------------+
+//| Trade server                                                     |
+//+------------------------------------------------------------------+
+bool Terminal::Reject(MqlTradeResult &result, uint retcode, const char *comment)
+  {
+   result.retcode = retcode;
+   result.comment = comment;
+   m_stats.order_send_failures++;
+   last_error = ERR_TRADE_SEND_FAILED;
+   return false;
+  }
+
+bool Terminal::ValidVolume(const SymbolSpec &spec, double volume) const
+  {
+   if(volume < spec.volume_min - VOLUME_EPSILON || volume > spec.volume_max + VOLUME_EPSILON)
+      return false;
+   double steps = volume / spec.volume_step;
+   return std::fabs(steps - std::round(steps)) < 1e-6;
+  }
+
+bool Terminal::ValidStops(const SymbolState &s, bool buy, double sl, double tp) const
+  {
+   double level = s.spec.stops_level * s.spec.point;
+   if(buy)
+     {
+      if(sl > 0 && sl >= s.tick.bid - level)
+         return false;
+      if(tp > 0 && tp <= s.tick.bid + level)
+         return false;
+      return true;
+     }
+   if(sl > 0 && sl <= s.tick.ask + level)
+      return false;
+   if(tp > 0 && tp >= s.tick.ask - level)
+      return false;
+   return true;
+  }
+
+bool Terminal::Send(const MqlTradeRequest &request, MqlTradeResult &result)
+  {
+   result = MqlTradeResult();
+   result.request_id = m_next_request++;
+   m_stats.order_sends++;
+   if(m_deals.empty())
+      BookDeposit();
+   SymbolState *s = FindSymbol(request.symbol);
+   if(s != nullptr)
+     {
+      result.bid = s->tick.bid;
+      result.ask = s->tick.ask;
+     }
+   bool done;
+   switch(request.action)
+     {
+      case TRADE_ACTION_DEAL:    done = MarketDeal(request, result); break;
+      case TRADE_ACTION_SLTP:    done = ModifyStops(request, result); break;
+      case TRADE_ACTION_PENDING: done = PlacePending(request, result); break;
+      case TRADE_ACTION_MODIFY:  done = ModifyPending(request, result); break;
+      case TRADE_ACTION_REMOVE:  done = RemovePending(request, result); break;
+      default:                   done = Reject(result, TRADE_RETCODE_INVALID, "Invalid request"); break;
+     }
+   //--- the request and its result close every OrderSend, as on a server
+   TradeEvent event = TradeEvent();
+   event.transaction.type = TRADE_TRANSACTION_REQUEST;
+   event.request = request;
+   event.result = result;
+   m_events.push_back(event);
+   return done;
+  }
+
+bool Terminal::SendAsync(const MqlTradeRequest &request, MqlTradeResult &result)
+  {
+   //--- executed at once; the expert learns the outcome from the
+   //--- TRADE_TRANSACTION_REQUEST event, as from a real server
+   MqlTradeResult outcome;
+   Send(request, outcome);
+   m_stats.async_sends++;
+   result = MqlTradeResult();
+   result.retcode = TRADE_RETCODE_PLACED;
+   result.request_id = outcome.request_id;
+   result.bid = outcome.bid;
+   result.ask = outcome.ask;
+   return true;
+  }
+
+void Terminal::TakeEvents(std::vector<TradeEvent> &events)
+  {
+   events.clear();
+   events.swap(m_events);
+  }
+
+void Terminal::Emit(ENUM_TRADE_TRANSACTION_TYPE type, const Order &order)
+  {
+   TradeEvent event = TradeEvent();
+   MqlTradeTransaction &t = event.transaction;
+   t.type = type;
+   t.order = order.ticket;
+   t.symbol = order.symbol;
+   t.order_type = order.type;
+   t.order_state = order.state;
+   t.time_type = order.type_time;
+   t.time_expiration = order.time_expiration;
+   t.price = order.price_open;
+   t.price_sl = order.sl;
+   t.price_tp = order.tp;
+   t.volume = order.volume_current;
+   t.position = order.position_id;
+   m_events.push_back(event);
+  }
+
+void Terminal::Emit(const Deal &deal)
+  {
+   TradeEvent event = TradeEvent();
+   MqlTradeTransaction &t = event.transaction;
+   t.type = TRADE_TRANSACTION_DEAL_ADD;
+   t.deal = deal.ticket;
+   t.order = deal.order;
+   t.symbol = deal.symbol;
+   t.deal_type = deal.type;
+   t.price = deal.price;
+   t.volume = deal.volume;
+   t.position = deal.position_id;
+   m_events.push_back(event);
+  }
+
+bool Terminal::MarketDeal(const MqlTradeRequest &request, MqlTradeResult &result)
+  {
+   SymbolState *s = FindSymbol(request.symbol);
+   if(s == nullptr)
+      return Reject(result, TRADE_RETCODE_INVALID, "Unknown symbol");
+   if(!s->has_tick)
+      return Reject(result, TRADE_RETCODE_MARKET_CLOSED, "Market closed");
+   if(request.type != ORDER_TYPE_BUY && request.type != ORDER_TYPE_SELL)
+      return Reject(result, TRADE_RETCODE_INVALID, "Invalid order type");
+   if(!ValidVolume(s->spec, request.volume))
+      return Reject(result, TRADE_RETCODE_INVALID_VOLUME, "Invalid volume");
+   bool filling_ok = false;
+   switch(request.type_filling)
+     {
+      case ORDER_FILLING_FOK:    filling_ok = (s->spec.filling_mode & SYMBOL_FILLING_FOK) != 0; break;
+      case ORDER_FILLING_IOC:    filling_ok = (s->spec.filling_mode & SYMBOL_FILLING_IOC) != 0; break;
+      case ORDER_FILLING_RETURN: filling_ok = s->spec.execution != SYMBOL_TRADE_EXECUTION_MARKET; break;
+      default:                   filling_ok = false; break;
+     }
+   if(!filling_ok)
+      return Reject(result, TRADE_RETCODE_INVALID_FILL, "Unsupported filling mode");
+
+   bool   buy = request.type == ORDER_TYPE_BUY;
+   double price = buy ? s->tick.ask : s->tick.bid;
+   Order  order = Order();
+   order.ticket = m_next_order++;
+   order.symbol = s->spec.name;
+   order.type = request.type;
+   order.state = ORDER_STATE_FILLED;
+   order.filling = request.type_filling;
+   order.type_time = ORDER_TIME_GTC;
+   order.magic = (long)request.magic;
+   order.volume_initial = request.volume;
+   order.price_open = price;
+   order.sl = request.sl;
+   order.tp = request.tp;
+   order.time_setup = m_now;
+   order.comment = request.comment;
+
+   ulong deal = 0;
+   if(request.position != 0)
+     {
+      auto it = m_position_index.find(request.position);
+      if(it == m_position_index.end())
+         return Reject(result, TRADE_RETCODE_POSITION_CLOSED, "Position not found");
+      Position &p = m_positions[it->second];
+      bool closes = (p.type == POSITION_TYPE_BUY) != buy;
+      if(!closes || p.symbol != s->spec.name)
+         return Reject(result, TRADE_RETCODE_INVALID, "Invalid close request");
+      if(request.volume > p.volume + VOLUME_EPSILON)
+         return Reject(result, TRADE_RETCODE_INVALID_VOLUME, "Volume exceeds position");
+      order.position_id = p.identifier;
+      Emit(TRADE_TRANSACTION_ORDER_ADD, order);
+      deal = ClosePosition(it->second, request.volume, price, order.ticket, DEAL_REASON_EXPERT, request.comment);
+     }
+   else
+     {
+      if(!ValidStops(*s, buy, request.sl, request.tp))
+         return Reject(result, TRADE_RETCODE_INVALID_STOPS, "Invalid stops");
+      double margin = request.volume * s->spec.contract_size * price / (double)m_config.leverage;
+      if(margin > Equity() - Margin())
+         return Reject(result, TRADE_RETCODE_NO_MONEY, "No money");
+      Emit(TRADE_TRANSACTION_ORDER_ADD, order);
+      order.position_id = OpenPosition(*s, request.type, request.volume, price, request.sl, request.tp,
+                                       (long)request.magic, request.comment, order.ticket, DEAL_REASON_EXPERT, deal);
+     }
+   order.volume_current = 0.0;
+   ArchiveOrder(order);
+
+   result.retcode = TRADE_RETCODE_DONE;
+   result.order = order.ticket;
+   result.deal = deal;
+   result.volume = request.volume;
+   result.price = price;
+   result.comment = "Request executed";
+   return true;
+  }
+
+bool Terminal::ModifyStops(const MqlTradeRequest &request, MqlTradeResult &result)
+  {
+   auto it = m_position_index.find(request.position);
+   if(it == m_position_index.end())
+      return Reject(result, TRADE_RETCODE_POSITION_CLOSED, "Position not found");
+   Position &p = m_positions[it->second];
+   SymbolState *s = FindSymbol(p.symbol);
+   double sl = NormalizeDouble(request.sl, s->spec.digits);
+   double tp = NormalizeDouble(request.tp, s->spec.digits);
+   if(sl == NormalizeDouble(p.sl, s->spec.digits) && tp == NormalizeDouble(p.tp, s->spec.digits))
+      return Reject(result, TRADE_RETCODE_NO_CHANGES, "No changes");
+   if(!ValidStops(*s, p.type == POSITION_TYPE_BUY, sl, tp))
+      return Reject(result, TRADE_RETCODE_INVALID_STOPS, "Invalid stops");
+   p.sl = sl;
+   p.tp = tp;
+   p.time_update = m_now;
+   m_stats.sltp_modifications++;
+   TradeEvent event = TradeEvent();
+   event.transaction.type = TRADE_TRANSACTION_POSITION;
+   event.transaction.symbol = p.symbol;
+   event.transaction.position = p.ticket;
+   event.transaction.price = p.price_open;
+   event.transaction.price_sl = p.sl;
+   event.transaction.price_tp = p.tp;
+   event.transaction.volume = p.volume;
+   m_events.push_back(event);
+   result.retcode = TRADE_RETCODE_DONE;
+   result.comment = "Request executed";
+   return true;
+  }
+
+bool Terminal::PlacePending(const MqlTradeRequest &request, MqlTradeResult &result)
+  {
+   SymbolState *s = FindSymbol(request.symbol);
+   if(s == nullptr)
+      return Reject(result, TRADE_RETCODE_INVALID, "Unknown symbol");
+   if(!s->has_tick)
+      return Reject(result, TRADE_RETCODE_MARKET_CLOSED, "Market closed");
+   if(!ValidVolume(s->spec, request.volume))
+      return Reject(result, TRADE_RETCODE_INVALID_VOLUME, "Invalid volume");
+   double level = s->spec.stops_level * s->spec.point;
+   bool   valid = false;
+   switch(request.type)
+     {
+      case ORDER_TYPE_BUY_LIMIT:  valid = request.price < s->tick.ask - level; break;
+      case ORDER_TYPE_SELL_LIMIT: valid = request.price > s->tick.bid + level; break;
+      case ORDER_TYPE_BUY_STOP:   valid = request.price > s->tick.ask + level; break;
+      case ORDER_TYPE_SELL_STOP:  valid = request.price < s->tick.bid - level; break;
+      default:
+         return Reject(result, TRADE_RETCODE_INVALID, "Invalid order type");
+     }
+   if(!valid)
+      return Reject(result, TRADE_RETCODE_INVALID_PRICE, "Invalid price");
+   if(request.type_time == ORDER_TIME_SPECIFIED && request.expiration <= m_now)
+      return Reject(result, TRADE_RETCODE_INVALID_EXPIRATION, "Invalid expiration");
+
+   Order order = Order();
+   order.ticket = m_next_order++;
+   order.symbol = s->spec.name;
+   order.type = request.type;
+   order.state = ORDER_STATE_PLACED;
+   order.filling = request.type_filling;
+   order.type_time = request.type_time;
+   order.magic = (long)request.magic;
+   order.volume_initial = order.volume_current = request.volume;
+   order.price_open = NormalizeDouble(request.price, s->spec.digits);
+   order.sl = request.sl;
+   order.tp = request.tp;
+   order.time_setup = m_now;
+   order.time_expiration = request.expiration;
+   order.comment = request.comment;
+   m_order_index[order.ticket] = m_orders.size();
+   m_orders.push_back(order);
+   Emit(TRADE_TRANSACTION_ORDER_ADD, order);
+
+   result.retcode = TRADE_RETCODE_DONE;
+   result.order = order.ticket;
+   result.volume = request.volume;
+   result.price = order.price_open;
+   result.comment = "Request executed";
+   return true;
+  }
+
+bool Terminal::ModifyPending(const MqlTradeRequest &request, MqlTradeResult &result)
+  {
+   auto it = m_order_index.find(request.order);
+   if(it == m_order_index.end())
+      return Reject(result, TRADE_RETCODE_INVALID_ORDER, "Order not found");
+   Order &order = m_orders[it->second];
+   order.price_open = request.price;
+   order.sl = request.sl;
+   order.tp = request.tp;
+   order.type_time = request.type_time;
+   order.time_expiration = request.expiration;
+   Emit(TRADE_TRANSACTION_ORDER_UPDATE, order);
+   result.retcode = TRADE_RETCODE_DONE;
+   result.order = order.ticket;
+   result.comment = "Request executed";
+   return true;
+  }
+
+bool Terminal::RemovePending(const MqlTradeRequest &request, MqlTradeResult &result)
+  {
+   auto it = m_order_index.find(request.order);
+   if(it == m_order_index.end())
+      return Reject(result, TRADE_RETCODE_INVALID_ORDER, "Order not found");
+   Order order = m_orders[it->second];
+   order.state = ORDER_STATE_CANCELED;
+   ArchiveOrder(order);
+   m_orders.erase(m_orders.begin() + (long)it->second);
+   ReindexOrders();
+   result.retcode = TRADE_RETCODE_DONE;
+   result.order = order.ticket;
+   result.comment = "Request executed";
+   return true;
+  }
+
+ulong Terminal::OpenPosition(SymbolState &s, ENUM_ORDER_TYPE type, double volume, double price,
+                             double sl, double tp, long magic, const std::string &comment,
+                             ulong order_ticket, ENUM_DEAL_REASON reason, ulong &deal_ticket)
+  {
+   Position p = Position();
+   p.ticket = p.identifier = order_ticket;
+   p.symbol = s.spec.name;
+   p.type = IsBuy(type) ? POSITION_TYPE_BUY : POSITION_TYPE_SELL;
+   p.magic = magic;
+   p.volume = volume;
+   p.price_open = price;
+   p.sl = NormalizeDouble(sl, s.spec.digits);
+   p.tp = NormalizeDouble(tp, s.spec.digits);
+   p.time = p.time_update = m_now;
+   p.time_msc = (long)clock_ms;
+   p.comment = comment;
+   m_position_index[p.ticket] = m_positions.size();
+   m_positions.push_back(p);
+
+   Deal deal = Deal();
+   deal.order = order_ticket;
+   deal.position_id = p.identifier;
+   deal.symbol = p.symbol;
+   deal.type = p.type == POSITION_TYPE_BUY ? DEAL_TYPE_BUY : DEAL_TYPE_SELL;
+   deal.entry = DEAL_ENTRY_IN;
+   deal.reason = reason;
+   deal.magic = magic;
+   deal.volume = volume;
+   deal.price = price;
+   deal.commission = -s.spec.commission_per_lot * volume;
+   deal.time = m_now;
+   deal.time_msc = (long)clock_ms;
+   deal.comment = comment;
+   deal_ticket = AddDeal(deal);
+   m_balance += deal.commission;
+   return p.identifier;
+  }
+
+ulong Terminal::ClosePosition(size_t index, double volume, double price, ulong order_ticket,
+                              ENUM_DEAL_REASON reason, const std::string &comment)
+  {
+   Position &p = m_positions[index];
+   const SymbolSpec &spec = FindSymbol(p.symbol)->spec;
+   double diff = p.type == POSITION_TYPE_BUY ? price - p.price_open : p.price_open - price;
+
+   Deal deal = Deal();
+   deal.order = order_ticket;
+   deal.position_id = p.identifier;
+   deal.symbol = p.symbol;
+   deal.type = p.type == POSITION_TYPE_BUY ? DEAL_TYPE_SELL : DEAL_TYPE_BUY;
+   deal.entry = DEAL_ENTRY_OUT;
+   deal.reason = reason;
+   deal.magic = p.magic;
+   deal.volume = volume;
+   deal.price = price;
+   deal.commission = -spec.commission_per_lot * volume;
+   deal.profit = diff / spec.tick_size * spec.tick_value * volume;
+   deal.time = m_now;
+   deal.time_msc = (long)clock_ms;
+   deal.comment = comment;
+   ulong ticket = AddDeal(deal);
+   m_balance += deal.profit + deal.commission;
+
+   p.volume -= volume;
+   if(p.volume < VOLUME_EPSILON)
+     {
+      m_positions.erase(m_positions.begin() + (long)index);
+      ReindexPositions();
+     }
+   else
+      p.volume = NormalizeDouble(p.volume, 8);
+   return ticket;
+  }
+
+void Terminal::CheckTriggers(SymbolState &s)
+  {
+   const double bid = s.tick.bid;
+   const double ask = s.tick.ask;
+   for(size_t i = m_positions.size(); i-- > 0;)
+     {
+      Position &p = m_positions[i];
+      if(p.symbol != s.spec.name)
+         continue;
+      ENUM_DEAL_REASON reason;
+      double price;
+      if(p.type == POSITION_TYPE_BUY)
+        {
+         price = bid;
+         if(p.sl > 0 && bid <= p.sl)
+            reason = DEAL_REASON_SL;
+         else if(p.tp > 0 && bid >= p.tp)
+            reason = DEAL_REASON_TP;
+         else
+            continue;
+        }
+      else
+        {
+         price = ask;
+         if(p.sl > 0 && ask >= p.sl)
+            reason = DEAL_REASON_SL;
+         else if(p.tp > 0 && ask <= p.tp)
+            reason = DEAL_REASON_TP;
+         else
+            continue;
+        }
+      char comment[64];
+      std::snprintf(comment, sizeof(comment), "[%s %.*f]", reason == DEAL_REASON_SL ? "sl" : "tp",
+                    s.spec.digits, reason == DEAL_REASON_SL ? p.sl : p.tp);
+      Order order = Order();
+      order.ticket = m_next_order++;
+      order.symbol = p.symbol;
+      order.type = p.type == POSITION_TYPE_BUY ? ORDER_TYPE_SELL : ORDER_TYPE_BUY;
+      order.state = ORDER_STATE_FILLED;
+      order.magic = p.magic;
+      order.position_id = p.identifier;
+      order.volume_initial = p.volume;
+      order.price_open = price;
+      order.time_setup = m_now;
+      order.comment = comment;
+      Emit(TRADE_TRANSACTION_ORDER_ADD, order);
+      ClosePosition(i, p.volume, price, order.ticket, reason, comment);
+      ArchiveOrder(order);
+      m_stats.stop_outs++;
+     }
+
+   bool removed = false;
+   for(size_t i = 0; i < m_orders.size(); i++)
+     {
+      Order &order = m_orders[i];
+      if(order.symbol != s.spec.name)
+         continue;
+      bool expired = false;
+      if((order.type_time == ORDER_TIME_SPECIFIED || order.type_time == ORDER_TIME_SPECIFIED_DAY) &&
+         order.time_expiration > 0 && m_now >= order.time_expiration)
+         expired = true;
+      else if(order.type_time == ORDER_TIME_DAY && m_now / 86400 != order.time_setup / 86400)
+         expired = true;
+      if(expired)
+        {
+         order.state = ORDER_STATE_EXPIRED;
+         ArchiveOrder(order);
+         order.ticket = 0;
+         removed = true;
+         continue;
+        }
+      bool fire = false;
+      switch(order.type)
+        {
+         case ORDER_TYPE_BUY_LIMIT:  fire = ask <= order.price_open; break;
+         case ORDER_TYPE_SELL_LIMIT: fire = bid >= order.price_open; break;
+         case ORDER_TYPE_BUY_STOP:   fire = ask >= order.price_open; break;
+         case ORDER_TYPE_SELL_STOP:  fire = bid <= order.price_open; break;
+         default: break;
+        }
+      if(!fire)
+         continue;
+      bool   limit = order.type == ORDER_TYPE_BUY_LIMIT || order.type == ORDER_TYPE_SELL_LIMIT;
+      double price = limit ? order.price_open : (IsBuy(order.type) ? ask : bid);
+      ulong  deal = 0;
+      order.position_id = OpenPosition(s, order.type, order.volume_current, price, order.sl, order.tp,
+                                       order.magic, order.comment, order.ticket, DEAL_REASON_EXPERT, deal);
+      order.state = ORDER_STATE_FILLED;
+      order.volume_current = 0.0;
+      ArchiveOrder(order);
+      order.ticket = 0;
+      removed = true;
+      m_stats.stop_outs++;
+     }
+   if(removed)
+     {
+      m_orders.erase(std::remove_if(m_orders.begin(), m_orders.end(),
+                                    [](const Order &o) { return o.ticket == 0; }), m_orders.end());
+      ReindexOrders();
+     }
+  }
+
+//+------------------------------------------------------------------+
+//| Files                                                            |
+//+------------------------------------------------------------------+
+namespace
+{
+const size_t FILES_MAX = 64;                // open handles, as the terminal
+}
+
+//--- absolute path of a sandbox file, "" for names that leave the sandbox;
+//--- the directory (a scratch one when none is configured) is created on
+//--- first use
+std::string Terminal::FilePath(const std::string &name)
+  {
+   std::string relative = name;
+   std::replace(relative.begin(), relative.end(), '\\', '/');
+   std::filesystem::path path(relative);
+   if(relative.empty() || path.is_absolute())
+      return "";
+   for(const std::filesystem::path &part : path)
+      if(part == "..")
+         return "";
+   std::error_code ec;
+   if(m_files_dir.empty())
+     {
+      std::string pattern = (std::filesystem::temp_directory_path(ec) / "ea_host.XXXXXX").string();
+      if(mkdtemp(&pattern[0]) == nullptr)
+         return "";
+      m_files_dir = pattern;
+      m_files_scratch = true;
+     }
+   std::filesystem::path full = std::filesystem::path(m_files_dir) / path;
+   std::filesystem::create_directories(full.parent_path(), ec);
+   return full.string();
+  }
+
+int Terminal::OpenFile(const std::string &name, int flags)
+  {
+   std::string path = FilePath(name);
+   if(path.empty())
+     {
+      last_error = ERR_WRONG_FILENAME;
+      return INVALID_HANDLE;
+     }
+   bool read = (flags & FILE_READ) != 0;
+   bool write = (flags & FILE_WRITE) != 0;
+   if(!read && !write)
+     {
+      last_error = ERR_INVALID_PARAMETER;
+      return INVALID_HANDLE;
+     }
+   //--- FILE_WRITE alone truncates, FILE_READ|FILE_WRITE keeps the content
+   //--- and creates a missing file
+   const char *mode = !write ? "rb" : !read ? "wb" : std::filesystem::exists(path) ? "r+b" : "w+b";
+   size_t slot = 0;
+   while(slot < m_files.size() && m_files[slot].stream != nullptr)
+      slot++;
+   if(slot >= FILES_MAX)
+     {
+      last_error = ERR_TOO_MANY_FILES;
+      return INVALID_HANDLE;
+     }
+   std::FILE *stream = std::fopen(path.c_str(), mode);
+   if(stream == nullptr)
+     {
+      last_error = read && !write ? ERR_FILE_NOT_EXIST : ERR_CANNOT_OPEN_FILE;
+      return INVALID_HANDLE;
+     }
+   if(slot == m_files.size())
+      m_files.push_back(FileHandle());
+   m_files[slot].stream = stream;
+   m_files[slot].flags = flags;
+   return (int)slot + 1;
+  }
+
+FileHandle *Terminal::GetFile(int handle)
+  {
+   if(handle < 1 || handle > (int)m_files.size() || m_files[handle - 1].stream == nullptr)
+     {
+      last_error = ERR_INVALID_FILEHANDLE;
+      return nullptr;
+     }
+   return &m_files[handle - 1];
+  }
+
+bool Terminal::CloseFile(int handle)
+  {
+   FileHandle *file = GetFile(handle);
+   if(file == nullptr)
+      return false;
+   std::fclose(file->stream);
+   file->stream = nullptr;
+   return true;
+  }
+
+//+------------------------------------------------------------------+
+//| Output                                                           |
+//+------------------------------------------------------------------+
+void Terminal::Log(const std::string &line)
+  {
+   if(!m_config.log || m_config.log_stream == nullptr)
+      return;
+   m_stats.prints++;
+   std::fprintf(m_config.log_stream, "%s   %s\n", TimeToString(m_now, TIME_DATE | TIME_SECONDS).c_str(), line.c_str());
+  }
+}
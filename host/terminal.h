@@ -0,0 +1,403 @@
+//+------------------------------------------------------------------+
+//|                                                       terminal.h |
+//|              In-process simulated terminal behind the MQL5 API    |
+//+------------------------------------------------------------------+
+// One Terminal is one trading account on one simulated server: symbol
+// specifications, bar series per timeframe built from the ticks it is
+// fed, indicator instances, a hedging position book, pending orders,
+// deal/order history and chart objects. The MQL5 free functions in
+// api.cpp act on the terminal bound to the calling thread.
+#ifndef EA_HOST_TERMINAL_H
+#define EA_HOST_TERMINAL_H
+
+#include "mql5.h"
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+namespace mql
+{
+class BarStore;
+class Indicator;
+
+//+------------------------------------------------------------------+
+//| Symbol contract specification                                   |
+//+------------------------------------------------------------------+
+struct SymbolSpec
+  {
+   std::string       name;
+   std::string       description;
+   int               digits = 5;
+   double            point = 0.00001;
+   double            tick_size = 0.00001;
+   double            tick_value = 1.0;          // deposit currency per tick per lot
+   double            contract_size = 100000.0;
+   double            volume_min = 0.01;
+   double            volume_max = 100.0;
+   double            volume_step = 0.01;
+   int               stops_level = 0;
+   int               freeze_level = 0;
+   int               filling_mode = SYMBOL_FILLING_FOK | SYMBOL_FILLING_IOC;
+   ENUM_SYMBOL_TRADE_EXECUTION execution = SYMBOL_TRADE_EXECUTION_MARKET;
+   double            commission_per_lot = 0.0;  // charged per side
+  };
+
+//--- presets used by the driver
+SymbolSpec PresetSymbol(const std::string &name);
+
+//+------------------------------------------------------------------+
+//| Bar series of one symbol on one timeframe (columnar)             |
+//+------------------------------------------------------------------+
+class Series
+  {
+public:
+   explicit          Series(ENUM_TIMEFRAMES tf);
+
+   ENUM_TIMEFRAMES   Timeframe() const { return m_tf; }
+   int               Total() const     { return (int)m_time.size(); }
+   //--- bumped on every change, used by indicators to skip recalculation
+   ulong             Version() const   { return m_version; }
+
+   const datetime   *Time() const       { return m_time.data(); }
+   const double     *Open() const       { return m_open.data(); }
+   const double     *High() const       { return m_high.data(); }
+   const double     *Low() const        { return m_low.data(); }
+   const double     *Close() const      { return m_close.data(); }
+   const long       *TickVolume() const { return m_tick_volume.data(); }
+   const long       *RealVolume() const { return m_real_volume.data(); }
+   const int        *Spread() const     { return m_spread.data(); }
+
+   void              Reserve(size_t bars);
+   //--- append a completed bar (history) or merge a finer bar into it
+   void              Merge(const MqlRates &bar);
+   //--- bulk append of M1 history held in columns (a mapped store slice)
+   void              Append(const datetime *time, const double *open, const double *high, const double *low,
+                            const double *close, const long *tick_volume, const long *real_volume,
+                            const int *spread, size_t count);
+   //--- apply one tick to the forming bar, opening a new bar when due
+   void              Tick(datetime time, double price, long volume, int spread);
+   bool              Rates(int index, MqlRates &bar) const;
+
+private:
+   void              OpenBar(datetime start, double price, long tick_volume, long real_volume, int spread);
+
+   ENUM_TIMEFRAMES   m_tf;
+   ulong             m_version;
+   datetime          m_bar_end;
+   std::vector<datetime> m_time;
+   std::vector<double> m_open;
+   std::vector<double> m_high;
+   std::vector<double> m_low;
+   std::vector<double> m_close;
+   std::vector<long> m_tick_volume;
+   std::vector<long> m_real_volume;
+   std::vector<int>  m_spread;
+  };
+
+//--- calendar helpers (proleptic Gregorian, UTC)
+long     DaysFromCivil(int year, int month, int day);
+void     CivilFromDays(long days, int &year, int &month, int &day);
+
+datetime BarStart(datetime time, ENUM_TIMEFRAMES tf);
+datetime BarEnd(datetime start, ENUM_TIMEFRAMES tf);
+int      TimeframeSeconds(ENUM_TIMEFRAMES tf);
+bool     ParseTimeframe(const std::string &text, ENUM_TIMEFRAMES &tf);
+
+//+------------------------------------------------------------------+
+//| Trading entities                                                 |
+//+------------------------------------------------------------------+
+struct Position
+  {
+   ulong             ticket;
+   ulong             identifier;
+   std::string       symbol;
+   ENUM_POSITION_TYPE type;
+   long              magic;
+   double            volume;
+   double            price_open;
+   double            sl;
+   double            tp;
+   double            swap;
+   datetime          time;
+   long              time_msc;
+   datetime          time_update;
+   std::string       comment;
+  };
+
+struct Order
+  {
+   ulong             ticket;
+   std::string       symbol;
+   ENUM_ORDER_TYPE   type;
+   ENUM_ORDER_STATE  state;
+   ENUM_ORDER_TYPE_FILLING filling;
+   ENUM_ORDER_TYPE_TIME type_time;
+   long              magic;
+   ulong             position_id;
+   double            volume_initial;
+   double            volume_current;
+   double            price_open;
+   double            sl;
+   double            tp;
+   datetime          time_setup;
+   datetime          time_expiration;
+   datetime          time_done;
+   std::string       comment;
+  };
+
+struct Deal
+  {
+   ulong             ticket;
+   ulong             order;
+   ulong             position_id;
+   std::string       symbol;
+   ENUM_DEAL_TYPE    type;
+   ENUM_DEAL_ENTRY   entry;
+   ENUM_DEAL_REASON  reason;
+   long              magic;
+   double            volume;
+   double            price;
+   double            commission;
+   double            swap;
+   double            profit;
+   datetime          time;
+   long              time_msc;
+   std::string       comment;
+  };
+
+//--- OnTradeTransaction arguments, queued until the expert's handler returns
+struct TradeEvent
+  {
+   MqlTradeTransaction transaction;
+   MqlTradeRequest   request;
+   MqlTradeResult    result;
+  };
+
+//--- a file opened by FileOpen; handle = index in the table + 1
+struct FileHandle
+  {
+   std::FILE        *stream;
+   int               flags;               // FILE_* of the FileOpen call
+  };
+
+struct ChartObject
+  {
+   ENUM_OBJECT       type;
+   std::map<int, long> integers;
+   std::map<int, double> doubles;
+   std::map<int, std::string> strings;
+  };
+
+//+------------------------------------------------------------------+
+//| Per-symbol market state                                          |
+//+------------------------------------------------------------------+
+struct SymbolState
+  {
+   SymbolSpec        spec;
+   MqlTick           tick;
+   bool              has_tick;
+   //--- slot 0 is always the M1 base series, others are built on demand
+   std::vector<std::unique_ptr<Series>> series;
+  };
+
+//+------------------------------------------------------------------+
+//| API usage counters, reported by the driver                       |
+//+------------------------------------------------------------------+
+struct HostStats
+  {
+   ulong             ticks;
+   ulong             series_calls;        // Bars/iTime/iClose/Copy* ...
+   ulong             copy_buffer_calls;
+   ulong             indicator_creates;
+   ulong             indicator_releases;
+   ulong             indicator_bars_computed;
+   ulong             symbol_info_calls;
+   ulong             account_info_calls;
+   ulong             position_calls;
+   ulong             history_selects;
+   ulong             history_reads;
+   ulong             order_sends;
+   ulong             order_send_failures;
+   ulong             async_sends;         // of order_sends, by OrderSendAsync
+   ulong             deals;
+   ulong             sltp_modifications;
+   ulong             stop_outs;           // SL/TP/pending triggered by the server
+   ulong             transactions;        // OnTradeTransaction events delivered
+   ulong             file_calls;
+   ulong             file_flushes;        // FileFlush, each one an fsync
+   ulong             object_calls;
+   ulong             prints;
+   ulong             sleep_ms;
+  };
+
+struct TerminalConfig
+  {
+   double            balance = 10000.0;
+   long              leverage = 100;
+   long              login = 1000001;
+   std::string       currency = "USD";
+   std::string       company = "EA-Trade Native Host";
+   std::string       server = "Simulator";
+   std::string       name = "Backtest";
+   std::string       chart_symbol;
+   ENUM_TIMEFRAMES   chart_period = PERIOD_H1;
+   bool              visual = false;          // MQL_VISUAL_MODE, experts keep their chart panels
+   bool              log = true;
+   FILE             *log_stream = stdout;
+   //--- sandbox of the File* functions; empty = a scratch directory
+   //--- removed with the Terminal, so runs do not see each other's files
+   std::string       files_dir;
+  };
+
+//+------------------------------------------------------------------+
+//| Terminal                                                         |
+//+------------------------------------------------------------------+
+class Terminal
+  {
+public:
+   explicit          Terminal(const TerminalConfig &config);
+                    ~Terminal();
+
+   const TerminalConfig &Config() const { return m_config; }
+   HostStats        &Stats()             { return m_stats; }
+
+   //--- market
+   SymbolState      &AddSymbol(const SymbolSpec &spec);
+   SymbolState      *FindSymbol(const std::string &name);
+   //--- "" and NULL mean the chart symbol, PERIOD_CURRENT the chart period
+   Series           *GetSeries(const std::string &symbol, ENUM_TIMEFRAMES tf);
+   void              LoadHistory(const std::string &symbol, const MqlRates *m1, size_t count);
+   //--- bars [begin, end) of a mapped M1 store
+   void              LoadHistory(const std::string &symbol, const BarStore &m1, size_t begin, size_t end);
+   void              ApplyTick(const std::string &symbol, const MqlTick &tick);
+   void              ApplyTick(SymbolState &symbol, const MqlTick &tick);
+   datetime          Now() const { return m_now; }
+   const std::string &ChartSymbol() const { return m_config.chart_symbol; }
+   ENUM_TIMEFRAMES   ChartPeriod() const { return m_config.chart_period; }
+   ENUM_TIMEFRAMES   Resolve(ENUM_TIMEFRAMES tf) const { return tf == PERIOD_CURRENT ? m_config.chart_period : tf; }
+
+   //--- indicators
+   int               AddIndicator(Indicator *indicator);
+   Indicator        *GetIndicator(int handle);
+   bool              ReleaseIndicator(int handle);
+
+   //--- trading
+   bool              Send(const MqlTradeRequest &request, MqlTradeResult &result);
+   bool              SendAsync(const MqlTradeRequest &request, MqlTradeResult &result);
+   int               PositionCount() const { return (int)m_positions.size(); }
+   const Position   *PositionAt(int index) const;
+   const Position   *PositionByTicket(ulong ticket) const;
+   int               OrderCount() const { return (int)m_orders.size(); }
+   const Order      *OrderAt(int index) const;
+   const Order      *OrderByTicket(ulong ticket) const;
+   double            PositionProfit(const Position &position) const;
+   double            CurrentPrice(const Position &position) const;
+   //--- trade transactions raised since the last call, oldest first
+   bool              HasEvents() const { return !m_events.empty(); }
+   void              TakeEvents(std::vector<TradeEvent> &events);
+
+   //--- history
+   void              SelectHistory(datetime from, datetime to);
+   void              SelectHistoryByPosition(ulong position_id);
+   int               SelectedDeals() const  { return (int)m_selected_deals.size(); }
+   int               SelectedOrders() const { return (int)m_selected_orders.size(); }
+   const Deal       *SelectedDeal(int index) const;
+   const Order      *SelectedOrder(int index) const;
+   const Deal       *DealByTicket(ulong ticket) const;
+   const Order      *HistoryOrderByTicket(ulong ticket) const;
+   const std::vector<Deal> &Deals() const { return m_deals; }
+
+   //--- account
+   double            Balance() const { return m_balance; }
+   double            FloatingProfit() const;
+   double            Equity() const  { return m_balance + FloatingProfit(); }
+   double            Margin() const;
+
+   //--- global variables of the terminal (GlobalVariable*), kept for the
+   //--- life of the Terminal so experts restarted on it find them again
+   std::unordered_map<std::string, double> &GlobalVariables() { return m_global_variables; }
+
+   //--- files (File*): names are relative to the sandbox directory, which
+   //--- also outlives experts restarted on this Terminal
+   std::string       FilePath(const std::string &name);
+   int               OpenFile(const std::string &name, int flags);
+   FileHandle       *GetFile(int handle);
+   bool              CloseFile(int handle);
+
+   //--- chart objects and output
+   std::unordered_map<std::string, ChartObject> &Objects() { return m_objects; }
+   void              SetComment(const std::string &text) { m_comment = text; }
+   const std::string &CommentText() const { return m_comment; }
+   void              Log(const std::string &line);
+
+   //--- runtime state used by the free functions
+   int               last_error;
+   ulong             selected_position;
+   ulong             selected_order;
+   ulong             clock_ms;            // simulated milliseconds, advanced by ticks and Sleep
+   bool              stop_requested;
+   int               return_error;        // exit status set by SetReturnError(), 0 = none
+
+private:
+   bool              Reject(MqlTradeResult &result, uint retcode, const char *comment);
+   bool              MarketDeal(const MqlTradeRequest &request, MqlTradeResult &result);
+   bool              ModifyStops(const MqlTradeRequest &request, MqlTradeResult &result);
+   bool              PlacePending(const MqlTradeRequest &request, MqlTradeResult &result);
+   bool              ModifyPending(const MqlTradeRequest &request, MqlTradeResult &result);
+   bool              RemovePending(const MqlTradeRequest &request, MqlTradeResult &result);
+   bool              ValidVolume(const SymbolSpec &spec, double volume) const;
+   bool              ValidStops(const SymbolState &s, bool buy, double sl, double tp) const;
+   ulong             OpenPosition(SymbolState &s, ENUM_ORDER_TYPE type, double volume, double price,
+                                  double sl, double tp, long magic, const std::string &comment,
+                                  ulong order_ticket, ENUM_DEAL_REASON reason, ulong &deal_ticket);
+   ulong             ClosePosition(size_t index, double volume, double price, ulong order_ticket,
+                                   ENUM_DEAL_REASON reason, const std::string &comment);
+   ulong             AddDeal(const Deal &deal);
+   //--- initial deposit, booked before the first tick or trade
+   void              BookDeposit();
+   void              ArchiveOrder(const Order &order);
+   void              Emit(ENUM_TRADE_TRANSACTION_TYPE type, const Order &order);
+   void              Emit(const Deal &deal);
+   void              CheckTriggers(SymbolState &s);
+   void              ReindexPositions();
+   void              ReindexOrders();
+
+   TerminalConfig    m_config;
+   HostStats         m_stats;
+   datetime          m_now;
+   double            m_balance;
+   ulong             m_next_order;
+   ulong             m_next_deal;
+   uint              m_next_request;
+   std::unordered_map<std::string, std::unique_ptr<SymbolState>> m_symbols;
+   SymbolState      *m_chart;
+   std::vector<std::unique_ptr<Indicator>> m_indicators;
+   std::vector<Position> m_positions;
+   std::unordered_map<ulong, size_t> m_position_index;
+   std::vector<Order> m_orders;
+   std::unordered_map<ulong, size_t> m_order_index;
+   std::vector<Deal> m_deals;
+   std::unordered_map<ulong, size_t> m_deal_index;
+   std::unordered_map<ulong, std::vector<size_t>> m_deals_by_position;
+   std::vector<TradeEvent> m_events;
+   std::vector<Order> m_history_orders;
+   std::unordered_map<ulong, size_t> m_history_order_index;
+   std::vector<size_t> m_selected_deals;
+   std::vector<size_t> m_selected_orders;
+   std::unordered_map<std::string, double> m_global_variables;
+   std::string       m_files_dir;
+   bool              m_files_scratch;       // m_files_dir is ours to remove
+   std::vector<FileHandle> m_files;
+   std::unordered_map<std::string, ChartObject> m_objects;
+   std::string       m_comment;
+  };
+
+//+------------------------------------------------------------------+
+//| Thread binding                                                   |
+//+------------------------------------------------------------------+
+Terminal &Current();
+void      Bind(Terminal *terminal);
+}
+
+#endif // EA_HOST_TERMINAL_H
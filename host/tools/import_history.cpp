@@ -0,0 +1,641 @@
+//+------------------------------------------------------------------+
+//|                                               import_history.cpp |
+//|        Convert MT5 "Export bars/ticks" CSV files into the store   |
+//+------------------------------------------------------------------+
+// Usage: import_history --store DIR [--symbol NAME] [--jobs N]
+//                       [--skip-bad] FILE...
+//
+// Files are read in fixed-size chunks and written straight into the
+// columnar store (store.h), so memory use does not depend on file size.
+// The kind of file is taken from the MT5 header line: <OPEN>... for M1
+// bars, <BID>/<ASK> for ticks. The symbol defaults to the file name up
+// to the first '_' or '.', e.g. BTCUSD_M1_202001020000_202412312359.csv.
+// Files of the same symbol are imported one after another in
+// name order; different symbols run in parallel on --jobs threads.
+//
+// Timestamps must increase (ticks may repeat a millisecond) within a
+// file and continue after what the store already holds. A row that
+// breaks this, or does not parse, stops the file unless --skip-bad is
+// given, in which case it is counted and dropped.
+#include "../store.h"
+#include "../terminal.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+const size_t CHUNK_SIZE = 4 << 20;
+const size_t PADDING = 16;       // zero bytes after the data for 8-byte loads
+const int    MAX_FIELDS = 16;
+
+//+------------------------------------------------------------------+
+//| Number parsing                                                   |
+//+------------------------------------------------------------------+
+// Digits are consumed eight at a time with SWAR (plain 64-bit integer
+// arithmetic on the eight characters), the usual fast path of decimal
+// parsers; prices in exports have well under 15 significant digits, so
+// mantissa / 10^fraction is exact and rounds like strtod.
+const double POW10[] =
+  {
+   1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+inline bool EightDigits(const char *p)
+  {
+   uint64_t v;
+   std::memcpy(&v, p, 8);
+   return (((v & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+  }
+
+inline uint64_t ParseEight(const char *p)
+  {
+   uint64_t v;
+   std::memcpy(&v, p, 8);
+   v -= 0x3030303030303030ULL;
+   v = (v * 10) + (v >> 8);
+   v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+        (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+   return v;
+  }
+
+//--- digits starting at p; returns the end, accumulates into mantissa
+inline const char *ParseDigits(const char *p, const char *end, uint64_t &mantissa, int &digits)
+  {
+   while(end - p >= 8 && EightDigits(p))
+     {
+      mantissa = mantissa * 100000000ULL + ParseEight(p);
+      digits += 8;
+      p += 8;
+     }
+   while(p < end && (unsigned)(*p - '0') < 10)
+     {
+      mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+      digits++;
+      p++;
+     }
+   return p;
+  }
+
+//--- false for anything but [-+]digits[.digits]; "" is reported as empty
+bool ParseNumber(const char *p, const char *end, double &value, bool &empty)
+  {
+   empty = p == end;
+   if(empty)
+      return true;
+   const char *start = p;
+   bool negative = *p == '-';
+   if(*p == '-' || *p == '+')
+      p++;
+   uint64_t mantissa = 0;
+   int      digits = 0;
+   int      fraction = 0;
+   p = ParseDigits(p, end, mantissa, digits);
+   if(p < end && *p == '.')
+     {
+      int before = digits;
+      p = ParseDigits(p + 1, end, mantissa, digits);
+      fraction = digits - before;
+     }
+   if(p != end || digits == 0)
+      return false;
+   if(digits > 19 || fraction > 22)
+     {
+      //--- too long for the fast path
+      value = std::strtod(std::string(start, end).c_str(), nullptr);
+      return true;
+     }
+   value = (double)mantissa / POW10[fraction];
+   if(negative)
+      value = -value;
+   return true;
+  }
+
+bool ParseInteger(const char *p, const char *end, long &value)
+  {
+   double v;
+   bool   empty;
+   if(!ParseNumber(p, end, v, empty))
+      return false;
+   value = empty ? 0 : (long)v;
+   return true;
+  }
+
+//--- fixed-width unsigned field, e.g. the "2024" of a date
+inline bool Fixed(const char *&p, const char *end, int width, int &value)
+  {
+   if(end - p < width)
+      return false;
+   value = 0;
+   for(int i = 0; i < width; i++, p++)
+     {
+      if((unsigned)(*p - '0') >= 10)
+         return false;
+      value = value * 10 + (*p - '0');
+     }
+   return true;
+  }
+
+//--- "YYYY.MM.DD" (any single separator) into days since 1970
+bool ParseDate(const char *&p, const char *end, long &days)
+  {
+   int y, m, d;
+   if(!Fixed(p, end, 4, y) || p == end || !(++p, Fixed(p, end, 2, m)) ||
+      p == end || !(++p, Fixed(p, end, 2, d)) || m < 1 || m > 12 || d < 1 || d > 31)
+      return false;
+   days = mql::DaysFromCivil(y, m, d);
+   return true;
+  }
+
+//--- "HH:MM[:SS[.mmm]]" into milliseconds of the day
+bool ParseClock(const char *&p, const char *end, long &msc)
+  {
+   int h, m, s = 0, ms = 0;
+   if(!Fixed(p, end, 2, h) || p == end || *p != ':' || !(++p, Fixed(p, end, 2, m)))
+      return false;
+   if(p < end && *p == ':')
+     {
+      p++;
+      if(!Fixed(p, end, 2, s))
+         return false;
+      if(p < end && *p == '.')
+        {
+         p++;
+         if(!Fixed(p, end, 3, ms))
+            return false;
+        }
+     }
+   if(h > 23 || m > 59 || s > 60)
+      return false;
+   msc = ((h * 60L + m) * 60 + s) * 1000 + ms;
+   return true;
+  }
+
+//+------------------------------------------------------------------+
+//| File layout                                                      |
+//+------------------------------------------------------------------+
+enum FileKind { KIND_UNKNOWN, KIND_BARS, KIND_TICKS };
+
+enum Column
+  {
+   COL_DATE, COL_TIME, COL_OPEN, COL_HIGH, COL_LOW, COL_CLOSE, COL_TICKVOL, COL_VOL, COL_SPREAD,
+   COL_BID, COL_ASK, COL_LAST, COL_VOLUME, COL_FLAGS, COL_COUNT
+  };
+
+struct Layout
+  {
+   FileKind          kind = KIND_UNKNOWN;
+   char              delimiter = '\t';
+   int               index[COL_COUNT];
+  };
+
+bool ParseHeader(const std::string &line, Layout &layout)
+  {
+   static const char *names[COL_COUNT] =
+     {
+      "<DATE>", "<TIME>", "<OPEN>", "<HIGH>", "<LOW>", "<CLOSE>", "<TICKVOL>", "<VOL>", "<SPREAD>",
+      "<BID>", "<ASK>", "<LAST>", "<VOLUME>", "<FLAGS>"
+     };
+   for(int &i : layout.index)
+      i = -1;
+   layout.delimiter = line.find('\t') != std::string::npos ? '\t' :
+                      line.find(';') != std::string::npos ? ';' : ',';
+   int field = 0;
+   size_t start = 0;
+   while(start <= line.size())
+     {
+      size_t stop = line.find(layout.delimiter, start);
+      if(stop == std::string::npos)
+         stop = line.size();
+      std::string name = line.substr(start, stop - start);
+      for(int c = 0; c < COL_COUNT; c++)
+         if(name == names[c])
+            layout.index[c] = field;
+      field++;
+      start = stop + 1;
+     }
+   if(layout.index[COL_DATE] < 0)
+      return false;
+   if(layout.index[COL_OPEN] >= 0 && layout.index[COL_HIGH] >= 0 && layout.index[COL_LOW] >= 0 &&
+      layout.index[COL_CLOSE] >= 0)
+      layout.kind = KIND_BARS;
+   else if(layout.index[COL_BID] >= 0 || layout.index[COL_LAST] >= 0)
+      layout.kind = KIND_TICKS;
+   return layout.kind != KIND_UNKNOWN;
+  }
+
+std::string BaseName(const std::string &path)
+  {
+   size_t slash = path.find_last_of("/\\");
+   return slash == std::string::npos ? path : path.substr(slash + 1);
+  }
+
+std::string SymbolFromName(const std::string &path)
+  {
+   std::string name = BaseName(path);
+   return name.substr(0, name.find_first_of("_."));
+  }
+
+//+------------------------------------------------------------------+
+//| One file into the store                                          |
+//+------------------------------------------------------------------+
+struct Options
+  {
+   std::string       store;
+   std::string       symbol;
+   int               jobs = 1;
+   bool              skip_bad = false;
+  };
+
+struct FileResult
+  {
+   std::string       path;
+   std::string       symbol;
+   FileKind          kind = KIND_UNKNOWN;
+   size_t            rows = 0;
+   size_t            rejected = 0;
+   size_t            bytes = 0;
+   double            seconds = 0.0;
+   std::string       error;
+  };
+
+class Importer
+  {
+public:
+                     Importer(const Options &options, FileResult &result)
+      : m_options(options), m_result(result), m_line(0), m_last_msc(0), m_bid(0.0), m_ask(0.0) {}
+   bool              Run();
+
+private:
+   bool              Row(const char *begin, const char *end);
+   bool              Bar(const char *const *field, const char *const *field_end, int fields);
+   bool              Tick(const char *const *field, const char *const *field_end, int fields);
+   bool              Time(const char *const *field, const char *const *field_end, int fields, long &msc);
+   bool              Bad(const char *what);
+
+   const Options    &m_options;
+   FileResult       &m_result;
+   Layout            m_layout;
+   size_t            m_line;
+   long              m_last_msc;
+   double            m_bid;
+   double            m_ask;
+   mql::BarWriter    m_bars;
+   mql::TickWriter   m_ticks;
+  };
+
+bool Importer::Bad(const char *what)
+  {
+   if(m_options.skip_bad)
+     {
+      m_result.rejected++;
+      return true;
+     }
+   m_result.error = "line " + std::to_string(m_line) + ": " + what;
+   return false;
+  }
+
+bool Importer::Time(const char *const *field, const char *const *field_end, int fields, long &msc)
+  {
+   int date = m_layout.index[COL_DATE];
+   int time = m_layout.index[COL_TIME];
+   if(date >= fields || time >= fields)
+      return false;
+   const char *p = field[date];
+   long days, clock = 0;
+   if(!ParseDate(p, field_end[date], days))
+      return false;
+   if(time >= 0)
+     {
+      const char *q = field[time];
+      if(!ParseClock(q, field_end[time], clock) || q != field_end[time])
+         return false;
+     }
+   else if(p < field_end[date] && (*p == ' ' || *p == 'T'))
+     {
+      p++;
+      if(!ParseClock(p, field_end[date], clock))
+         return false;
+     }
+   msc = days * 86400000L + clock;
+   return true;
+  }
+
+bool Importer::Bar(const char *const *field, const char *const *field_end, int fields)
+  {
+   long msc;
+   if(!Time(field, field_end, fields, msc))
+      return Bad("bad date/time");
+   if(msc % 60000 != 0)
+      return Bad("bar time is not on a minute boundary (M1 exports only)");
+   if(msc <= m_last_msc)
+      return Bad("bar time does not increase");
+   MqlRates bar = MqlRates();
+   bool empty;
+   const int *ix = m_layout.index;
+   auto number = [&](int col, double &v) -> bool
+     {
+      return ix[col] < fields && ParseNumber(field[ix[col]], field_end[ix[col]], v, empty) && !empty;
+     };
+   auto integer = [&](int col, long &v) -> bool
+     {
+      v = 0;
+      return ix[col] < 0 || (ix[col] < fields && ParseInteger(field[ix[col]], field_end[ix[col]], v));
+     };
+   long spread;
+   if(!number(COL_OPEN, bar.open) || !number(COL_HIGH, bar.high) || !number(COL_LOW, bar.low) ||
+      !number(COL_CLOSE, bar.close) || !integer(COL_TICKVOL, bar.tick_volume) ||
+      !integer(COL_VOL, bar.real_volume) || !integer(COL_SPREAD, spread))
+      return Bad("bad number");
+   if(bar.low > bar.high || bar.open < bar.low || bar.open > bar.high || bar.close < bar.low ||
+      bar.close > bar.high)
+      return Bad("OHLC out of range");
+   bar.time = (datetime)(msc / 1000);
+   bar.spread = (int)spread;
+   m_bars.Append(bar);
+   m_last_msc = msc;
+   m_result.rows++;
+   return true;
+  }
+
+bool Importer::Tick(const char *const *field, const char *const *field_end, int fields)
+  {
+   long msc;
+   if(!Time(field, field_end, fields, msc))
+      return Bad("bad date/time");
+   if(msc < m_last_msc)
+      return Bad("tick time goes backwards");
+   MqlTick tick = MqlTick();
+   const int *ix = m_layout.index;
+   bool   empty;
+   double v;
+   //--- MT5 leaves a price empty when it did not change
+   if(ix[COL_BID] >= 0 && ix[COL_BID] < fields)
+     {
+      if(!ParseNumber(field[ix[COL_BID]], field_end[ix[COL_BID]], v, empty))
+         return Bad("bad bid");
+      if(!empty)
+         m_bid = v;
+     }
+   if(ix[COL_ASK] >= 0 && ix[COL_ASK] < fields)
+     {
+      if(!ParseNumber(field[ix[COL_ASK]], field_end[ix[COL_ASK]], v, empty))
+         return Bad("bad ask");
+      if(!empty)
+         m_ask = v;
+     }
+   if(ix[COL_LAST] >= 0 && ix[COL_LAST] < fields)
+     {
+      if(!ParseNumber(field[ix[COL_LAST]], field_end[ix[COL_LAST]], v, empty))
+         return Bad("bad last");
+      tick.last = empty ? 0.0 : v;
+     }
+   if(ix[COL_VOLUME] >= 0 && ix[COL_VOLUME] < fields)
+     {
+      if(!ParseNumber(field[ix[COL_VOLUME]], field_end[ix[COL_VOLUME]], v, empty))
+         return Bad("bad volume");
+      tick.volume_real = empty ? 0.0 : v;
+     }
+   long flags = 0;
+   if(ix[COL_FLAGS] >= 0 && (ix[COL_FLAGS] >= fields ||
+                             !ParseInteger(field[ix[COL_FLAGS]], field_end[ix[COL_FLAGS]], flags)))
+      return Bad("bad flags");
+   if(m_bid <= 0.0 || m_ask <= 0.0)
+     {
+      //--- no complete quote yet at the start of the file
+      m_result.rejected++;
+      return true;
+     }
+   tick.time_msc = msc;
+   tick.time = (datetime)(msc / 1000);
+   tick.bid = m_bid;
+   tick.ask = m_ask;
+   tick.flags = (uint)flags;
+   m_ticks.Append(tick);
+   m_last_msc = msc;
+   m_result.rows++;
+   return true;
+  }
+
+bool Importer::Row(const char *begin, const char *end)
+  {
+   m_line++;
+   if(end > begin && end[-1] == '\r')
+      end--;
+   if(begin == end)
+      return true;
+   if(m_layout.kind == KIND_UNKNOWN)
+     {
+      std::string header(begin, end);
+      if(header.compare(0, 3, "\xEF\xBB\xBF") == 0)
+         header.erase(0, 3);
+      if(header.size() >= 2 && (unsigned char)header[0] == 0xFF && (unsigned char)header[1] == 0xFE)
+        {
+         m_result.error = "UTF-16 file, save it as UTF-8 or ANSI first";
+         return false;
+        }
+      if(!ParseHeader(header, m_layout))
+        {
+         m_result.error = "no MT5 header line (<DATE> <TIME> <OPEN>... or <BID> <ASK>...)";
+         return false;
+        }
+      m_result.kind = m_layout.kind;
+      std::string error;
+      bool opened = m_layout.kind == KIND_BARS ? m_bars.Open(m_options.store, m_result.symbol, error) :
+                    m_ticks.Open(m_options.store, m_result.symbol, error);
+      if(!opened)
+        {
+         m_result.error = error;
+         return false;
+        }
+      //--- continue after what the store already holds
+      m_last_msc = m_layout.kind == KIND_BARS ? (long)m_bars.LastTime() * 1000 : m_ticks.LastTime();
+      return true;
+     }
+   const char *field[MAX_FIELDS];
+   const char *field_end[MAX_FIELDS];
+   int fields = 0;
+   const char *p = begin;
+   while(fields < MAX_FIELDS)
+     {
+      const char *stop = (const char *)std::memchr(p, m_layout.delimiter, (size_t)(end - p));
+      field[fields] = p;
+      field_end[fields] = stop == nullptr ? end : stop;
+      fields++;
+      if(stop == nullptr)
+         break;
+      p = stop + 1;
+     }
+   return m_layout.kind == KIND_BARS ? Bar(field, field_end, fields) : Tick(field, field_end, fields);
+  }
+
+bool Importer::Run()
+  {
+   auto started = std::chrono::steady_clock::now();
+   FILE *file = std::fopen(m_result.path.c_str(), "rb");
+   if(file == nullptr)
+     {
+      m_result.error = std::strerror(errno);
+      return false;
+     }
+   std::vector<char> buffer(CHUNK_SIZE + PADDING);
+   size_t carry = 0;
+   bool   ok = true;
+   while(ok)
+     {
+      size_t read = std::fread(buffer.data() + carry, 1, CHUNK_SIZE - carry, file);
+      size_t length = carry + read;
+      m_result.bytes += read;
+      std::memset(buffer.data() + length, 0, PADDING);
+      if(length == 0)
+         break;
+      const char *data = buffer.data();
+      const char *stop = data + length;
+      //--- only complete lines, unless this is the end of the file
+      if(read > 0)
+        {
+         const char *last = stop;
+         while(last > data && last[-1] != '\n')
+            last--;
+         if(last == data)
+           {
+            if(length == CHUNK_SIZE)
+              {
+               m_result.error = "line " + std::to_string(m_line + 1) + ": line too long";
+               ok = false;
+              }
+            carry = length;
+            continue;
+           }
+         stop = last;
+        }
+      const char *line = data;
+      while(ok && line < stop)
+        {
+         const char *eol = (const char *)std::memchr(line, '\n', (size_t)(stop - line));
+         if(eol == nullptr)
+            eol = stop;
+         ok = Row(line, eol);
+         line = eol + 1;
+        }
+      if(read == 0)
+         break;
+      carry = (size_t)(data + length - stop);
+      std::memmove(buffer.data(), stop, carry);
+     }
+   std::fclose(file);
+   if(ok && m_layout.kind == KIND_UNKNOWN)
+     {
+      m_result.error = "empty file";
+      ok = false;
+     }
+   //--- rows before an error stay in the store; they passed validation
+   bool closed = m_layout.kind == KIND_BARS ? m_bars.Close() : m_ticks.Close();
+   if(ok && !closed)
+     {
+      m_result.error = "write error";
+      ok = false;
+     }
+   m_result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+   return ok;
+  }
+
+void Usage()
+  {
+   std::fprintf(stderr, "usage: import_history --store DIR [--symbol NAME] [--jobs N] [--skip-bad] FILE...\n");
+  }
+}
+
+int main(int argc, char **argv)
+  {
+   Options options;
+   std::vector<std::string> paths;
+   for(int i = 1; i < argc; i++)
+     {
+      std::string arg = argv[i];
+      if((arg == "--store" || arg == "--symbol" || arg == "--jobs") && i + 1 >= argc)
+        {
+         Usage();
+         return 2;
+        }
+      if(arg == "--store")
+         options.store = argv[++i];
+      else if(arg == "--symbol")
+         options.symbol = argv[++i];
+      else if(arg == "--jobs")
+         options.jobs = std::max(1, std::atoi(argv[++i]));
+      else if(arg == "--skip-bad")
+         options.skip_bad = true;
+      else if(arg.compare(0, 2, "--") == 0)
+        {
+         Usage();
+         return 2;
+        }
+      else
+         paths.push_back(arg);
+     }
+   if(options.store.empty() || paths.empty())
+     {
+      Usage();
+      return 2;
+     }
+
+   //--- one group per symbol: a symbol's files are imported in name
+   //--- order by a single thread, so its store is appended in sequence
+   std::map<std::string, std::vector<size_t>> groups;
+   std::vector<FileResult> results(paths.size());
+   std::sort(paths.begin(), paths.end(),
+             [](const std::string &a, const std::string &b) { return BaseName(a) < BaseName(b); });
+   for(size_t i = 0; i < paths.size(); i++)
+     {
+      results[i].path = paths[i];
+      results[i].symbol = options.symbol.empty() ? SymbolFromName(paths[i]) : options.symbol;
+      groups[results[i].symbol].push_back(i);
+     }
+   std::vector<const std::vector<size_t> *> queue;
+   for(const auto &group : groups)
+      queue.push_back(&group.second);
+
+   auto started = std::chrono::steady_clock::now();
+   std::atomic<size_t> next(0);
+   std::mutex output;
+   auto worker = [&]()
+     {
+      for(size_t g = next++; g < queue.size(); g = next++)
+         for(size_t index : *queue[g])
+           {
+            FileResult &r = results[index];
+            Importer(options, r).Run();
+            std::lock_guard<std::mutex> lock(output);
+            if(!r.error.empty())
+               std::fprintf(stderr, "%s: %s\n", r.path.c_str(), r.error.c_str());
+            std::printf("%-10s %-5s %12zu rows %8zu rejected %9.1f MB %7.2f s %8.1f MB/s  %s\n",
+                        r.symbol.c_str(), r.kind == KIND_BARS ? "M1" : r.kind == KIND_TICKS ? "ticks" : "-",
+                        r.rows, r.rejected, r.bytes / 1048576.0, r.seconds,
+                        r.seconds > 0 ? r.bytes / 1048576.0 / r.seconds : 0.0, BaseName(r.path).c_str());
+           }
+     };
+   std::vector<std::thread> threads;
+   int jobs = std::min<int>(options.jobs, (int)queue.size());
+   for(int i = 1; i < jobs; i++)
+      threads.emplace_back(worker);
+   worker();
+   for(std::thread &t : threads)
+      t.join();
+
+   size_t bytes = 0, failed = 0;
+   for(const FileResult &r : results)
+     {
+      bytes += r.bytes;
+      failed += r.error.empty() ? 0 : 1;
+     }
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+   std::printf("%zu files, %.1f MB in %.2f s (%.1f MB/s), %zu failed\n", paths.size(), bytes / 1048576.0,
+               seconds, seconds > 0 ? bytes / 1048576.0 / seconds : 0.0, failed);
+   return failed > 0 ? 1 : 0;
+  }
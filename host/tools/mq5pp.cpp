@@ -0,0 +1,423 @@
+//+------------------------------------------------------------------+
+//|                                                        mq5pp.cpp |
+//|            Translate an MQL5 expert into a C++ class for the host |
+//+------------------------------------------------------------------+
+// Usage: mq5pp <expert source> <output.cpp> [registry name]
+//
+// The translation is deliberately shallow; everything else is handled
+// by mql5.h:
+//   - #property and "input group" lines are blanked (line numbers kept),
+//   - "input"/"sinput" is dropped and the parameter recorded so the host
+//     can set it by name, top-level "static" is dropped and arithmetic
+//     top-level constants become "static constexpr",
+//   - dynamic arrays "T a[]" / "T &a[]" become mql::array<T>,
+//   - "literal" + "literal" becomes adjacent literals,
+//   - local includes (#include "x.mqh") are inlined into the class once
+//     per file, as the MQL5 compiler does; other includes are hoisted,
+//   - the whole source is placed inside a class derived from
+//     mql::Expert, which gives MQL5's call-before-definition semantics.
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Input
+  {
+   std::string type;
+   std::string name;
+  };
+
+struct Enum
+  {
+   std::string name;
+   std::vector<std::string> values;
+  };
+
+//--- replace '+' between two string literals with a blank
+void MergeLiteralConcatenation(std::string &src)
+  {
+   size_t n = src.size();
+   size_t i = 0;
+   while(i < n)
+     {
+      char c = src[i];
+      if(c == '/' && i + 1 < n && src[i + 1] == '/')
+        {
+         while(i < n && src[i] != '\n')
+            i++;
+         continue;
+        }
+      if(c == '/' && i + 1 < n && src[i + 1] == '*')
+        {
+         size_t end = src.find("*/", i + 2);
+         i = (end == std::string::npos) ? n : end + 2;
+         continue;
+        }
+      if(c == '\'')
+        {
+         i++;
+         while(i < n && src[i] != '\'')
+            i += (src[i] == '\\') ? 2 : 1;
+         i++;
+         continue;
+        }
+      if(c != '"')
+        {
+         i++;
+         continue;
+        }
+      i++;
+      while(i < n && src[i] != '"')
+         i += (src[i] == '\\') ? 2 : 1;
+      i++;
+      size_t j = i;
+      while(j < n && std::isspace((unsigned char)src[j]))
+         j++;
+      if(j < n && src[j] == '+')
+        {
+         size_t k = j + 1;
+         while(k < n && std::isspace((unsigned char)src[k]))
+            k++;
+         if(k < n && src[k] == '"')
+            src[j] = ' ';
+        }
+     }
+  }
+
+//--- brace depth change over one line, ignoring strings and comments;
+//--- "in_block" carries an open /* */ comment across lines
+int BraceDelta(const std::string &line, bool &in_block)
+  {
+   int delta = 0;
+   for(size_t i = 0; i < line.size(); i++)
+     {
+      char c = line[i];
+      if(in_block)
+        {
+         if(c == '*' && i + 1 < line.size() && line[i + 1] == '/')
+           {
+            in_block = false;
+            i++;
+           }
+         continue;
+        }
+      if(c == '/' && i + 1 < line.size() && line[i + 1] == '/')
+         break;
+      if(c == '/' && i + 1 < line.size() && line[i + 1] == '*')
+        {
+         in_block = true;
+         i++;
+         continue;
+        }
+      if(c == '"' || c == '\'')
+        {
+         char quote = c;
+         for(i++; i < line.size() && line[i] != quote; i++)
+            if(line[i] == '\\')
+               i++;
+         continue;
+        }
+      if(c == '{')
+         delta++;
+      else if(c == '}')
+         delta--;
+     }
+   return delta;
+  }
+
+std::string StripComments(const std::string &text)
+  {
+   std::string out;
+   for(size_t i = 0; i < text.size(); i++)
+     {
+      if(text[i] == '/' && i + 1 < text.size() && text[i + 1] == '/')
+        {
+         while(i < text.size() && text[i] != '\n')
+            i++;
+         out += '\n';
+         continue;
+        }
+      if(text[i] == '/' && i + 1 < text.size() && text[i + 1] == '*')
+        {
+         size_t end = text.find("*/", i + 2);
+         i = (end == std::string::npos) ? text.size() : end + 1;
+         out += ' ';
+         continue;
+        }
+      out += text[i];
+     }
+   return out;
+  }
+
+Enum ParseEnum(const std::string &name, const std::string &text)
+  {
+   Enum e;
+   e.name = name;
+   std::string body = StripComments(text);
+   size_t open = body.find('{');
+   size_t close = body.rfind('}');
+   if(open == std::string::npos || close == std::string::npos || close < open)
+      return e;
+   std::stringstream items(body.substr(open + 1, close - open - 1));
+   std::string item;
+   static const std::regex ident("^\\s*([A-Za-z_]\\w*)");
+   while(std::getline(items, item, ','))
+     {
+      std::smatch m;
+      if(std::regex_search(item, m, ident))
+         e.values.push_back(m[1]);
+     }
+   return e;
+  }
+
+bool IsKeyword(const std::string &word)
+  {
+   static const char *keywords[] = {"return", "else", "delete", "new", "case", "goto", "throw", "sizeof"};
+   for(const char *k : keywords)
+      if(word == k)
+         return true;
+   return false;
+  }
+
+//--- "T a[], b[];" -> "mql::array<T> a, b;" and "T &a[]" -> "mql::array<T> &a"
+std::string ConvertArrays(const std::string &line)
+  {
+   static const std::regex param("\\b(const\\s+)?([A-Za-z_][\\w:]*)\\s*&\\s*([A-Za-z_]\\w*)\\s*\\[\\s*\\]");
+   std::string out = std::regex_replace(line, param, "$1mql::array<$2> &$3");
+
+   static const std::regex decl("(^|[;{])(\\s*)((?:static\\s+|const\\s+)*)([A-Za-z_][\\w:]*)\\s+"
+                                "([A-Za-z_]\\w*\\s*\\[\\s*\\](?:\\s*,\\s*[A-Za-z_]\\w*\\s*\\[\\s*\\])*)"
+                                "(\\s*(?:=\\s*\\{[^;]*\\})?\\s*;)");
+   static const std::regex brackets("\\s*\\[\\s*\\]");
+   std::string result;
+   auto begin = std::sregex_iterator(out.begin(), out.end(), decl);
+   auto end = std::sregex_iterator();
+   size_t last = 0;
+   for(auto it = begin; it != end; ++it)
+     {
+      const std::smatch &m = *it;
+      if(IsKeyword(m[4]))
+         continue;
+      result += out.substr(last, (size_t)m.position(0) - last);
+      result += m[1].str() + m[2].str() + m[3].str() + "mql::array<" + m[4].str() + "> " +
+                std::regex_replace(m[5].str(), brackets, "") + m[6].str();
+      last = (size_t)(m.position(0) + m.length(0));
+     }
+   result += out.substr(last);
+   return result;
+  }
+
+std::string Sanitize(const std::string &name)
+  {
+   std::string out;
+   for(char c : name)
+      out += std::isalnum((unsigned char)c) ? c : '_';
+   if(out.empty() || std::isdigit((unsigned char)out[0]))
+      out = "_" + out;
+   return out;
+  }
+
+std::string BaseName(const std::string &path)
+  {
+   size_t slash = path.find_last_of("/\\");
+   std::string base = (slash == std::string::npos) ? path : path.substr(slash + 1);
+   size_t dot = base.find_last_of('.');
+   return (dot == std::string::npos) ? base : base.substr(0, dot);
+  }
+
+//+------------------------------------------------------------------+
+//| Translation of one source file (the expert or an included .mqh)  |
+//+------------------------------------------------------------------+
+struct Translation
+  {
+   std::vector<Input> inputs;
+   std::vector<Enum> enums;
+   std::vector<std::string> includes;
+   std::vector<std::string> included;    // local .mqh files already inlined
+   std::string body;
+  };
+
+std::string DirName(const std::string &path)
+  {
+   size_t slash = path.find_last_of("/\\");
+   return (slash == std::string::npos) ? std::string() : path.substr(0, slash + 1);
+  }
+
+bool ReadSource(const std::string &path, std::string &src)
+  {
+   std::ifstream in(path, std::ios::binary);
+   if(!in)
+      return false;
+   std::stringstream buffer;
+   buffer << in.rdbuf();
+   src = buffer.str();
+   if(src.compare(0, 3, "\xEF\xBB\xBF") == 0)
+      src.erase(0, 3);
+   src.erase(std::remove(src.begin(), src.end(), '\r'), src.end());
+   MergeLiteralConcatenation(src);
+   return true;
+  }
+
+//--- local includes (#include "x.mqh") are inlined like the MQL5 compiler
+//--- does, once per file; other includes are hoisted above the class
+bool Translate(const std::string &path, Translation &t)
+  {
+   std::string src;
+   if(!ReadSource(path, src))
+     {
+      std::fprintf(stderr, "mq5pp: cannot read %s\n", path.c_str());
+      return false;
+     }
+
+   static const std::regex property_re("^\\s*#property\\b.*");
+   static const std::regex group_re("^\\s*s?input\\s+group\\b.*");
+   static const std::regex input_re("^(\\s*)s?input\\s+((?:const\\s+)?([A-Za-z_]\\w*)\\s+([A-Za-z_]\\w*).*)");
+   static const std::regex static_re("^(\\s*)static\\s+");
+   static const std::regex const_re("^(\\s*)const\\s+(int|uint|long|ulong|short|ushort|char|uchar|double|float|bool|datetime|color)\\s+");
+   static const std::regex enum_re("^\\s*enum\\s+([A-Za-z_]\\w*)");
+   static const std::regex include_re("^\\s*#include\\b.*");
+   static const std::regex local_include_re("^\\s*#include\\s+\"([^\"]+\\.mqh)\".*");
+
+   std::stringstream lines(src);
+   std::string line;
+   int  depth = 0;
+   bool in_block = false;
+   int  line_count = 0;
+   std::string enum_name;
+   std::string enum_text;
+   while(std::getline(lines, line))
+     {
+      line_count++;
+      bool at_top = (depth == 0 && !in_block);
+      std::smatch m;
+      if(at_top)
+        {
+         if(std::regex_match(line, m, local_include_re))
+           {
+            std::string file = DirName(path) + m[1].str();
+            if(std::find(t.included.begin(), t.included.end(), file) == t.included.end())
+              {
+               t.included.push_back(file);
+               t.body += "#line 1 \"" + file + "\"\n";
+               if(!Translate(file, t))
+                  return false;
+              }
+            t.body += "#line " + std::to_string(line_count + 1) + " \"" + path + "\"\n";
+            continue;
+           }
+         if(std::regex_match(line, property_re) || std::regex_match(line, group_re))
+            line.clear();
+         else if(std::regex_match(line, include_re))
+           {
+            t.includes.push_back(line);
+            line.clear();
+           }
+         else if(std::regex_match(line, m, input_re))
+           {
+            t.inputs.push_back(Input{m[3], m[4]});
+            line = m[1].str() + m[2].str();
+           }
+         else if(std::regex_search(line, m, static_re))
+            line = m[1].str() + line.substr((size_t)m.length(0));
+         else if(std::regex_search(line, m, const_re))
+            line = m[1].str() + "static constexpr " + m[2].str() + " " + line.substr((size_t)m.length(0));
+         if(std::regex_search(line, m, enum_re))
+           {
+            enum_name = m[1];
+            enum_text.clear();
+           }
+        }
+      line = ConvertArrays(line);
+      if(!enum_name.empty())
+        {
+         enum_text += line + "\n";
+         if(enum_text.find('}') != std::string::npos)
+           {
+            t.enums.push_back(ParseEnum(enum_name, enum_text));
+            enum_name.clear();
+           }
+        }
+      depth += BraceDelta(line, in_block);
+      t.body += line + "\n";
+     }
+   return true;
+  }
+}
+
+int main(int argc, char **argv)
+  {
+   if(argc < 3)
+     {
+      std::fprintf(stderr, "usage: %s <expert source> <output.cpp> [registry name]\n", argv[0]);
+      return 2;
+     }
+   std::string input_path = argv[1];
+   std::string output_path = argv[2];
+   std::string name = argc > 3 ? argv[3] : BaseName(input_path);
+
+   Translation t;
+   if(!Translate(input_path, t))
+      return 1;
+   const std::vector<Input> &inputs = t.inputs;
+   const std::vector<Enum> &enums = t.enums;
+
+   std::string ns = "ea_" + Sanitize(name);
+   std::ostringstream out;
+   out << "// Generated by mq5pp from " << input_path << ". Do not edit.\n"
+       << "#include \"mql5.h\"\n"
+       << "#include \"expert.h\"\n";
+   for(const std::string &inc : t.includes)
+      out << inc << "\n";
+   out << "#include \"mql5_predefined.h\"\n";
+   out << "\nnamespace " << ns << "\n{\n"
+       << "class Program : public mql::Expert\n  {\npublic:\n"
+       << "#line 1 \"" << input_path << "\"\n"
+       << t.body;
+
+   std::ostringstream tail;
+   tail << "   bool SetInput(const std::string &name, const std::string &value) override\n     {\n";
+   for(const Input &i : inputs)
+      tail << "      if(name == \"" << i.name << "\")\n         return mql::ParseInput(" << i.name << ", value);\n";
+   tail << "      return false;\n     }\n\n";
+   tail << "   void ListInputs(std::vector<std::pair<std::string, std::string>> &inputs) const override\n     {\n";
+   for(const Input &i : inputs)
+      tail << "      inputs.emplace_back(\"" << i.name << "\", mql::FormatInput(" << i.name << "));\n";
+   if(inputs.empty())
+      tail << "      (void)inputs;\n";
+   tail << "     }\n";
+   for(const Enum &e : enums)
+     {
+      tail << "\n   friend string EnumToString(" << e.name << " v)\n     {\n";
+      for(const std::string &v : e.values)
+         tail << "      if(v == " << v << ")\n         return \"" << v << "\";\n";
+      tail << "      return std::to_string((int)v);\n     }\n";
+     }
+   tail << "  };\n}\n\n"
+        << "namespace\n{\n"
+        << "std::unique_ptr<mql::Expert> Create()\n  {\n"
+        << "   return std::unique_ptr<mql::Expert>(new " << ns << "::Program());\n  }\n\n"
+        << "const mql::ExpertRegistration registration(\"" << name << "\", Create);\n"
+        << "}\n";
+
+   //--- point diagnostics in the generated tail at the output file
+   int generated_line = 0;
+   for(char c : out.str())
+      generated_line += (c == '\n');
+   out << "#line " << generated_line + 2 << " \"" << output_path << "\"\n" << tail.str();
+
+   std::ofstream file(output_path, std::ios::binary);
+   if(!file)
+     {
+      std::fprintf(stderr, "mq5pp: cannot write %s\n", output_path.c_str());
+      return 1;
+     }
+   file << out.str();
+   return 0;
+  }
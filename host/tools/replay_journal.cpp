@@ -0,0 +1,152 @@
+//+------------------------------------------------------------------+
+//|                                               replay_journal.cpp |
+//|       Print a StateJournal file and the position book it rebuilds |
+//+------------------------------------------------------------------+
+// Usage: replay_journal [--ticket N] [--book] FILE...
+//
+// FILE is a journal written by StateJournal.mqh (e.g. btc_journal_*.bin
+// from the expert's files directory, see ea_host --files). Every record
+// is printed in order, as the audit trail of what the expert did to its
+// positions, then the book as the expert finds it on its next start:
+// the latest record of every position without a JOURNAL_CLOSE. --ticket
+// keeps one position, --book prints the book only. A torn record at the
+// end (crash while writing) is reported and ignored, as Open() does.
+//
+// The record layout and event codes mirror StateJournal.mqh.
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+
+namespace
+{
+struct Record
+  {
+   uint64_t          seq;
+   int64_t           time;
+   uint64_t          ticket;
+   int32_t           event;
+   int32_t           flags;
+   double            volume;
+   double            sl;
+   double            tp;
+   double            aux1;
+   double            aux2;
+  };
+static_assert(sizeof(Record) == 72, "journal record layout");
+
+const int JOURNAL_VERSION = 1;
+const int JOURNAL_HEADER = 0;
+const int JOURNAL_CLOSE = 5;
+const char *const EVENTS[] = {"header", "open", "take-profit", "breakeven", "trailing", "close", "snapshot"};
+
+void Usage()
+  {
+   std::fprintf(stderr, "usage: replay_journal [--ticket N] [--book] FILE...\n");
+  }
+
+std::string Time(int64_t time)
+  {
+   std::time_t t = (std::time_t)time;
+   std::tm tm;
+   gmtime_r(&t, &tm);
+   char text[32];
+   std::strftime(text, sizeof(text), "%Y.%m.%d %H:%M:%S", &tm);
+   return text;
+  }
+
+const char *EventName(int event)
+  {
+   return event >= 0 && event < (int)(sizeof(EVENTS) / sizeof(EVENTS[0])) ? EVENTS[event] : "?";
+  }
+
+void Print(const Record &r)
+  {
+   std::printf("%8lu  %s  #%-10lu %-11s flags 0x%02x  volume %-8.2f sl %-12.5f tp %-12.5f aux %g / %g\n",
+               (unsigned long)r.seq, Time(r.time).c_str(), (unsigned long)r.ticket, EventName(r.event), r.flags,
+               r.volume, r.sl, r.tp, r.aux1, r.aux2);
+  }
+
+//--- 0 = ok, 1 = damaged
+int Replay(const char *path, uint64_t ticket, bool book_only)
+  {
+   std::FILE *file = std::fopen(path, "rb");
+   if(file == nullptr)
+     {
+      std::fprintf(stderr, "%s: cannot open\n", path);
+      return 1;
+     }
+   Record header;
+   if(std::fread(&header, sizeof(header), 1, file) != 1 || header.event != JOURNAL_HEADER || (int)header.aux1 != JOURNAL_VERSION)
+     {
+      std::fprintf(stderr, "%s: not a state journal (version %d)\n", path, JOURNAL_VERSION);
+      std::fclose(file);
+      return 1;
+     }
+   std::printf("%s: magic %lu, started %s\n", path, (unsigned long)header.ticket, Time(header.time).c_str());
+
+   std::map<uint64_t, Record> positions;
+   Record   r;
+   size_t   records = 0;
+   size_t   n;
+   while((n = std::fread(&r, 1, sizeof(r), file)) == sizeof(r))
+     {
+      records++;
+      if(ticket != 0 && r.ticket != ticket)
+         continue;
+      if(!book_only)
+         Print(r);
+      if(r.event == JOURNAL_CLOSE)
+         positions.erase(r.ticket);
+      else
+         positions[r.ticket] = r;
+     }
+   std::fclose(file);
+   int result = 0;
+   if(n != 0)
+     {
+      std::fprintf(stderr, "%s: torn record after %zu records (%zu bytes), ignored\n", path, records, n);
+      result = 1;
+     }
+
+   std::printf("book: %zu open positions after %zu records\n", positions.size(), records);
+   for(const auto &kv : positions)
+      Print(kv.second);
+   return result;
+  }
+}
+
+int main(int argc, char **argv)
+  {
+   uint64_t ticket = 0;
+   bool     book_only = false;
+   int      files = 0;
+   int      result = 0;
+   for(int i = 1; i < argc; i++)
+     {
+      std::string arg = argv[i];
+      if(arg == "--ticket" && i + 1 < argc)
+         ticket = std::strtoull(argv[++i], nullptr, 10);
+      else if(arg == "--book")
+         book_only = true;
+      else if(arg.compare(0, 2, "--") == 0)
+        {
+         Usage();
+         return 2;
+        }
+      else
+        {
+         result |= Replay(argv[i], ticket, book_only);
+         files++;
+        }
+     }
+   if(files == 0)
+     {
+      Usage();
+      return 2;
+     }
+   return result;
+  }